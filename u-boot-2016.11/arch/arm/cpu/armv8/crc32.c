@@ -0,0 +1,32 @@
+/*
+ * CRC32 using the ARMv8 CRC32 instructions
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/crc.h>
+#include <arm_acle.h>
+
+/*
+ * As with the SHA code, the ID register is read on every call since this
+ * may run before relocation. CRC32X consumes eight bytes per instruction,
+ * so the buffer is first aligned to eight bytes.
+ */
+uint32_t crc32_no_comp_armv8(uint32_t crc, const unsigned char *p, uint len)
+{
+	if (!ID_AA64ISAR0_FIELD(read_id_aa64isar0(), ID_AA64ISAR0_CRC32_SHIFT))
+		return crc32_no_comp_generic(crc, p, len);
+
+	for (; len && ((uintptr_t)p & 7); len--)
+		crc = __crc32b(crc, *p++);
+
+	for (; len >= 8; len -= 8, p += 8)
+		crc = __crc32d(crc, *(const uint64_t *)p);
+
+	for (; len; len--)
+		crc = __crc32b(crc, *p++);
+
+	return crc;
+}
@@ -0,0 +1,75 @@
+/*
+ * SHA-1 using the ARMv8 Cryptography Extensions
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha1.h>
+#include <arm_neon.h>
+
+/*
+ * The ID register is read on every call rather than cached, since this may
+ * run before relocation when there is nowhere writable to keep the answer.
+ */
+void sha1_blocks_ce(uint32_t state[5], const unsigned char *data,
+		    unsigned int blocks)
+{
+	uint32x4_t abcd, abcd0, wk, k, next;
+	uint32x4_t m0, m1, m2, m3;
+	uint32_t e, e0, e1;
+	int i;
+
+	if (!ID_AA64ISAR0_FIELD(read_id_aa64isar0(), ID_AA64ISAR0_SHA1_SHIFT)) {
+		sha1_blocks_generic(state, data, blocks);
+		return;
+	}
+
+	abcd = vld1q_u32(&state[0]);
+	e = state[4];
+
+	for (; blocks; blocks--, data += 64) {
+		m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+		m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+		m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+		m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+		abcd0 = abcd;
+		e0 = e;
+
+		/* four rounds per step, extending the schedule as we go */
+		for (i = 0; i < 20; i++) {
+			if (i < 5)
+				k = vdupq_n_u32(0x5A827999);
+			else if (i < 10)
+				k = vdupq_n_u32(0x6ED9EBA1);
+			else if (i < 15)
+				k = vdupq_n_u32(0x8F1BBCDC);
+			else
+				k = vdupq_n_u32(0xCA62C1D6);
+			wk = vaddq_u32(m0, k);
+			next = i < 16 ? vsha1su1q_u32(vsha1su0q_u32(m0, m1, m2),
+						      m3) : m0;
+
+			e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+			if (i < 5)
+				abcd = vsha1cq_u32(abcd, e, wk);
+			else if (i >= 10 && i < 15)
+				abcd = vsha1mq_u32(abcd, e, wk);
+			else
+				abcd = vsha1pq_u32(abcd, e, wk);
+			e = e1;
+
+			m0 = m1;
+			m1 = m2;
+			m2 = m3;
+			m3 = next;
+		}
+
+		abcd = vaddq_u32(abcd, abcd0);
+		e += e0;
+	}
+
+	vst1q_u32(&state[0], abcd);
+	state[4] = e;
+}
@@ -0,0 +1,78 @@
+/*
+ * SHA-256 using the ARMv8 Cryptography Extensions
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha256.h>
+#include <arm_neon.h>
+
+static const uint32_t sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+	0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+	0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+	0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+	0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+	0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+	0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+	0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+	0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+/*
+ * The ID register is read on every call rather than cached, since this may
+ * run before relocation when there is nowhere writable to keep the answer.
+ */
+void sha256_blocks_ce(uint32_t state[8], const uint8_t *data,
+		      unsigned int blocks)
+{
+	uint32x4_t abcd, efgh, abcd0, efgh0, wk, tmp, next;
+	uint32x4_t m0, m1, m2, m3;
+	int i;
+
+	if (!ID_AA64ISAR0_FIELD(read_id_aa64isar0(), ID_AA64ISAR0_SHA2_SHIFT)) {
+		sha256_blocks_generic(state, data, blocks);
+		return;
+	}
+
+	abcd = vld1q_u32(&state[0]);
+	efgh = vld1q_u32(&state[4]);
+
+	for (; blocks; blocks--, data += 64) {
+		m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+		m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+		m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+		m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+		abcd0 = abcd;
+		efgh0 = efgh;
+
+		/* four rounds per step, extending the schedule as we go */
+		for (i = 0; i < 16; i++) {
+			wk = vaddq_u32(m0, vld1q_u32(&sha256_k[i * 4]));
+			next = i < 12 ? vsha256su1q_u32(vsha256su0q_u32(m0, m1),
+							m2, m3) : m0;
+			tmp = abcd;
+			abcd = vsha256hq_u32(abcd, efgh, wk);
+			efgh = vsha256h2q_u32(efgh, tmp, wk);
+			m0 = m1;
+			m1 = m2;
+			m2 = m3;
+			m3 = next;
+		}
+
+		abcd = vaddq_u32(abcd, abcd0);
+		efgh = vaddq_u32(efgh, efgh0);
+	}
+
+	vst1q_u32(&state[0], abcd);
+	vst1q_u32(&state[4], efgh);
+}
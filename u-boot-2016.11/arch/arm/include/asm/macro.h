@@ -231,6 +231,16 @@ lr	.req	x30
 .endm
 #endif
 
+/*
+ * Swap a word loaded from memory into little-endian order, or back again
+ * before it is stored. Does nothing on little-endian builds.
+ */
+.macro	le64, xreg
+#ifdef __AARCH64EB__
+	rev	\xreg, \xreg
+#endif
+.endm
+
 #endif /* CONFIG_ARM64 */
 
 #endif /* __ASSEMBLY__ */
@@ -86,6 +86,21 @@ static inline unsigned long read_mpidr(void)
 	return val;
 }
 
+/* ID_AA64ISAR0_EL1 fields for the optional instruction set extensions */
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_CRC32_SHIFT	16
+#define ID_AA64ISAR0_FIELD(val, shift)	(((val) >> (shift)) & 0xf)
+
+static inline unsigned long read_id_aa64isar0(void)
+{
+	unsigned long val;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (val));
+
+	return val;
+}
+
 #define BSP_COREID	0
 
 void __asm_flush_dcache_all(void);
@@ -4,6 +4,7 @@
  */
 #define DEBUG
 #include <common.h>
+#include <cpu_work.h>
 #include <errno.h>
 #include <libfdt.h>
 #include <os.h>
@@ -45,6 +46,48 @@ void __udelay(unsigned long usec)
 		os_usleep(usec);
 }
 
+#ifdef CONFIG_CPU_WORK
+/* Secondary CPUs are emulated with host threads */
+struct sandbox_cpu_work {
+	void *thread;
+	cpu_work_func func;
+	void *arg;
+	int cpu;
+};
+
+static struct sandbox_cpu_work cpu_work[CPU_WORK_MAX_CPUS];
+
+static void *sandbox_cpu_work_thread(void *data)
+{
+	struct sandbox_cpu_work *work = data;
+
+	work->func(work->arg, work->cpu);
+
+	return NULL;
+}
+
+int arch_cpu_work_cpus(void)
+{
+	return CPU_WORK_MAX_CPUS;
+}
+
+int arch_cpu_work_start(int cpu, cpu_work_func func, void *arg)
+{
+	struct sandbox_cpu_work *work = &cpu_work[cpu];
+
+	work->func = func;
+	work->arg = arg;
+	work->cpu = cpu;
+
+	return os_thread_create(&work->thread, sandbox_cpu_work_thread, work);
+}
+
+void arch_cpu_work_wait(int cpu)
+{
+	os_thread_join(cpu_work[cpu].thread);
+}
+#endif
+
 int cleanup_before_linux(void)
 {
 	return 0;
@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -620,3 +621,21 @@ void os_localtime(struct rtc_time *rt)
 	rt->tm_yday = tm->tm_yday;
 	rt->tm_isdst = tm->tm_isdst;
 }
+
+int os_thread_create(void **threadp, void *(*func)(void *arg), void *arg)
+{
+	pthread_t thread;
+	int ret;
+
+	ret = pthread_create(&thread, NULL, func, arg);
+	if (ret)
+		return -ret;
+	*threadp = (void *)thread;
+
+	return 0;
+}
+
+void os_thread_join(void *thread)
+{
+	pthread_join((pthread_t)thread, NULL);
+}
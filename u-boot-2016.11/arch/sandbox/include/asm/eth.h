@@ -14,4 +14,10 @@ void sandbox_eth_disable_response(int index, bool disable);
 
 void sandbox_eth_skip_timeout(void);
 
+void sandbox_eth_tftp_serve(const void *data, int size, int drop_block);
+
+int sandbox_eth_tftp_windowsize(void);
+
+int sandbox_eth_tftp_acks(void);
+
 #endif /* __ETH_H */
@@ -79,4 +79,62 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_mmc_get_cmd_count() - Find out how often a command has been sent
+ *
+ * @dev:	MMC device to check
+ * @cmdidx:	Command index (MMC_CMD_...)
+ * @return number of times the command has been sent since the device was
+ * probed or the counts were last reset
+ */
+uint sandbox_mmc_get_cmd_count(struct udevice *dev, uint cmdidx);
+
+/**
+ * sandbox_mmc_reset_cmd_counts() - Set all command counts back to zero
+ *
+ * @dev:	MMC device to adjust
+ */
+void sandbox_mmc_reset_cmd_counts(struct udevice *dev);
+
+/**
+ * sandbox_mmc_set_powerup() - Set how long the card takes to power up
+ *
+ * @dev:	MMC device to adjust
+ * @acmds:	Number of ACMD41s answered with 'busy' after each reset
+ */
+void sandbox_mmc_set_powerup(struct udevice *dev, uint acmds);
+
+/**
+ * sandbox_mmc_set_fail_cmd() - Make a command fail, or work again
+ *
+ * @dev:	MMC device to adjust
+ * @cmdidx:	Command index (MMC_CMD_...), below 64
+ * @fail:	true to make the command fail with -EIO, false to undo that
+ */
+void sandbox_mmc_set_fail_cmd(struct udevice *dev, uint cmdidx, bool fail);
+
+/**
+ * sandbox_spi_set_mmap() - Map the flash on a chip select into memory
+ *
+ * The window is read from the flash each time a mapped access starts.
+ * Devices already probed keep the settings they found.
+ *
+ * @bus:	SPI bus to adjust
+ * @cs:		Chip select to map
+ * @size:	Size of the window in bytes, at most 16MiB, or 0 for none
+ * @return 0 if OK, -ve on error
+ */
+int sandbox_spi_set_mmap(struct udevice *bus, uint cs, uint size);
+
+/**
+ * sandbox_spi_set_max_read_size() - Limit the length of reads
+ *
+ * Longer reads fail with -EMSGSIZE. The limit is given to devices as they
+ * are probed, in their struct spi_slave.
+ *
+ * @bus:	SPI bus to adjust
+ * @size:	Maximum number of bytes in a read, or 0 for no limit
+ */
+void sandbox_spi_set_max_read_size(struct udevice *bus, uint size);
+
 #endif
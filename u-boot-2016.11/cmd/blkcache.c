@@ -10,6 +10,14 @@
 #include <malloc.h>
 #include <part.h>
 
+static void blkc_show_dev(struct block_cache_dev_stats *dev)
+{
+	printf("if_type %d dev %d: hits %u, misses %u, device reads %u "
+	       "(%lu blocks), read-aheads %u\n",
+	       dev->iftype, dev->devnum, dev->hits, dev->misses,
+	       dev->reads, dev->blocks, dev->readaheads);
+}
+
 static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
@@ -19,31 +27,48 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 	printf("hits: %u\n"
 	       "misses: %u\n"
 	       "entries: %u\n"
-	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "bytes: %u\n"
+	       "max bytes: %u\n"
+	       "max blocks/read: %u\n"
+	       "read-ahead blocks: %u\n",
+	       stats.hits, stats.misses, stats.entries, stats.bytes,
+	       stats.max_bytes, stats.max_blocks_per_read, stats.readahead);
+	blkcache_dev_stats(blkc_show_dev);
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
+	unsigned max_bytes, blocks_per_read;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
-	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	max_bytes = simple_strtoul(argv[1], 0, 0);
+	blocks_per_read = simple_strtoul(argv[2], 0, 0);
+	blkcache_configure(max_bytes, blocks_per_read);
+	printf("changed to max of %u bytes, reads of up to %u blocks\n",
+	       max_bytes, blocks_per_read);
+	return 0;
+}
+
+static int blkc_readahead(cmd_tbl_t *cmdtp, int flag,
+			  int argc, char * const argv[])
+{
+	unsigned blocks;
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	blocks = simple_strtoul(argv[1], 0, 0);
+	blkcache_set_readahead(blocks);
+	printf("read-ahead set to %u blocks\n", blocks);
 	return 0;
 }
 
 static cmd_tbl_t cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
 	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(readahead, 2, 0, blkc_readahead, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -83,5 +108,6 @@ U_BOOT_CMD(
 	blkcache, 4, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure bytes blocks - set cache size and largest read cached\n"
+	"blkcache readahead blocks - set read-ahead window (0 to disable)\n"
 );
@@ -20,6 +20,13 @@ static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
+#ifdef CONFIG_HASH_STREAM
+	if (argc > 1 && !strcmp(argv[1], "-l")) {
+		flags |= HASH_FLAG_LOADED;
+		argc--;
+		argv++;
+	}
+#endif
 #ifdef CONFIG_HASH_VERIFY
 	if (argc < 4)
 		return CMD_RET_USAGE;
@@ -38,10 +45,16 @@ static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 }
 
 #ifdef CONFIG_HASH_VERIFY
-#define HARGS 6
+#define HARGS_VERIFY 1
 #else
-#define HARGS 5
+#define HARGS_VERIFY 0
 #endif
+#ifdef CONFIG_HASH_STREAM
+#define HARGS_LOADED 1
+#else
+#define HARGS_LOADED 0
+#endif
+#define HARGS (5 + HARGS_VERIFY + HARGS_LOADED)
 
 U_BOOT_CMD(
 	hash,	HARGS,	1,	do_hash,
@@ -53,4 +66,9 @@ U_BOOT_CMD(
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+#ifdef CONFIG_HASH_STREAM
+	"\nhash -l ...\n"
+		"    - as above, but use the digest worked out by the last load\n"
+		"      if it loaded exactly this area (see 'loadhash')"
+#endif
 );
@@ -1227,6 +1227,13 @@ static int do_mem_crc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	av = argv + 1;
 	ac = argc - 1;
+#ifdef CONFIG_HASH_STREAM
+	if (strcmp(*av, "-l") == 0) {
+		flags |= HASH_FLAG_LOADED;
+		av++;
+		ac--;
+	}
+#endif
 #ifdef CONFIG_HASH_VERIFY
 	if (strcmp(*av, "-v") == 0) {
 		flags |= HASH_FLAG_VERIFY | HASH_FLAG_ENV;
@@ -1305,21 +1312,33 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_CRC32
 
+#ifdef CONFIG_HASH_STREAM
+#define CRC32_LOADED_ARGS	1
+#define CRC32_LOADED_HELP \
+	"\n-l ...\n    - as above, but use the CRC32 worked out by the last" \
+	" load\n      if it loaded exactly this area (see 'loadhash')"
+#else
+#define CRC32_LOADED_ARGS	0
+#define CRC32_LOADED_HELP
+#endif
+
 #ifndef CONFIG_HASH_VERIFY
 
 U_BOOT_CMD(
-	crc32,	4,	1,	do_mem_crc,
+	crc32,	4 + CRC32_LOADED_ARGS,	1,	do_mem_crc,
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]"
+	CRC32_LOADED_HELP
 );
 
 #else	/* CONFIG_HASH_VERIFY */
 
 U_BOOT_CMD(
-	crc32,	5,	1,	do_mem_crc,
+	crc32,	5 + CRC32_LOADED_ARGS,	1,	do_mem_crc,
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]\n"
 	"-v address count crc\n    - verify crc of memory area"
+	CRC32_LOADED_HELP
 );
 
 #endif	/* CONFIG_HASH_VERIFY */
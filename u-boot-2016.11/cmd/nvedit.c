@@ -1112,6 +1112,29 @@ static int do_env_exists(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 #endif
 
+#if defined(CONFIG_CMD_ENV_INFO)
+static int do_env_info(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct hsearch_stats stats;
+	unsigned int avg = 0;
+
+	hstats_r(&env_htab, &stats);
+	if (stats.filled)
+		avg = stats.probes * 100 / stats.filled;
+
+	printf("entries:    %u\n", stats.filled);
+	printf("slots:      %u (%u%% used, %u deleted)\n", stats.size,
+	       stats.size ? stats.filled * 100 / stats.size : 0,
+	       stats.deleted);
+	printf("resizes:    %u\n", stats.resizes);
+	printf("probes:     %u.%02u average, %u max\n", avg / 100, avg % 100,
+	       stats.max_probes);
+
+	return 0;
+}
+#endif
+
 /*
  * New command line interface: "env" command with subcommands
  */
@@ -1150,6 +1173,9 @@ static cmd_tbl_t cmd_env_sub[] = {
 #if defined(CONFIG_CMD_ENV_EXISTS)
 	U_BOOT_CMD_MKENT(exists, 2, 0, do_env_exists, "", ""),
 #endif
+#if defined(CONFIG_CMD_ENV_INFO)
+	U_BOOT_CMD_MKENT(info, 1, 0, do_env_info, "", ""),
+#endif
 };
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
@@ -1210,6 +1236,9 @@ static char env_help_text[] =
 #endif
 #if defined(CONFIG_CMD_IMPORTENV)
 	"env import [-d] [-t [-r] | -b | -c] addr [size] - import environment\n"
+#endif
+#if defined(CONFIG_CMD_ENV_INFO)
+	"env info - print hash table statistics\n"
 #endif
 	"env print [-a | name ...] - print environment\n"
 #if defined(CONFIG_CMD_RUN)
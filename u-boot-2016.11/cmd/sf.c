@@ -153,48 +153,98 @@ static int do_spi_flash_probe(int argc, char * const argv[])
 	return 0;
 }
 
+/* Byte counts gathered by spi_flash_update() */
+struct sf_update_stats {
+	size_t skipped;		/* bytes which were already correct */
+	size_t erased;		/* bytes erased */
+	size_t written;		/* bytes programmed */
+};
+
+/*
+ * Programming can only clear bits, so an erase unit needs erasing only if
+ * some bit must go from 0 to 1
+ */
+static bool spi_flash_needs_erase(const u8 *old, const u8 *new, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if ((old[i] & new[i]) != new[i])
+			return true;
+	}
+
+	return false;
+}
+
 /**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
+ * Update part of one erase block, which must start at an erase unit boundary
  *
- * If the data being written is the same, then *skipped is incremented by len.
+ * The erase units covering the region are read back and compared with the
+ * new data. Units which are already correct are left alone. Units which need
+ * a bit set are erased, in runs so that the flash can use its largest erase
+ * size, and then only the pages which differ from the flash are programmed.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
- * @param len		number of bytes to write
+ * @param len		number of bytes to write, within one erase block
  * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
- * @return NULL if OK, else a string containing the stage which failed
+ * @param cmp_buf	buffer of twice the erase block size
+ * @param stats		updated with what was done
+ * @return NULL if OK, else the name of the operation which failed
  */
 static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
+		size_t len, const char *buf, char *cmp_buf,
+		struct sf_update_stats *stats)
 {
-	char *ptr = (char *)buf;
-
-	debug("offset=%#x, sector_size=%#x, len=%#zx\n",
-	      offset, flash->sector_size, len);
-	/* Read the entire sector so to allow for rewriting */
-	if (spi_flash_read(flash, offset, flash->sector_size, cmp_buf))
+	const u32 unit = flash->erase_size;
+	const u32 page = flash->page_size;
+	size_t size = roundup(len, unit);
+	u8 *old = (u8 *)cmp_buf, *new = old + size;
+	size_t pos, run;
+
+	debug("offset=%#x, erase_size=%#x, len=%#zx\n", offset, unit, len);
+	/* Read the entire units so to allow for rewriting */
+	if (spi_flash_read(flash, offset, size, old))
 		return "read";
-	/* Compare only what is meaningful (len) */
-	if (memcmp(cmp_buf, buf, len) == 0) {
-		debug("Skip region %x size %zx: no change\n",
-		      offset, len);
-		*skipped += len;
-		return NULL;
+	memcpy(new, old, size);
+	memcpy(new, buf, len);
+
+	for (pos = 0; pos < size; pos += run) {
+		for (run = 0; pos + run < size; run += unit) {
+			if (!spi_flash_needs_erase(old + pos + run,
+						   new + pos + run, unit))
+				break;
+		}
+		if (!run) {
+			if (!memcmp(old + pos, new + pos, unit)) {
+				debug("Skip region %zx size %x: no change\n",
+				      offset + pos, unit);
+				stats->skipped += min_t(size_t, len - pos,
+							unit);
+			}
+			run = unit;
+			continue;
+		}
+		if (spi_flash_erase(flash, offset + pos, run))
+			return "erase";
+		memset(old + pos, 0xff, run);
+		stats->erased += run;
 	}
-	/* Erase the entire sector */
-	if (spi_flash_erase(flash, offset, flash->sector_size))
-		return "erase";
-	/* If it's a partial sector, copy the data into the temp-buffer */
-	if (len != flash->sector_size) {
-		memcpy(cmp_buf, buf, len);
-		ptr = cmp_buf;
+
+	/* Program runs of pages which differ from what the flash holds */
+	for (pos = 0; pos < size; pos += run) {
+		for (run = 0; pos + run < size; run += page) {
+			if (!memcmp(old + pos + run, new + pos + run, page))
+				break;
+		}
+		if (!run) {
+			run = page;
+			continue;
+		}
+		if (spi_flash_write(flash, offset + pos, run, new + pos))
+			return "write";
+		stats->written += run;
 	}
-	/* Write one complete sector */
-	if (spi_flash_write(flash, offset, flash->sector_size, ptr))
-		return "write";
 
 	return NULL;
 }
@@ -216,20 +266,23 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	char *cmp_buf;
 	const char *end = buf + len;
 	size_t todo;		/* number of bytes to do in this pass */
-	size_t skipped = 0;	/* statistics */
+	struct sf_update_stats stats = { 0 };
 	const ulong start_time = get_timer(0);
 	size_t scale = 1;
 	const char *start_buf = buf;
+	u32 block;
 	ulong delta;
 
+	/* Work a block at a time so that whole blocks can be erased at once */
+	block = max(flash->block_erase_size, flash->erase_size);
 	if (end - buf >= 200)
 		scale = (end - buf) / 100;
-	cmp_buf = memalign(ARCH_DMA_MINALIGN, flash->sector_size);
+	cmp_buf = memalign(ARCH_DMA_MINALIGN, 2 * block);
 	if (cmp_buf) {
 		ulong last_update = get_timer(0);
 
 		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min_t(size_t, end - buf, flash->sector_size);
+			todo = min_t(size_t, end - buf, block - offset % block);
 			if (get_timer(last_update) > 100) {
 				printf("   \rUpdating, %zu%% %lu B/s",
 				       100 - (end - buf) / scale,
@@ -238,7 +291,7 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 				last_update = get_timer(0);
 			}
 			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
+					buf, cmp_buf, &stats);
 		}
 	} else {
 		err_oper = "malloc";
@@ -251,10 +304,12 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	}
 
 	delta = get_timer(start_time);
-	printf("%zu bytes written, %zu bytes skipped", len - skipped,
-	       skipped);
+	printf("%zu bytes written, %zu bytes skipped", len - stats.skipped,
+	       stats.skipped);
 	printf(" in %ld.%lds, speed %ld B/s\n",
 	       delta / 1000, delta % 1000, bytes_per_second(len, start_time));
+	printf("%zu bytes erased, %zu bytes programmed\n", stats.erased,
+	       stats.written);
 
 	return 0;
 }
@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+
+static int do_unlz4(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	unsigned long src, dst, src_len;
+	size_t dst_len = ~0UL;
+	void *src_buf, *dst_buf;
+	int ret;
+
+	switch (argc) {
+	case 4:
+		dst_len = simple_strtoul(argv[3], NULL, 16);
+		/* fall through */
+	case 3:
+		src = simple_strtoul(argv[1], NULL, 16);
+		dst = simple_strtoul(argv[2], NULL, 16);
+		break;
+	default:
+		return CMD_RET_USAGE;
+	}
+	src_len = getenv_hex("filesize", ~0UL);
+
+	src_buf = map_sysmem(src, src_len);
+	dst_buf = map_sysmem(dst, dst_len);
+	ret = ulz4fn(src_buf, src_len, dst_buf, &dst_len);
+	unmap_sysmem(dst_buf);
+	unmap_sysmem(src_buf);
+	if (ret) {
+		printf("Decompression failed: %d\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("Uncompressed size: %zu = 0x%zX\n", dst_len, dst_len);
+	setenv_hex("filesize", dst_len);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	unlz4,	4,	1,	do_unlz4,
+	"decompress an LZ4 frame in memory",
+	"srcaddr dstaddr [dstsize]\n"
+	"    - the frame is 'filesize' bytes long, as left by a load"
+);
+
+#ifdef CONFIG_BLK
+static int do_lz4read(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	struct blk_desc *desc;
+	disk_partition_t info;
+	unsigned long src, dst;
+	size_t dst_len = ~0UL;
+	lbaint_t blk, cnt;
+	void *src_buf, *dst_buf;
+	int ret;
+
+	if (argc < 7)
+		return CMD_RET_USAGE;
+	if (blk_get_device_part_str(argv[1], argv[2], &desc, &info, 1) < 0)
+		return CMD_RET_FAILURE;
+
+	src = simple_strtoul(argv[3], NULL, 16);
+	dst = simple_strtoul(argv[4], NULL, 16);
+	blk = simple_strtoul(argv[5], NULL, 16);
+	cnt = simple_strtoul(argv[6], NULL, 16);
+	if (argc > 7)
+		dst_len = simple_strtoul(argv[7], NULL, 16);
+	if (blk + cnt > info.size) {
+		puts("Read out of range\n");
+		return CMD_RET_FAILURE;
+	}
+
+	src_buf = map_sysmem(src, cnt * desc->blksz);
+	dst_buf = map_sysmem(dst, dst_len);
+	ret = ulz4fn_blk(src_buf, desc, info.start + blk, cnt, dst_buf,
+			 &dst_len);
+	unmap_sysmem(dst_buf);
+	unmap_sysmem(src_buf);
+	if (ret) {
+		printf("Decompression failed: %d\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("Uncompressed size: %zu = 0x%zX\n", dst_len, dst_len);
+	setenv_hex("filesize", dst_len);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	lz4read, 8, 0, do_lz4read,
+	"read an LZ4 frame from a block device and decompress it",
+	"<interface> <dev[:part]> srcaddr dstaddr blk# cnt [dstsize]\n"
+	"    - read up to cnt blocks (hex) from blk# to srcaddr, decompressing\n"
+	"      each LZ4 block to dstaddr as soon as it has arrived"
+);
+#endif
@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <mapmem.h>
 
 static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -86,3 +87,53 @@ U_BOOT_CMD(
 	"\t\tand is required for files with uncompressed lengths\n"
 	"\t\t4 GiB or larger\n"
 );
+
+#ifdef CONFIG_BLK
+static int do_gzread(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct blk_desc *desc;
+	disk_partition_t info;
+	unsigned long src, dst, dst_len = ~0UL, len;
+	lbaint_t blk, cnt;
+	void *src_buf, *dst_buf;
+	int ret;
+
+	if (argc < 7)
+		return CMD_RET_USAGE;
+	if (blk_get_device_part_str(argv[1], argv[2], &desc, &info, 1) < 0)
+		return CMD_RET_FAILURE;
+
+	src = simple_strtoul(argv[3], NULL, 16);
+	dst = simple_strtoul(argv[4], NULL, 16);
+	blk = simple_strtoul(argv[5], NULL, 16);
+	cnt = simple_strtoul(argv[6], NULL, 16);
+	if (argc > 7)
+		dst_len = simple_strtoul(argv[7], NULL, 16);
+	if (blk + cnt > info.size) {
+		puts("Read out of range\n");
+		return CMD_RET_FAILURE;
+	}
+
+	src_buf = map_sysmem(src, cnt * desc->blksz);
+	dst_buf = map_sysmem(dst, dst_len);
+	ret = gunzip_blk(dst_buf, dst_len, src_buf, desc, info.start + blk,
+			 cnt, &len);
+	unmap_sysmem(dst_buf);
+	unmap_sysmem(src_buf);
+	if (ret)
+		return CMD_RET_FAILURE;
+
+	printf("Uncompressed size: %ld = 0x%lX\n", len, len);
+	setenv_hex("filesize", len);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	gzread, 8, 0, do_gzread,
+	"read gzipped data from a block device and unzip it",
+	"<interface> <dev[:part]> srcaddr dstaddr blk# cnt [dstsize]\n"
+	"    - read up to cnt blocks (hex) from blk# to srcaddr, unzipping\n"
+	"      each piece to dstaddr while the next one is read"
+);
+#endif
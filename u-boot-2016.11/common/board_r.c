@@ -319,6 +319,9 @@ static int initr_dm(void)
 {
 	int ret;
 
+	/* Start timing while the pre-reloc timer is still available */
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DM_R, "dm_r");
+
 	/* Save the pre-reloc driver model and start a new one */
 	gd->dm_root_f = gd->dm_root;
 	gd->dm_root = NULL;
@@ -326,6 +329,7 @@ static int initr_dm(void)
 	gd->timer = NULL;
 #endif
 	ret = dm_init_and_scan(false);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_R);
 	if (ret)
 		return ret;
 #ifdef CONFIG_TIMER_EARLY
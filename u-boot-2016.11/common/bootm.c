@@ -22,6 +22,9 @@
 #if defined(CONFIG_CMD_USB)
 #include <usb.h>
 #endif
+#ifdef CONFIG_DM_VIDEO
+#include <video.h>
+#endif
 #else
 #include "mkimage.h"
 #endif
@@ -345,6 +348,9 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 
 	*load_end = load;
 	print_decomp_msg(comp, type, load == image_start);
+#ifndef USE_HOSTCC
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+#endif
 
 	/*
 	 * Load the image to the right place, decompressing if needed. After
@@ -414,6 +420,9 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
 	}
+#ifndef USE_HOSTCC
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+#endif
 
 	if (ret)
 		return handle_decomp_error(comp, image_len, unc_len, ret);
@@ -500,6 +509,11 @@ ulong bootm_disable_interrupts(void)
 # endif
 #endif
 
+#ifdef CONFIG_DM_VIDEO
+	/* The OS expects the display to start at the frame-buffer base */
+	video_stop_pan_all();
+#endif
+
 #if defined(CONFIG_CMD_USB)
 	/*
 	 * turn off USB to prevent the host controller from writing to the
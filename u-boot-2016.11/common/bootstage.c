@@ -150,6 +150,23 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+int bootstage_accum_name(const char *name, uint32_t time_us)
+{
+	struct bootstage_record *rec;
+	int id = next_id++;
+
+	if (id >= BOOTSTAGE_ID_COUNT)
+		return BOOTSTAGE_ID_COUNT;
+	rec = &record[id];
+	rec->time_us = time_us;
+	/* Non-zero marks this as an accumulator in the report */
+	rec->start_us = max(timer_get_boot_us() - time_us, 1UL);
+	rec->name = name;
+	rec->id = id;
+
+	return id;
+}
+
 /**
  * Get a record name as a printable string
  *
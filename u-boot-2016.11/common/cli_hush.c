@@ -84,6 +84,8 @@
 #include <cli.h>
 #include <cli_hush.h>
 #include <command.h>        /* find_cmd */
+#include <environment.h>
+#include <search.h>
 #ifndef CONFIG_SYS_PROMPT_HUSH_PS2
 #define CONFIG_SYS_PROMPT_HUSH_PS2	"> "
 #endif
@@ -1589,6 +1591,9 @@ static int run_pipe_real(struct pipe *pi)
 #endif
 		return rcode;
 	} else if (pi->num_progs == 1 && pi->progs[0].argv != NULL) {
+		/* count substitutions without changing the parsed tree */
+		int sp = child->sp;
+
 		for (i=0; is_assignment(child->argv[i]); i++) { /* nothing */ }
 		if (i!=0 && child->argv[i]==NULL) {
 			/* assignments, but no command: set the local environment */
@@ -1627,11 +1632,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1764,6 +1769,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *for_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1803,7 +1809,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1832,6 +1839,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				for_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1903,7 +1911,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1923,6 +1932,20 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+#ifdef __U_BOOT__
+out:
+	/*
+	 * Put back the "for" variable name if we left the loop early, so
+	 * that the tree is as it was parsed and can be run again.
+	 */
+	if (list) {
+		free(for_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+	}
+#endif
 	return rcode;
 }
 
@@ -3301,6 +3324,212 @@ int parse_file_outer(void)
 	return rcode;
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Parse cache for "run"
+ *
+ * Boot scripts live in environment variables and call each other with
+ * "run", often from inside loops. Variables are only expanded when a
+ * command runs, so the pipe list parsed from a script stays valid for as
+ * long as its text does not change, and can be run again.
+ *
+ * Entries are looked up by variable name and only used if the CRC and a
+ * copy of the text still match. The variable also gets an env callback
+ * which drops the entry as soon as it is changed or deleted.
+ */
+#define PARSE_CACHE_ENTRIES	16
+
+struct parse_cache {
+	struct parse_cache *next;	/* most recently used first */
+	char *name;
+	char *text;
+	int len;
+	u32 crc;
+	int flag;
+	struct pipe *list;
+	int busy;			/* list is being run */
+	int stale;			/* variable changed while running */
+};
+
+static struct parse_cache *parse_cache;
+static int parse_cache_count;
+
+static struct parse_cache **parse_cache_find(const char *name)
+{
+	struct parse_cache **pp;
+
+	for (pp = &parse_cache; *pp; pp = &(*pp)->next) {
+		if (!strcmp((*pp)->name, name))
+			break;
+	}
+
+	return pp;
+}
+
+static void parse_cache_drop(struct parse_cache **pp)
+{
+	struct parse_cache *pc = *pp;
+
+	*pp = pc->next;
+	free_pipe_list(pc->list, 0);
+	free(pc->name);
+	free(pc->text);
+	free(pc);
+	parse_cache_count--;
+}
+
+static int on_parse_cache(const char *name, const char *value,
+			  enum env_op op, int flags)
+{
+	struct parse_cache **pp = parse_cache_find(name);
+
+	if (*pp) {
+		if ((*pp)->busy)
+			(*pp)->stale = 1;
+		else
+			parse_cache_drop(pp);
+	}
+
+	return 0;
+}
+
+/* Make room for a new entry, dropping the least recently used one */
+static int parse_cache_evict(void)
+{
+	struct parse_cache **pp, **lru = NULL;
+
+	if (parse_cache_count < PARSE_CACHE_ENTRIES)
+		return 0;
+	for (pp = &parse_cache; *pp; pp = &(*pp)->next) {
+		if (!(*pp)->busy)
+			lru = pp;
+	}
+	if (!lru)
+		return -1;
+	parse_cache_drop(lru);
+
+	return 0;
+}
+
+/*
+ * Parse a string the way parse_stream_outer() does, but return the list
+ * instead of running it. Returns NULL on a syntax error, which has then
+ * been reported.
+ */
+static struct pipe *parse_string_list(const char *s, int flag)
+{
+	struct in_str input;
+	struct p_context ctx;
+	o_string temp = NULL_O_STRING;
+	char *p;
+	int rcode;
+
+	p = xmalloc(strlen(s) + 2);
+	strcpy(p, s);
+	s = strchr(s, '\n');
+	if (!s || s[1])
+		strcat(p, "\n");
+	setup_string_in_str(&input, p);
+
+	ctx.type = flag;
+	initialize_context(&ctx);
+	update_ifs_map();
+	if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING))
+		mapset((uchar *)";$&|", 0);
+	input.promptmode = 1;
+	rcode = parse_stream(&temp, &ctx, &input,
+			     flag & FLAG_CONT_ON_NEWLINE ? -1 : '\n');
+	if (rcode != 1 && ctx.old_flag == 0) {
+		done_word(&temp, &ctx);
+		done_pipe(&ctx, PIPE_SEQ);
+	} else {
+		if (ctx.old_flag != 0) {
+			syntax();
+			free(ctx.stack);
+		}
+		flag_repeat = 0;
+		free_pipe_list(ctx.list_head, 0);
+		ctx.list_head = NULL;
+	}
+	b_free(&temp);
+	free(p);
+
+	return ctx.list_head;
+}
+
+/*
+ * Run the script @s held in environment variable @name, reusing the list
+ * parsed the last time it was run if the text is the same. Returns as
+ * parse_string_outer() does.
+ */
+int parse_string_cached(const char *name, const char *s, int flag)
+{
+	struct parse_cache **pp, *pc;
+	ENTRY e, *ep;
+	int len, code;
+	u32 crc;
+
+	if (!s || !*s)
+		return parse_string_outer(s, flag);
+	len = strlen(s);
+	crc = crc32(0, (const uchar *)s, len);
+
+	pp = parse_cache_find(name);
+	pc = *pp;
+	if (pc && pc->busy) {
+		/* The script runs itself, so its list is in use */
+		return parse_string_outer(s, flag);
+	} else if (pc && pc->crc == crc && pc->len == len &&
+		   pc->flag == flag && !memcmp(pc->text, s, len)) {
+		*pp = pc->next;
+	} else {
+		if (pc)
+			parse_cache_drop(pp);
+		if (parse_cache_evict())
+			return parse_string_outer(s, flag);
+
+		pc = calloc(1, sizeof(*pc));
+		if (!pc)
+			return parse_string_outer(s, flag);
+		pc->list = parse_string_list(s, flag);
+		if (!pc->list) {
+			/* The syntax error has been reported already */
+			free(pc);
+			return 1;
+		}
+		pc->name = xstrdup(name);
+		pc->text = xmalloc(len);
+		memcpy(pc->text, s, len);
+		pc->len = len;
+		pc->crc = crc;
+		pc->flag = flag;
+		parse_cache_count++;
+
+		/* Don't take over a callback the variable already has */
+		e.key = name;
+		e.data = NULL;
+		hsearch_r(e, FIND, &ep, &env_htab, 0);
+		if (ep && !ep->callback)
+			ep->callback = on_parse_cache;
+	}
+	pc->next = parse_cache;
+	parse_cache = pc;
+
+	pc->busy = 1;
+	code = run_list_real(pc->list);
+	pc->busy = 0;
+	if (pc->stale)
+		parse_cache_drop(parse_cache_find(pc->name));
+
+	if (code == -2)		/* exit */
+		code = 0;
+	if (code == -1)
+		flag_repeat = 0;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 #ifdef __U_BOOT__
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 static void u_boot_hush_reloc(void)
@@ -0,0 +1,350 @@
+/*
+ * Environment kept as a base image plus a journal of changes
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+/*
+ * Layout of the journal area:
+ *
+ *   header   magic, generation, CRC of the base image
+ *   record   magic, generation, sequence, length, CRC, then the data
+ *   record   ...
+ *   blank
+ *
+ * The header and each record start on a multiple of the journal's align.
+ * Record data uses the same format as the base image: "name=value\0"
+ * sets a variable and "name\0" deletes it. Replay stops at the first
+ * record which does not carry the header's generation and the next
+ * sequence number, or whose CRC is wrong.
+ *
+ * A new base is written first and the journal header after it, so if
+ * power fails in between the old journal no longer matches the base and
+ * is ignored.
+ */
+
+#include <common.h>
+#include <environment.h>
+#include <errno.h>
+#include <malloc.h>
+#include <search.h>
+
+#if defined(CONFIG_SYS_REDUNDAND_ENVIRONMENT) || defined(CONFIG_ENV_AES)
+#error CONFIG_ENV_JOURNAL does not support redundant or encrypted environments
+#endif
+
+#define ENV_JOURNAL_MAGIC	0x4a564e45	/* "ENVJ" */
+#define ENV_RECORD_MAGIC	0x44564e45	/* "ENVD" */
+
+struct env_journal_hdr {
+	uint32_t magic;
+	uint32_t gen;
+	uint32_t base_crc;
+};
+
+struct env_journal_rec {
+	uint32_t magic;
+	uint32_t gen;
+	uint32_t seq;
+	uint32_t len;		/* bytes of data after the header */
+	uint32_t crc;		/* crc32 of the data */
+};
+
+/* Length of exported variables, not counting the final terminator */
+static ulong env_journal_len(const char *vars)
+{
+	const char *p = vars;
+
+	while (*p)
+		p += strlen(p) + 1;
+
+	return p - vars;
+}
+
+static char *env_journal_export(struct hsearch_data *htab, ulong *lenp)
+{
+	char *res = NULL;
+
+	if (hexport_r(htab, '\0', 0, &res, 0, 0, NULL) < 0)
+		return NULL;
+	*lenp = env_journal_len(res);
+
+	return res;
+}
+
+static int env_journal_keylen(const char *var)
+{
+	const char *p = var;
+
+	while (*p && *p != '=')
+		p++;
+
+	return p - var;
+}
+
+/* Compare names the way hexport_r() sorts them */
+static int env_journal_keycmp(const char *a, const char *b)
+{
+	int alen = env_journal_keylen(a);
+	int blen = env_journal_keylen(b);
+	int ret;
+
+	ret = memcmp(a, b, min(alen, blen));
+
+	return ret ? ret : alen - blen;
+}
+
+/*
+ * Both lists are sorted by name, so walk them together and write out
+ * each variable which was added or changed, and the name of each one
+ * which was deleted.
+ */
+static ulong env_journal_diff(const char *old, const char *new, char *out)
+{
+	char *p = out;
+	int cmp, len;
+
+	while (*old || *new) {
+		if (!*old)
+			cmp = 1;
+		else if (!*new)
+			cmp = -1;
+		else
+			cmp = env_journal_keycmp(old, new);
+
+		if (cmp < 0) {
+			len = env_journal_keylen(old);
+			memcpy(p, old, len);
+			p += len;
+			*p++ = '\0';
+		} else if (cmp > 0 || strcmp(old, new)) {
+			len = strlen(new) + 1;
+			memcpy(p, new, len);
+			p += len;
+		}
+
+		if (cmp <= 0)
+			old += strlen(old) + 1;
+		if (cmp >= 0)
+			new += strlen(new) + 1;
+	}
+
+	return p - out;
+}
+
+static bool env_journal_blank(const void *buf, ulong len)
+{
+	const u8 *p = buf;
+
+	while (len--) {
+		if (*p++ != 0xff)
+			return false;
+	}
+
+	return true;
+}
+
+int env_journal_load(struct env_journal *j, struct hsearch_data *htab,
+		     const env_t *base)
+{
+	struct env_journal_hdr *hdr;
+	struct env_journal_rec *rec;
+	ulong offset, len;
+	bool torn = false;
+	char *buf;
+	int ret;
+
+	free(j->saved);
+	j->saved = NULL;
+	j->next = 0;
+	j->seq = 0;
+	if (!base)
+		return 0;
+
+	buf = memalign(ARCH_DMA_MINALIGN, j->size);
+	if (!buf)
+		return -ENOMEM;
+	ret = j->read(j, 0, j->size, buf);
+	if (ret)
+		goto out;
+
+	hdr = (struct env_journal_hdr *)buf;
+	if (hdr->magic != ENV_JOURNAL_MAGIC) {
+		j->gen = 0;
+		goto out;
+	}
+	j->gen = hdr->gen;
+	if (hdr->base_crc != base->crc) {
+		debug("%s: journal is for another base\n", __func__);
+		goto out;
+	}
+
+	offset = ALIGN(sizeof(*hdr), j->align);
+	while (offset + sizeof(*rec) <= j->size) {
+		rec = (struct env_journal_rec *)(buf + offset);
+		if (rec->magic != ENV_RECORD_MAGIC || rec->gen != j->gen ||
+		    rec->seq != j->seq) {
+			/* Erased media must be blank after the last record */
+			if (j->erase)
+				torn = !env_journal_blank(rec, sizeof(*rec));
+			break;
+		}
+		len = rec->len;
+		if (len > j->size - offset - sizeof(*rec) ||
+		    crc32(0, (uchar *)(rec + 1), len) != rec->crc) {
+			torn = true;
+			break;
+		}
+
+		if (!himport_r(htab, (char *)(rec + 1), len, '\0',
+			       H_NOCLEAR | H_FORCE, 0, 0, NULL)) {
+			printf("Cannot replay environment journal record %u\n",
+			       j->seq);
+			torn = true;
+			break;
+		}
+		offset += ALIGN(sizeof(*rec) + len, j->align);
+		j->seq++;
+	}
+	j->next = offset;
+
+	/*
+	 * A record that was cut short cannot be written over, so the next
+	 * save has to start again from a new base.
+	 */
+	if (torn) {
+		printf("Environment journal damaged after %u records\n",
+		       j->seq);
+		ret = j->seq;
+		goto out;
+	}
+	j->saved = env_journal_export(htab, &len);
+	ret = j->seq;
+out:
+	free(buf);
+
+	return ret;
+}
+
+static int env_journal_write_base(struct env_journal *j, char *vars,
+				  ulong len)
+{
+	struct env_journal_hdr *hdr;
+	ulong hdr_len = ALIGN(sizeof(*hdr), j->align);
+	env_t *env;
+	int ret;
+
+	env = memalign(ARCH_DMA_MINALIGN, sizeof(env_t));
+	hdr = memalign(ARCH_DMA_MINALIGN, hdr_len);
+	if (!env || !hdr) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	memset(env, '\0', sizeof(env_t));
+	memcpy(env->data, vars, len);
+	env->crc = crc32(0, env->data, ENV_SIZE);
+
+	ret = j->write_base(j, env);
+	if (ret)
+		goto out;
+
+	puts("Resetting environment journal...");
+	if (j->erase) {
+		ret = j->erase(j);
+		if (ret)
+			goto out;
+	}
+	memset(hdr, 0xff, hdr_len);
+	hdr->magic = ENV_JOURNAL_MAGIC;
+	hdr->gen = j->gen + 1;
+	hdr->base_crc = env->crc;
+	ret = j->write(j, 0, hdr_len, hdr);
+	if (ret)
+		goto out;
+	puts("done\n");
+
+	j->gen++;
+	j->seq = 0;
+	j->next = hdr_len;
+out:
+	free(hdr);
+	free(env);
+
+	return ret;
+}
+
+int env_journal_save(struct env_journal *j, struct hsearch_data *htab)
+{
+	struct env_journal_rec *rec;
+	ulong len, dlen, rlen;
+	char *new, *buf = NULL;
+	int ret;
+
+	new = env_journal_export(htab, &len);
+	if (!new)
+		return -ENOMEM;
+	if (len >= ENV_SIZE) {
+		printf("Environment too large: %lu bytes, room for %lu\n", len,
+		       (ulong)ENV_SIZE - 1);
+		ret = -E2BIG;
+		goto out;
+	}
+
+	if (!j->saved)
+		goto base;
+
+	buf = memalign(ARCH_DMA_MINALIGN, ALIGN(sizeof(*rec) + len +
+			env_journal_len(j->saved), j->align));
+	if (!buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	rec = (struct env_journal_rec *)buf;
+	dlen = env_journal_diff(j->saved, new, (char *)(rec + 1));
+	if (!dlen) {
+		puts("Environment unchanged\n");
+		ret = 0;
+		goto out;
+	}
+
+	rlen = ALIGN(sizeof(*rec) + dlen, j->align);
+	if (j->next + rlen > j->size)
+		goto base;
+
+	memset((char *)(rec + 1) + dlen, 0xff, rlen - sizeof(*rec) - dlen);
+	rec->magic = ENV_RECORD_MAGIC;
+	rec->gen = j->gen;
+	rec->seq = j->seq;
+	rec->len = dlen;
+	rec->crc = crc32(0, (uchar *)(rec + 1), dlen);
+
+	printf("Appending %lu bytes to environment journal...", dlen);
+	ret = j->write(j, j->next, rlen, rec);
+	if (ret) {
+		/* Whatever made it to the media cannot be written over */
+		free(j->saved);
+		j->saved = NULL;
+		goto out;
+	}
+	puts("done\n");
+	j->next += rlen;
+	j->seq++;
+	goto done;
+
+base:
+	ret = env_journal_write_base(j, new, len);
+	if (ret) {
+		free(j->saved);
+		j->saved = NULL;
+		goto out;
+	}
+done:
+	free(j->saved);
+	j->saved = new;
+	new = NULL;
+out:
+	free(buf);
+	free(new);
+
+	return ret;
+}
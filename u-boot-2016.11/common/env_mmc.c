@@ -123,7 +123,20 @@ static void fini_mmc_for_env(struct mmc *mmc)
 #endif
 }
 
-#ifdef CONFIG_CMD_SAVEENV
+static inline int read_env(struct mmc *mmc, unsigned long size,
+			   unsigned long offset, const void *buffer)
+{
+	uint blk_start, blk_cnt, n;
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+
+	blk_start	= ALIGN(offset, mmc->read_bl_len) / mmc->read_bl_len;
+	blk_cnt		= ALIGN(size, mmc->read_bl_len) / mmc->read_bl_len;
+
+	n = blk_dread(desc, blk_start, blk_cnt, (uchar *)buffer);
+
+	return (n == blk_cnt) ? 0 : -1;
+}
+
 static inline int write_env(struct mmc *mmc, unsigned long size,
 			    unsigned long offset, const void *buffer)
 {
@@ -138,6 +151,58 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	return (n == blk_cnt) ? 0 : -1;
 }
 
+#ifdef CONFIG_ENV_JOURNAL
+#if !defined(CONFIG_ENV_JOURNAL_OFFSET) || !defined(CONFIG_ENV_JOURNAL_SIZE)
+#error CONFIG_ENV_JOURNAL needs CONFIG_ENV_JOURNAL_OFFSET and _SIZE
+#endif
+
+static int env_mmc_journal_read(struct env_journal *j, ulong offset,
+				ulong len, void *buf)
+{
+	return read_env(j->priv, len, CONFIG_ENV_JOURNAL_OFFSET + offset, buf);
+}
+
+static int env_mmc_journal_write(struct env_journal *j, ulong offset,
+				 ulong len, const void *buf)
+{
+	return write_env(j->priv, len, CONFIG_ENV_JOURNAL_OFFSET + offset,
+			 buf);
+}
+
+static int env_mmc_journal_write_base(struct env_journal *j, env_t *env)
+{
+	struct mmc *mmc = j->priv;
+	u32 offset;
+
+	if (mmc_get_env_addr(mmc, 0, &offset))
+		return -EINVAL;
+
+	printf("Writing to MMC(%d)... ", mmc_get_env_dev());
+	if (write_env(mmc, CONFIG_ENV_SIZE, offset, env)) {
+		puts("failed\n");
+		return -EIO;
+	}
+	puts("done\n");
+
+	return 0;
+}
+
+/* Blocks are simply rewritten, so there is no erase */
+static struct env_journal env_mmc_journal = {
+	.size		= CONFIG_ENV_JOURNAL_SIZE,
+	.read		= env_mmc_journal_read,
+	.write		= env_mmc_journal_write,
+	.write_base	= env_mmc_journal_write_base,
+};
+
+static void env_mmc_journal_init(struct mmc *mmc)
+{
+	env_mmc_journal.priv = mmc;
+	env_mmc_journal.align = mmc->write_bl_len;
+}
+#endif
+
+#ifdef CONFIG_CMD_SAVEENV
 #ifdef CONFIG_ENV_OFFSET_REDUND
 static unsigned char env_flags;
 #endif
@@ -157,6 +222,12 @@ int saveenv(void)
 		return 1;
 	}
 
+#ifdef CONFIG_ENV_JOURNAL
+	env_mmc_journal_init(mmc);
+	ret = env_journal_save(&env_mmc_journal, &env_htab) ? 1 : 0;
+	goto fini;
+#endif
+
 	ret = env_export(env_new);
 	if (ret)
 		goto fini;
@@ -193,20 +264,6 @@ fini:
 }
 #endif /* CONFIG_CMD_SAVEENV */
 
-static inline int read_env(struct mmc *mmc, unsigned long size,
-			   unsigned long offset, const void *buffer)
-{
-	uint blk_start, blk_cnt, n;
-	struct blk_desc *desc = mmc_get_blk_desc(mmc);
-
-	blk_start	= ALIGN(offset, mmc->read_bl_len) / mmc->read_bl_len;
-	blk_cnt		= ALIGN(size, mmc->read_bl_len) / mmc->read_bl_len;
-
-	n = blk_dread(desc, blk_start, blk_cnt, (uchar *)buffer);
-
-	return (n == blk_cnt) ? 0 : -1;
-}
-
 #ifdef CONFIG_ENV_OFFSET_REDUND
 void env_relocate_spec(void)
 {
@@ -329,7 +386,12 @@ void env_relocate_spec(void)
 		goto fini;
 	}
 
-	env_import(buf, 1);
+	ret = env_import(buf, 1);
+#ifdef CONFIG_ENV_JOURNAL
+	env_mmc_journal_init(mmc);
+	env_journal_load(&env_mmc_journal, &env_htab,
+			 ret ? (env_t *)buf : NULL);
+#endif
 	ret = 0;
 
 fini:
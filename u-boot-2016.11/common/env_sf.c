@@ -236,14 +236,11 @@ out:
 	free(tmp_env2);
 }
 #else
-int saveenv(void)
+static int env_sf_probe(void)
 {
-	u32	saved_size, saved_offset, sector = 1;
-	char	*saved_buffer = NULL;
-	int	ret = 1;
-	env_t	env_new;
 #ifdef CONFIG_DM_SPI_FLASH
 	struct udevice *new;
+	int ret;
 
 	/* speed and mode will be read from DT */
 	ret = spi_flash_probe_bus_cs(CONFIG_ENV_SPI_BUS, CONFIG_ENV_SPI_CS,
@@ -267,6 +264,15 @@ int saveenv(void)
 	}
 #endif
 
+	return 0;
+}
+
+static int env_sf_write(env_t *env_new)
+{
+	u32	saved_size, saved_offset, sector = 1;
+	char	*saved_buffer = NULL;
+	int	ret = 1;
+
 	/* Is the sector larger than the env (i.e. embedded) */
 	if (CONFIG_ENV_SECT_SIZE > CONFIG_ENV_SIZE) {
 		saved_size = CONFIG_ENV_SECT_SIZE - CONFIG_ENV_SIZE;
@@ -287,10 +293,6 @@ int saveenv(void)
 			sector++;
 	}
 
-	ret = env_export(&env_new);
-	if (ret)
-		goto done;
-
 	puts("Erasing SPI flash...");
 	ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
 		sector * CONFIG_ENV_SECT_SIZE);
@@ -299,7 +301,7 @@ int saveenv(void)
 
 	puts("Writing to SPI flash...");
 	ret = spi_flash_write(env_flash, CONFIG_ENV_OFFSET,
-		CONFIG_ENV_SIZE, &env_new);
+		CONFIG_ENV_SIZE, env_new);
 	if (ret)
 		goto done;
 
@@ -320,6 +322,69 @@ int saveenv(void)
 	return ret;
 }
 
+#ifdef CONFIG_ENV_JOURNAL
+#if !defined(CONFIG_ENV_JOURNAL_OFFSET) || !defined(CONFIG_ENV_JOURNAL_SIZE)
+#error CONFIG_ENV_JOURNAL needs CONFIG_ENV_JOURNAL_OFFSET and _SIZE
+#endif
+
+static int env_sf_journal_read(struct env_journal *j, ulong offset,
+			       ulong len, void *buf)
+{
+	return spi_flash_read(env_flash, CONFIG_ENV_JOURNAL_OFFSET + offset,
+			      len, buf);
+}
+
+static int env_sf_journal_write(struct env_journal *j, ulong offset,
+				ulong len, const void *buf)
+{
+	return spi_flash_write(env_flash, CONFIG_ENV_JOURNAL_OFFSET + offset,
+			       len, buf);
+}
+
+static int env_sf_journal_erase(struct env_journal *j)
+{
+	return spi_flash_erase(env_flash, CONFIG_ENV_JOURNAL_OFFSET,
+			       CONFIG_ENV_JOURNAL_SIZE);
+}
+
+static int env_sf_journal_write_base(struct env_journal *j, env_t *env)
+{
+	return env_sf_write(env);
+}
+
+static struct env_journal env_sf_journal = {
+	.size		= CONFIG_ENV_JOURNAL_SIZE,
+	.align		= 16,
+	.read		= env_sf_journal_read,
+	.write		= env_sf_journal_write,
+	.erase		= env_sf_journal_erase,
+	.write_base	= env_sf_journal_write_base,
+};
+#endif
+
+int saveenv(void)
+{
+	int	ret;
+#ifndef CONFIG_ENV_JOURNAL
+	env_t	env_new;
+#endif
+
+	if (env_sf_probe())
+		return 1;
+
+#ifdef CONFIG_ENV_JOURNAL
+	ret = env_journal_save(&env_sf_journal, &env_htab) ? 1 : 0;
+#else
+	ret = env_export(&env_new);
+	if (ret)
+		return ret;
+
+	ret = env_sf_write(&env_new);
+#endif
+
+	return ret;
+}
+
 void env_relocate_spec(void)
 {
 	int ret;
@@ -345,6 +410,10 @@ void env_relocate_spec(void)
 	ret = env_import(buf, 1);
 	if (ret)
 		gd->env_valid = 1;
+#ifdef CONFIG_ENV_JOURNAL
+	env_journal_load(&env_sf_journal, &env_htab,
+			 ret ? (env_t *)buf : NULL);
+#endif
 out:
 	spi_flash_free(env_flash);
 	if (buf)
@@ -183,6 +183,41 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+int fb_mmc_stream_start(const char *cmd, struct sparse_stream *ss)
+{
+	/* These must last until the download is complete */
+	static struct fb_mmc_sparse sparse_priv;
+	static struct sparse_storage sparse;
+	struct blk_desc *dev_desc;
+	disk_partition_t info;
+
+	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (!dev_desc || dev_desc->type == DEV_TYPE_UNKNOWN) {
+		error("invalid mmc device\n");
+		return -ENODEV;
+	}
+
+	if (part_get_info_by_name_or_alias(dev_desc, cmd, &info)) {
+		error("cannot find partition: '%s'\n", cmd);
+		return -ENOENT;
+	}
+
+	sparse_priv.dev_desc = dev_desc;
+
+	sparse.blksz = info.blksz;
+	sparse.start = info.start;
+	sparse.size = info.size;
+	sparse.write = fb_mmc_sparse_write;
+	sparse.reserve = fb_mmc_sparse_reserve;
+	sparse.priv = &sparse_priv;
+
+	printf("Streaming sparse image to offset " LBAFU "\n", sparse.start);
+
+	return sparse_stream_start(ss, &sparse);
+}
+#endif
+
 void fb_mmc_erase(const char *cmd)
 {
 	int ret;
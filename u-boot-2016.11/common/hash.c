@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <hw_sha.h>
+#include <watchdog.h>
 #include <asm/io.h>
 #include <linux/errno.h>
 #else
@@ -269,6 +270,163 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 	return 0;
 }
 
+#if defined(CONFIG_HASH_STREAM) && !defined(CONFIG_SPL_BUILD)
+/*
+ * Only one load runs at a time, so there is a single stream, and only the
+ * digest of the last completed load is kept.
+ */
+static struct {
+	struct hash_algo *algo;
+	void *ctx;
+	const char *start;		/* first byte of the region */
+	const char *next;		/* first byte not hashed yet */
+	unsigned long streamed;		/* bytes hashed as they arrived */
+} stream;
+
+static struct {
+	struct hash_algo *algo;
+	const void *start;
+	unsigned long len;
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+} stream_digest;
+
+static int hash_stream_feed(const char *buf, unsigned long len, int is_last)
+{
+	struct hash_algo *algo = stream.algo;
+	unsigned int chunk;
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_HASH, "hash");
+	do {
+		chunk = min_t(unsigned long, len, algo->chunk_size);
+		ret = algo->hash_update(algo, stream.ctx, buf, chunk,
+					is_last && chunk == len);
+		if (ret) {
+			/* the context has been freed */
+			stream.algo = NULL;
+			break;
+		}
+		buf += chunk;
+		len -= chunk;
+		WATCHDOG_RESET();
+	} while (len);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_HASH);
+
+	return ret;
+}
+
+int hash_stream_start(const void *start)
+{
+	struct hash_algo *algo;
+	const char *algo_name;
+	int ret;
+
+	hash_stream_abort();
+	stream_digest.algo = NULL;
+
+	algo_name = getenv("loadhash");
+	if (!algo_name)
+		return -ENOENT;
+	ret = hash_progressive_lookup_algo(algo_name, &algo);
+	if (ret)
+		return ret;
+	if (algo->hash_init(algo, &stream.ctx))
+		return -ENOMEM;
+
+	stream.algo = algo;
+	stream.start = start;
+	stream.next = start;
+	stream.streamed = 0;
+
+	return 0;
+}
+
+void hash_stream_update(const void *buf, unsigned long len)
+{
+	const char *ptr = buf;
+
+	if (!stream.algo || !len)
+		return;
+
+	if (ptr == stream.next) {
+		if (!hash_stream_feed(ptr, len, 0)) {
+			stream.next += len;
+			stream.streamed += len;
+		}
+	} else if (ptr < stream.next && ptr + len > stream.start) {
+		debug("%s: %p rewritten after hashing, dropping stream\n",
+		      __func__, ptr);
+		hash_stream_abort();
+	}
+}
+
+bool hash_stream_active(void)
+{
+	return stream.algo != NULL;
+}
+
+int hash_stream_finish(unsigned long len)
+{
+	struct hash_algo *algo = stream.algo;
+	const char *end = stream.start + len;
+	int ret;
+
+	if (!algo)
+		return -ENOENT;
+	if (stream.next > end) {
+		hash_stream_abort();
+		return -EINVAL;
+	}
+
+	/* pick up whatever did not pass through hash_stream_update() */
+	ret = hash_stream_feed(stream.next, end - stream.next, 1);
+	if (ret)
+		return ret;
+	debug("%s: %lu of %lu bytes hashed while loading\n", __func__,
+	      stream.streamed, len);
+
+	stream.algo = NULL;
+	ret = algo->hash_finish(algo, stream.ctx, stream_digest.digest,
+				sizeof(stream_digest.digest));
+	if (ret)
+		return ret;
+	/* crc32's hash_func_ws() gives a big-endian value; match it */
+	if (!strcmp(algo->name, "crc32"))
+		*(uint32_t *)stream_digest.digest =
+			htonl(*(uint32_t *)stream_digest.digest);
+	stream_digest.algo = algo;
+	stream_digest.start = stream.start;
+	stream_digest.len = len;
+
+	return 0;
+}
+
+void hash_stream_abort(void)
+{
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+
+	if (!stream.algo)
+		return;
+	/* hash_finish() is the only way to free the context */
+	stream.algo->hash_finish(stream.algo, stream.ctx, digest,
+				 sizeof(digest));
+	stream.algo = NULL;
+}
+
+int hash_stream_lookup(const char *algo_name, const void *data,
+		       unsigned long len, uint8_t *output)
+{
+	struct hash_algo *algo = stream_digest.algo;
+
+	if (!algo || strcmp(algo->name, algo_name) ||
+	    stream_digest.start != data || stream_digest.len != len)
+		return -ENOENT;
+	memcpy(output, stream_digest.digest, algo->digest_size);
+
+	return algo->digest_size;
+}
+#endif
+
 #if defined(CONFIG_CMD_HASH) || defined(CONFIG_CMD_SHA1SUM) || defined(CONFIG_CMD_CRC32)
 /**
  * store_result: Store the resulting sum to an address or variable
@@ -420,7 +578,12 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 		}
 
 		buf = map_sysmem(addr, len);
-		algo->hash_func_ws(buf, len, output, algo->chunk_size);
+		if (!(flags & HASH_FLAG_LOADED) ||
+		    hash_stream_lookup(algo->name, buf, len, output) < 0) {
+			bootstage_start(BOOTSTAGE_ID_ACCUM_HASH, "hash");
+			algo->hash_func_ws(buf, len, output, algo->chunk_size);
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_HASH);
+		}
 		unmap_sysmem(buf);
 
 		/* Try to avoid code bloat when verify is not needed */
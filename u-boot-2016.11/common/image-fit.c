@@ -918,6 +918,9 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
+	int ret = 0;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_HASH, "hash");
 	if (IMAGE_ENABLE_CRC32 && strcmp(algo, "crc32") == 0) {
 		*((uint32_t *)value) = crc32_wd(0, data, data_len,
 							CHUNKSZ_CRC32);
@@ -936,9 +939,11 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 		*value_len = 16;
 	} else {
 		debug("Unsupported hash alogrithm\n");
-		return -1;
+		ret = -1;
 	}
-	return 0;
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_HASH);
+
+	return ret;
 }
 
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
@@ -49,39 +49,31 @@
 #define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 512)
 #endif
 
-void write_sparse_image(
-		struct sparse_storage *info, const char *part_name,
-		void *data, unsigned sz)
+/* Start reading chunk headers, or finish if there are no more chunks */
+static void sparse_next_chunk(struct sparse_stream *ss)
 {
-	lbaint_t blk;
-	lbaint_t blkcnt;
-	lbaint_t blks;
-	uint32_t bytes_written = 0;
-	unsigned int chunk;
-	unsigned int offset;
-	unsigned int chunk_data_sz;
-	uint32_t *fill_buf = NULL;
-	uint32_t fill_val;
-	sparse_header_t *sparse_header;
-	chunk_header_t *chunk_header;
-	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
-
-	/* Read and skip over sparse image header */
-	sparse_header = (sparse_header_t *)data;
-
-	data += sparse_header->file_hdr_sz;
-	if (sparse_header->file_hdr_sz > sizeof(sparse_header_t)) {
-		/*
-		 * Skip the remaining bytes in a header that is longer than
-		 * we expected.
-		 */
-		data += (sparse_header->file_hdr_sz - sizeof(sparse_header_t));
+	if (ss->chunk_no == ss->header.total_chunks) {
+		ss->state = SPARSE_DONE;
+		return;
 	}
+	ss->chunk_no++;
+	ss->state = SPARSE_CHUNK_HDR;
+	ss->got = 0;
+	ss->need = sizeof(chunk_header_t);
+}
+
+static int sparse_fail(struct sparse_stream *ss, const char *err, int ret)
+{
+	ss->err = err;
+	ss->state = SPARSE_ERROR;
+
+	return ret;
+}
+
+static int sparse_check_file_hdr(struct sparse_stream *ss)
+{
+	sparse_header_t *sparse_header = &ss->header;
+	unsigned int offset;
 
 	debug("=== Sparse Image Header ===\n");
 	debug("magic: 0x%x\n", sparse_header->magic);
@@ -93,172 +85,299 @@ void write_sparse_image(
 	debug("total_blks: %d\n", sparse_header->total_blks);
 	debug("total_chunks: %d\n", sparse_header->total_chunks);
 
+	if (!is_sparse_image(sparse_header) ||
+	    sparse_header->file_hdr_sz < sizeof(sparse_header_t) ||
+	    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t))
+		return sparse_fail(ss, "sparse image header issue", -EINVAL);
+
 	/*
 	 * Verify that the sparse block size is a multiple of our
 	 * storage backend block size
 	 */
-	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
-	if (offset) {
+	div_u64_rem(sparse_header->blk_sz, ss->info->blksz, &offset);
+	if (offset || !sparse_header->blk_sz) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
-		fastboot_fail("sparse image block size issue");
-		return;
+		return sparse_fail(ss, "sparse image block size issue",
+				   -EINVAL);
 	}
 
-	puts("Flashing Sparse Image\n");
+	/* Skip the remaining bytes in a header that is longer than expected */
+	ss->need = sparse_header->file_hdr_sz - sizeof(sparse_header_t);
 
-	/* Start processing chunks */
-	blk = info->start;
-	for (chunk = 0; chunk < sparse_header->total_chunks; chunk++) {
-		/* Read and skip over chunk header */
-		chunk_header = (chunk_header_t *)data;
-		data += sizeof(chunk_header_t);
-
-		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
-			debug("=== Chunk Header ===\n");
-			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
-			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
-			debug("total_size: 0x%x\n", chunk_header->total_sz);
-		}
+	return 0;
+}
+
+static int sparse_start_chunk(struct sparse_stream *ss)
+{
+	struct sparse_storage *info = ss->info;
+	chunk_header_t *chunk_header = &ss->chunk;
+	uint32_t hdr_sz = ss->header.chunk_hdr_sz;
+	uint64_t chunk_data_sz;
 
-		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t)) {
-			/*
-			 * Skip the remaining bytes in a header that is longer
-			 * than we expected.
-			 */
-			data += (sparse_header->chunk_hdr_sz -
-				 sizeof(chunk_header_t));
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
+
+	chunk_data_sz = (uint64_t)ss->header.blk_sz * chunk_header->chunk_sz;
+	ss->blkcnt = lldiv(chunk_data_sz, info->blksz);
+	if (chunk_header->chunk_type == CHUNK_TYPE_RAW ||
+	    chunk_header->chunk_type == CHUNK_TYPE_FILL) {
+		if (ss->blk + ss->blkcnt > info->start + info->size) {
+			printf("%s: Request would exceed partition size!\n",
+			       __func__);
+			return sparse_fail(ss,
+				"Request would exceed partition size!",
+				-ENOSPC);
 		}
+	}
 
-		chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
-		blkcnt = chunk_data_sz / info->blksz;
-		switch (chunk_header->chunk_type) {
-		case CHUNK_TYPE_RAW:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type Raw");
-				return;
-			}
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz != hdr_sz + chunk_data_sz)
+			return sparse_fail(ss,
+				"Bogus chunk size for chunk type Raw", -EINVAL);
+		ss->state = SPARSE_RAW;
+		ss->need = chunk_data_sz;
+		if (!ss->need)
+			sparse_next_chunk(ss);
+		break;
 
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
-			}
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz != hdr_sz + sizeof(uint32_t))
+			return sparse_fail(ss,
+				"Bogus chunk size for chunk type FILL",
+				-EINVAL);
+		ss->state = SPARSE_FILL;
+		ss->got = 0;
+		ss->need = sizeof(uint32_t);
+		break;
 
-			blks = info->write(info, blk, blkcnt, data);
-			/* blks might be > blkcnt (eg. NAND bad-blocks) */
-			if (blks < blkcnt) {
-				printf("%s: %s" LBAFU " [" LBAFU "]\n",
-				       __func__, "Write failed, block #",
-				       blk, blks);
-				fastboot_fail(
-					      "flash write failure");
-				return;
-			}
-			blk += blks;
-			bytes_written += blkcnt * info->blksz;
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
-			break;
+	case CHUNK_TYPE_DONT_CARE:
+		/* Nothing is written, so the storage keeps what it had */
+		ss->blk += info->reserve(info, ss->blk, ss->blkcnt);
+		ss->total_blocks += chunk_header->chunk_sz;
+		sparse_next_chunk(ss);
+		break;
 
-		case CHUNK_TYPE_FILL:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type FILL");
-				return;
-			}
+	case CHUNK_TYPE_CRC32:
+		if (chunk_header->total_sz < hdr_sz)
+			return sparse_fail(ss,
+				"Bogus chunk size for chunk type CRC32",
+				-EINVAL);
+		ss->total_blocks += chunk_header->chunk_sz;
+		ss->state = SPARSE_SKIP;
+		ss->need = chunk_header->total_sz - hdr_sz;
+		break;
 
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL");
-				return;
-			}
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		return sparse_fail(ss, "Unknown chunk type", -EINVAL);
+	}
 
-			fill_val = *(uint32_t *)data;
-			data = (char *)data + sizeof(uint32_t);
-
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
-			}
+	return 0;
+}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					fastboot_fail(
-						      "flash write failure");
-					free(fill_buf);
-					return;
-				}
-				blk += blks;
-				i += j;
-			}
-			bytes_written += blkcnt * info->blksz;
-			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-			free(fill_buf);
-			break;
+static int sparse_write_blocks(struct sparse_stream *ss, lbaint_t blkcnt,
+			       const void *buf)
+{
+	lbaint_t blks;
 
-		case CHUNK_TYPE_DONT_CARE:
-			blk += info->reserve(info, blk, blkcnt);
-			total_blocks += chunk_header->chunk_sz;
-			break;
+	blks = ss->info->write(ss->info, ss->blk, blkcnt, buf);
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	if (blks < blkcnt) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+		       "Write failed, block #", ss->blk, blks);
+		return sparse_fail(ss, "flash write failure", -EIO);
+	}
+	ss->blk += blks;
+	ss->bytes_written += blkcnt * ss->info->blksz;
+
+	return 0;
+}
+
+/* Write out the raw data collected in the buffer */
+static int sparse_flush(struct sparse_stream *ss)
+{
+	lbaint_t blkcnt = ss->buf_len / ss->info->blksz;
+	int ret;
+
+	ret = sparse_write_blocks(ss, blkcnt, ss->buf);
+	ss->buf_len = 0;
+
+	return ret;
+}
+
+static int sparse_fill(struct sparse_stream *ss)
+{
+	uint32_t *fill_buf = ss->buf;
+	lbaint_t i, j;
+	int ret;
+
+	for (i = 0; i < ss->buf_blks * ss->info->blksz / sizeof(uint32_t); i++)
+		fill_buf[i] = ss->fill_val;
+
+	for (i = 0; i < ss->blkcnt; i += j) {
+		j = min(ss->blkcnt - i, ss->buf_blks);
+		ret = sparse_write_blocks(ss, j, fill_buf);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
 
-		case CHUNK_TYPE_CRC32:
-			if (chunk_header->total_sz !=
-			    sparse_header->chunk_hdr_sz) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type Dont Care");
-				return;
+int sparse_stream_start(struct sparse_stream *ss, struct sparse_storage *info)
+{
+	memset(ss, '\0', sizeof(*ss));
+	ss->info = info;
+	ss->blk = info->start;
+	ss->state = SPARSE_FILE_HDR;
+	ss->need = sizeof(sparse_header_t);
+	ss->buf_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
+	ss->buf = memalign(ARCH_DMA_MINALIGN,
+			   ROUNDUP(info->blksz * ss->buf_blks,
+				   ARCH_DMA_MINALIGN));
+	if (!ss->buf)
+		return sparse_fail(ss, "Malloc failed for sparse buffer",
+				   -ENOMEM);
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			unsigned int len)
+{
+	const uint8_t *ptr = data;
+	uint32_t blksz = ss->info->blksz;
+	unsigned int todo;
+	uint8_t *hdr;
+	int ret = 0;
+
+	while (len && !ret) {
+		todo = min_t(uint64_t, len, ss->need);
+		switch (ss->state) {
+		case SPARSE_FILE_HDR:
+		case SPARSE_CHUNK_HDR:
+		case SPARSE_FILL:
+			/* Collect the header or fill value, which may be split */
+			if (ss->state == SPARSE_FILE_HDR)
+				hdr = (uint8_t *)&ss->header;
+			else if (ss->state == SPARSE_CHUNK_HDR)
+				hdr = (uint8_t *)&ss->chunk;
+			else
+				hdr = (uint8_t *)&ss->fill_val;
+			memcpy(hdr + ss->got, ptr, todo);
+			ss->got += todo;
+			ss->need -= todo;
+			if (ss->need)
+				break;
+			if (ss->state == SPARSE_FILE_HDR) {
+				ret = sparse_check_file_hdr(ss);
+				if (!ret)
+					ss->state = SPARSE_SKIP;
+			} else if (ss->state == SPARSE_CHUNK_HDR) {
+				ss->need = ss->header.chunk_hdr_sz -
+					sizeof(chunk_header_t);
+				ss->state = SPARSE_CHUNK_HDR_SKIP;
+			} else {
+				ret = sparse_fill(ss);
+				if (ret)
+					break;
+				ss->total_blocks += ss->chunk.chunk_sz;
+				sparse_next_chunk(ss);
 			}
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
 			break;
-
+		case SPARSE_RAW:
+			if (!ss->buf_len && todo >= blksz) {
+				/* Whole blocks can go straight to storage */
+				todo -= todo % blksz;
+				ret = sparse_write_blocks(ss, todo / blksz, ptr);
+			} else {
+				todo = min_t(unsigned int, todo,
+					     ss->buf_blks * blksz - ss->buf_len);
+				memcpy(ss->buf + ss->buf_len, ptr, todo);
+				ss->buf_len += todo;
+				if (ss->buf_len == ss->buf_blks * blksz ||
+				    ss->need == todo)
+					ret = sparse_flush(ss);
+			}
+			/* A failed write leaves the stream in SPARSE_ERROR */
+			if (ret)
+				break;
+			ss->need -= todo;
+			if (!ss->need) {
+				ss->total_blocks += ss->chunk.chunk_sz;
+				sparse_next_chunk(ss);
+			}
+			break;
+		case SPARSE_CHUNK_HDR_SKIP:
+		case SPARSE_SKIP:
+			ss->need -= todo;
+			break;
+		case SPARSE_DONE:
+			/* Ignore anything after the last chunk */
+			todo = len;
+			break;
 		default:
-			printf("%s: Unknown chunk type: %x\n", __func__,
-			       chunk_header->chunk_type);
-			fastboot_fail("Unknown chunk type");
-			return;
+			return -EINVAL;
+		}
+		ptr += todo;
+		len -= todo;
+
+		/* Headers and CRCs may be followed by nothing at all */
+		if (!ret && !ss->need) {
+			if (ss->state == SPARSE_SKIP)
+				sparse_next_chunk(ss);
+			else if (ss->state == SPARSE_CHUNK_HDR_SKIP)
+				ret = sparse_start_chunk(ss);
 		}
 	}
 
+	return ret;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss)
+{
+	int ret = 0;
+
+	free(ss->buf);
+	ss->buf = NULL;
+	if (ss->state == SPARSE_ERROR)
+		return -EINVAL;
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
-	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %u bytes to '%s'\n", bytes_written, part_name);
+	      ss->total_blocks, ss->header.total_blks);
+	if (ss->state != SPARSE_DONE)
+		ret = sparse_fail(ss, "sparse image is truncated", -EINVAL);
+	else if (ss->total_blocks != ss->header.total_blks)
+		ret = sparse_fail(ss, "sparse image write failure", -EINVAL);
 
-	if (total_blocks != sparse_header->total_blks)
-		fastboot_fail("sparse image write failure");
-	else
-		fastboot_okay("");
+	return ret;
+}
 
-	return;
+#ifdef CONFIG_FASTBOOT_FLASH
+void write_sparse_image(
+		struct sparse_storage *info, const char *part_name,
+		void *data, unsigned sz)
+{
+	struct sparse_stream ss;
+
+	puts("Flashing Sparse Image\n");
+
+	if (!sparse_stream_start(&ss, info))
+		sparse_stream_write(&ss, data, sz);
+	if (sparse_stream_finish(&ss)) {
+		fastboot_fail(ss.err);
+		return;
+	}
+
+	printf("........ wrote %llu bytes to '%s'\n", ss.bytes_written,
+	       part_name);
+	fastboot_okay("");
 }
+#endif
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <blk.h>
 #include <dm.h>
+#include <hash.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 
@@ -384,6 +385,14 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return -ENODEV;
 }
 
+static ulong blk_read_dev(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+
+	return blk_get_ops(dev)->read(dev, start, blkcnt, buffer);
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
@@ -394,17 +403,152 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->read)
 		return -ENOSYS;
 
+	/* When the data is being hashed, do that while reading the rest */
+	if (ops->read_async && hash_stream_active() &&
+	    blkcnt * block_dev->blksz > BLK_PIPE_CHUNK_SIZE)
+		return blk_read_pipe(block_dev, start, blkcnt, buffer, NULL,
+				     NULL);
+
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
-		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
+			  start, blkcnt, block_dev->blksz, buffer) ||
+	    blkcache_read_ahead(block_dev, start, blkcnt, buffer,
+				blk_read_dev)) {
+		blks_read = blkcnt;
+	} else {
+		blks_read = ops->read(dev, start, blkcnt, buffer);
+		if (blks_read == blkcnt)
+			blkcache_fill(block_dev->if_type, block_dev->devnum,
+				      start, blkcnt, block_dev->blksz, buffer);
+	}
+	if (!IS_ERR_VALUE(blks_read))
+		hash_stream_update(buffer, blks_read * block_dev->blksz);
+
+	return blks_read;
+}
+
+int blk_dread_async(struct blk_desc *block_dev, lbaint_t start,
+		    lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_async_read *req = &block_dev->async;
+
+	if (req->active)
+		return -EBUSY;
+
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buffer;
+	req->active = true;
+	req->pending = false;
+	req->cached = blkcache_read(block_dev->if_type, block_dev->devnum,
+				    start, blkcnt, block_dev->blksz, buffer);
+	if (req->cached) {
+		req->result = blkcnt;
+		return 0;
+	}
+	/*
+	 * The caller may be working on the data either side while this read
+	 * is in progress, so only read whole cache lines in the background
+	 */
+	if (ops->read_async &&
+	    IS_ALIGNED((ulong)buffer | blkcnt * block_dev->blksz,
+		       ARCH_DMA_MINALIGN) &&
+	    !ops->read_async(dev, start, blkcnt, buffer)) {
+		req->pending = true;
+		return 0;
+	}
+
+	/* The driver cannot do it in the background, so do it now */
+	if (ops->read)
+		req->result = ops->read(dev, start, blkcnt, buffer);
+	else
+		req->result = -ENOSYS;
+
+	return 0;
+}
+
+/* Complete the read in progress, without passing it to the hash stream */
+static unsigned long blk_finish_read(struct blk_desc *block_dev)
+{
+	struct udevice *dev = block_dev->bdev;
+	struct blk_async_read *req = &block_dev->async;
+	unsigned long blks_read = req->result;
+
+	if (req->pending)
+		blks_read = blk_get_ops(dev)->wait(dev);
+	req->active = false;
+	req->pending = false;
+	if (!req->cached && blks_read == req->blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+			      req->start, req->blkcnt, block_dev->blksz,
+			      req->buffer);
 
 	return blks_read;
 }
 
+unsigned long blk_dwait(struct blk_desc *block_dev)
+{
+	void *buffer = block_dev->async.buffer;
+	unsigned long blks_read;
+
+	if (!block_dev->async.active)
+		return -EINVAL;
+
+	blks_read = blk_finish_read(block_dev);
+	if (!IS_ERR_VALUE(blks_read))
+		hash_stream_update(buffer, blks_read * block_dev->blksz);
+
+	return blks_read;
+}
+
+unsigned long blk_read_pipe(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer, blk_pipe_func func,
+			    void *priv)
+{
+	lbaint_t chunk = max_t(lbaint_t, 1,
+			       BLK_PIPE_CHUNK_SIZE / block_dev->blksz);
+	unsigned long blksz = block_dev->blksz;
+	lbaint_t done = 0, cur, next;
+	unsigned long blks_read;
+	void *buf;
+	int ret;
+
+	if (!blkcnt)
+		return 0;
+	cur = min(blkcnt, chunk);
+	ret = blk_dread_async(block_dev, start, cur, buffer);
+	if (ret)
+		return ret;
+
+	do {
+		buf = buffer + done * blksz;
+		blks_read = blk_finish_read(block_dev);
+		if (IS_ERR_VALUE(blks_read))
+			return blks_read;
+		done += blks_read;
+
+		/* Get the device going on the next piece, then do this one */
+		next = min(blkcnt - done, chunk);
+		if (blks_read == cur && next)
+			blk_dread_async(block_dev, start + done, next,
+					buffer + done * blksz);
+		hash_stream_update(buf, blks_read * blksz);
+		ret = func ? func(priv, buf, blks_read * blksz) : 0;
+		if (blks_read != cur || ret)
+			break;
+		cur = next;
+	} while (cur);
+
+	/* If we stopped early, let the device finish what it was doing */
+	if (block_dev->async.active)
+		blk_finish_read(block_dev);
+	if (ret < 0)
+		return ret;
+
+	return done;
+}
+
 unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt, const void *buffer)
 {
@@ -540,8 +684,18 @@ int blk_unbind_all(int if_type)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+	blkcache_remove(desc->if_type, desc->devnum);
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+	.pre_remove	= blk_pre_remove,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
 };
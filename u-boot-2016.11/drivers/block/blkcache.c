@@ -8,67 +8,140 @@
 #include <config.h>
 #include <common.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
 
+/*
+ * The cache holds individual blocks, indexed by a hash of (iftype, devnum,
+ * lba) and kept on a single MRU list for eviction. Its size is bounded by a
+ * byte budget rather than an entry count, so a few large metadata reads do
+ * not push out everything else.
+ */
+#define BLKCACHE_HASH_BITS	8
+#define BLKCACHE_HASH_SIZE	(1 << BLKCACHE_HASH_BITS)
+
 struct block_cache_node {
+	struct hlist_node hn;
 	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t lba;
 	unsigned long blksz;
-	char *cache;
+	char cache[0];
+};
+
+struct block_cache_dev {
+	struct list_head lh;
+	struct block_cache_dev_stats stats;
+	lbaint_t next; /* block following the last read */
 };
 
+static struct hlist_head block_cache_hash[BLKCACHE_HASH_SIZE];
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 2,
-	.max_entries = 32
+	.max_bytes = CONFIG_BLOCK_CACHE_SIZE,
+	.max_blocks_per_read = CONFIG_BLOCK_CACHE_MAX_BLOCKS,
+	.readahead = CONFIG_BLOCK_CACHE_READAHEAD,
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+static unsigned int cache_hash(int iftype, int devnum, lbaint_t lba)
+{
+	u32 key = (u32)lba ^ (u32)((u64)lba >> 32);
+
+	key ^= (iftype << 24) ^ (devnum << 16);
+	/* Fibonacci hashing spreads runs of adjacent LBAs over all buckets */
+	return (key * 0x9e3779b1) >> (32 - BLKCACHE_HASH_BITS);
+}
+
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *dev;
+
+	list_for_each_entry(dev, &block_cache_devs, lh)
+		if (dev->stats.iftype == iftype && dev->stats.devnum == devnum)
+			return dev;
+	if (!create)
+		return NULL;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return NULL;
+	dev->stats.iftype = iftype;
+	dev->stats.devnum = devnum;
+	list_add_tail(&dev->lh, &block_cache_devs);
+
+	return dev;
+}
+
+static struct block_cache_node *cache_lookup(int iftype, int devnum,
+					     lbaint_t lba,
+					     unsigned long blksz)
 {
+	struct hlist_head *head;
 	struct block_cache_node *node;
+	struct hlist_node *pos;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
+	head = &block_cache_hash[cache_hash(iftype, devnum, lba)];
+	hlist_for_each(pos, head) {
+		node = hlist_entry(pos, struct block_cache_node, hn);
+		if ((node->lba == lba) &&
+		    (node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+		    (node->blksz == blksz))
 			return node;
-		}
-	return 0;
+	}
+
+	return NULL;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	debug("drop: lba " LBAF "\n", node->lba);
+	hlist_del(&node->hn);
+	list_del(&node->lh);
+	_stats.entries--;
+	_stats.bytes -= node->blksz;
+	free(node);
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_dev *dev = cache_dev(iftype, devnum, false);
+	struct block_cache_node *node;
+	lbaint_t i;
+
+	for (i = 0; i < blkcnt; i++) {
+		if (!cache_lookup(iftype, devnum, start + i, blksz))
+			goto miss;
+	}
+
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_lookup(iftype, devnum, start + i, blksz);
+		memcpy(buffer + i * blksz, node->cache, blksz);
+		/* maintain MRU ordering */
+		list_move(&node->lh, &block_cache);
+	}
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	if (dev) {
+		dev->stats.hits++;
+		dev->next = start + blkcnt;
 	}
+	return 1;
 
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (dev)
+		dev->stats.misses++;
 	return 0;
 }
 
@@ -76,98 +149,166 @@ void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
+	struct block_cache_dev *dev = cache_dev(iftype, devnum, true);
 	struct block_cache_node *node;
+	lbaint_t i;
+
+	if (dev) {
+		dev->stats.reads++;
+		dev->stats.blocks += blkcnt;
+		dev->next = start + blkcnt;
+	}
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > _stats.max_blocks_per_read ||
+	    blkcnt * blksz > _stats.max_bytes)
 		return;
 
-	if (_stats.max_entries == 0)
-		return;
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_lookup(iftype, devnum, start + i, blksz);
+		if (node) {
+			list_move(&node->lh, &block_cache);
+		} else {
+			while (_stats.bytes + blksz > _stats.max_bytes) {
+				/* pop LRU */
+				cache_drop(list_entry(block_cache.prev,
+						      struct block_cache_node,
+						      lh));
+			}
+			node = malloc(sizeof(*node) + blksz);
+			if (!node)
+				return;
+			node->iftype = iftype;
+			node->devnum = devnum;
+			node->lba = start + i;
+			node->blksz = blksz;
+			hlist_add_head(&node->hn, &block_cache_hash[
+				       cache_hash(iftype, devnum, node->lba)]);
+			list_add(&node->lh, &block_cache);
+			_stats.entries++;
+			_stats.bytes += blksz;
 		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
+		memcpy(node->cache, buffer + i * blksz, blksz);
 	}
+}
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
+ulong blkcache_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer,
+			  ulong (*read)(struct blk_desc *block_dev,
+					lbaint_t start, lbaint_t blkcnt,
+					void *buffer))
+{
+	struct block_cache_dev *dev;
+	unsigned long blksz = block_dev->blksz;
+	lbaint_t count = _stats.readahead;
+	ulong blks_read;
+	void *buf;
+
+	/* only a sequential stream of small reads gets read ahead */
+	if (!count || blkcnt >= count || count > _stats.max_blocks_per_read)
+		return 0;
+	dev = cache_dev(block_dev->if_type, block_dev->devnum, false);
+	if (!dev || dev->next != start)
+		return 0;
+	if (block_dev->lba && start + count > block_dev->lba)
+		count = block_dev->lba - start;
+	if (count <= blkcnt)
+		return 0;
+
+	buf = malloc_cache_aligned(count * blksz);
+	if (!buf)
+		return 0;
+
+	blks_read = read(block_dev, start, count, buf);
+	if (blks_read != count) {
+		free(buf);
+		return 0;
 	}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+	debug("read ahead: start " LBAF ", count " LBAFU "\n",
+	      start, count);
+	blkcache_fill(block_dev->if_type, block_dev->devnum, start, count,
+		      blksz, buf);
+	dev->stats.readaheads++;
+	dev->next = start + blkcnt;
+	memcpy(buffer, buf, blkcnt * blksz);
+	free(buf);
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	return blkcnt;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *dev;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
 		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+		    (node->devnum == devnum))
+			cache_drop(node);
+	}
+
+	dev = cache_dev(iftype, devnum, false);
+	if (dev)
+		dev->next = 0;
+}
+
+void blkcache_remove(int iftype, int devnum)
+{
+	struct block_cache_dev *dev;
+
+	blkcache_invalidate(iftype, devnum);
+	dev = cache_dev(iftype, devnum, false);
+	if (dev) {
+		list_del(&dev->lh);
+		free(dev);
 	}
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned max_bytes, unsigned blocks)
 {
-	struct block_cache_node *node;
-	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
+	struct block_cache_node *node, *n;
+
+	if ((max_bytes != _stats.max_bytes) ||
+	    (blocks != _stats.max_blocks_per_read)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+		list_for_each_entry_safe(node, n, &block_cache, lh)
+			cache_drop(node);
 	}
 
-	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.max_bytes = max_bytes;
+	_stats.max_blocks_per_read = blocks;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
 }
 
+void blkcache_set_readahead(unsigned blocks)
+{
+	_stats.readahead = blocks;
+}
+
 void blkcache_stats(struct block_cache_stats *stats)
 {
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
 }
+
+void blkcache_dev_stats(void (*func)(struct block_cache_dev_stats *dev))
+{
+	struct block_cache_dev *dev;
+	int iftype, devnum;
+
+	list_for_each_entry(dev, &block_cache_devs, lh) {
+		func(&dev->stats);
+		iftype = dev->stats.iftype;
+		devnum = dev->stats.devnum;
+		memset(&dev->stats, '\0', sizeof(dev->stats));
+		dev->stats.iftype = iftype;
+		dev->stats.devnum = devnum;
+	}
+}
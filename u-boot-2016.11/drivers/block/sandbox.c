@@ -61,6 +61,53 @@ static unsigned long host_block_read(struct blk_desc *block_dev,
 }
 
 #ifdef CONFIG_BLK
+/* This runs in a host thread, so must not use anything but the file */
+static void *host_block_read_thread(void *arg)
+{
+	struct host_block_dev *host_dev = arg;
+	ssize_t len;
+
+	host_dev->result = -EIO;
+	if (os_lseek(host_dev->fd, host_dev->start * host_dev->blksz,
+		     OS_SEEK_SET) == -1)
+		return NULL;
+	len = os_read(host_dev->fd, host_dev->buffer,
+		      host_dev->blkcnt * host_dev->blksz);
+	if (len >= 0)
+		host_dev->result = len / host_dev->blksz;
+
+	return NULL;
+}
+
+static int host_block_read_async(struct udevice *dev, lbaint_t start,
+				 lbaint_t blkcnt, void *buffer)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+
+	if (host_dev->thread)
+		return -EBUSY;
+	host_dev->start = start;
+	host_dev->blkcnt = blkcnt;
+	host_dev->blksz = block_dev->blksz;
+	host_dev->buffer = buffer;
+
+	return os_thread_create(&host_dev->thread, host_block_read_thread,
+				host_dev);
+}
+
+static unsigned long host_block_wait(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+
+	if (!host_dev->thread)
+		return -EINVAL;
+	os_thread_join(host_dev->thread);
+	host_dev->thread = NULL;
+
+	return host_dev->result;
+}
+
 static unsigned long host_block_write(struct udevice *dev,
 				      unsigned long start, lbaint_t blkcnt,
 				      const void *buffer)
@@ -219,8 +266,10 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 
 #ifdef CONFIG_BLK
 static const struct blk_ops sandbox_host_blk_ops = {
-	.read	= host_block_read,
-	.write	= host_block_write,
+	.read		= host_block_read,
+	.read_async	= host_block_read_async,
+	.wait		= host_block_wait,
+	.write		= host_block_write,
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
@@ -111,6 +111,7 @@ int device_unbind(struct udevice *dev)
 		list_del(&dev->sibling_node);
 
 	devres_release_all(dev);
+	dm_probe_stats_unbind(dev);
 
 	if (dev->flags & DM_FLAG_NAME_ALLOCED)
 		free((char *)dev->name);
@@ -264,16 +264,13 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int size = 0;
 	int ret;
 	int seq;
 
-	if (!dev)
-		return -EINVAL;
-
 	if (dev->flags & DM_FLAG_ACTIVATED)
 		return 0;
 
@@ -391,6 +388,21 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	struct dm_probe_frame frame;
+	int ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	dm_probe_stats_start(dev, &frame);
+	ret = device_do_probe(dev);
+	dm_probe_stats_end(&frame, ret);
+
+	return ret;
+}
+
 void *dev_get_platdata(struct udevice *dev)
 {
 	if (!dev) {
@@ -16,7 +16,154 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#if CONFIG_IS_ENABLED(DM_DRIVER_INDEX)
+/*
+ * An open-addressing hash table from driver names and compatible strings
+ * to drivers, so that binding a device does not compare strings with
+ * every driver. Slots hold list positions rather than pointers, which
+ * keeps them small. Where several drivers share a key the first one in
+ * the linker list is kept, which is what a linear search finds.
+ *
+ * The table is built on first use after relocation. Before that, early
+ * malloc() space is small and only a few devices are bound, so the
+ * linear search is used.
+ */
+#define INDEX_EMPTY	0xffff	/* driver value for an unused slot */
+#define INDEX_NAME	0xffff	/* match value for a driver name key */
+
+struct driver_index_slot {
+	u16 driver;	/* position in the driver list */
+	u16 match;	/* position in its of_match[], or INDEX_NAME */
+};
+
+static struct driver_index_slot *driver_index;
+static unsigned int driver_index_mask;
+static struct driver *driver_index_list;
+
+static unsigned int driver_index_hash(const char *key)
+{
+	u32 hash = 2166136261U;
+
+	/* FNV-1a */
+	while (*key) {
+		hash ^= (u8)*key++;
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+static const char *driver_index_key(const struct driver_index_slot *slot)
+{
+	struct driver *drv = driver_index_list + slot->driver;
+
+	return slot->match == INDEX_NAME ? drv->name :
+		drv->of_match[slot->match].compatible;
+}
+
+/* Find the slot holding @key, or the empty slot where it would go */
+static struct driver_index_slot *driver_index_find(const char *key,
+						   bool is_name)
+{
+	struct driver_index_slot *slot;
+	unsigned int i;
+
+	for (i = driver_index_hash(key); ; i++) {
+		slot = &driver_index[i & driver_index_mask];
+		if (slot->driver == INDEX_EMPTY)
+			return slot;
+		if ((slot->match == INDEX_NAME) == is_name &&
+		    !strcmp(driver_index_key(slot), key))
+			return slot;
+	}
+}
+
+static void driver_index_add(int driver, int match, const char *key)
+{
+	struct driver_index_slot *slot;
+
+	slot = driver_index_find(key, match == INDEX_NAME);
+	if (slot->driver == INDEX_EMPTY) {
+		slot->driver = driver;
+		slot->match = match;
+	}
+}
+
+static bool driver_index_init(struct driver *drv, int n_ents)
+{
+	const struct udevice_id *of_id;
+	unsigned int keys, size;
+	int i;
+
+	/* BSS, and so driver_index, is not usable before relocation */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return false;
+	if (driver_index)
+		return true;
+	if (n_ents >= INDEX_EMPTY)
+		return false;
+
+	keys = n_ents;
+	for (i = 0; i < n_ents; i++) {
+		for (of_id = drv[i].of_match; of_id && of_id->compatible;
+		     of_id++)
+			keys++;
+	}
+
+	/* Keep the table at most half full so that probes stay short */
+	size = roundup_pow_of_two(keys * 2);
+	driver_index = malloc(size * sizeof(*driver_index));
+	if (!driver_index)
+		return false;
+	memset(driver_index, 0xff, size * sizeof(*driver_index));
+	driver_index_mask = size - 1;
+	driver_index_list = drv;
+
+	for (i = 0; i < n_ents; i++) {
+		driver_index_add(i, INDEX_NAME, drv[i].name);
+		for (of_id = drv[i].of_match; of_id && of_id->compatible;
+		     of_id++)
+			driver_index_add(i, of_id - drv[i].of_match,
+					 of_id->compatible);
+	}
+	debug("%s: %u keys in %u slots\n", __func__, keys, size);
+
+	return true;
+}
+
+static struct driver *driver_index_lookup(const char *key, bool is_name,
+					  const struct udevice_id **of_idp)
+{
+	struct driver_index_slot *slot;
+	struct driver *drv;
+
+	slot = driver_index_find(key, is_name);
+	if (slot->driver == INDEX_EMPTY)
+		return NULL;
+	drv = driver_index_list + slot->driver;
+	if (of_idp)
+		*of_idp = &drv->of_match[slot->match];
+
+	return drv;
+}
+#else
+static bool driver_index_init(struct driver *drv, int n_ents)
+{
+	return false;
+}
+
+static struct driver *driver_index_lookup(const char *key, bool is_name,
+					  const struct udevice_id **of_idp)
+{
+	return NULL;
+}
+#endif
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -25,6 +172,9 @@ struct driver *lists_driver_lookup_name(const char *name)
 	const int n_ents = ll_entry_count(struct driver, driver);
 	struct driver *entry;
 
+	if (driver_index_init(drv, n_ents))
+		return driver_index_lookup(name, true, NULL);
+
 	for (entry = drv; entry != drv + n_ents; entry++) {
 		if (!strcmp(name, entry->name))
 			return entry;
@@ -126,11 +276,27 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+	if (driver_index_init(drv, n_ents))
+		return driver_index_lookup(compat, false, of_idp);
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
 int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 		   struct udevice **devp)
 {
-	struct driver *driver = ll_entry_start(struct driver, driver);
-	const int n_ents = ll_entry_count(struct driver, driver);
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -166,13 +332,8 @@ int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 		dm_dbg("   - attempt to match compatible string '%s'\n",
 		       compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		dm_dbg("   - found match at '%s'\n", entry->name);
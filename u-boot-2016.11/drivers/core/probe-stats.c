@@ -0,0 +1,197 @@
+/*
+ * Probe timing and dependency tracking for driver model
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/util.h>
+#include <linux/list.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct dm_probe_dep - A device which was probed by another one
+ *
+ * @node: Entry in probe_deps
+ * @dev: Device whose probe needed @dep
+ * @dep: Device which @dev needed
+ */
+struct dm_probe_dep {
+	struct list_head node;
+	struct udevice *dev;
+	struct udevice *dep;
+};
+
+static struct dm_probe_frame *probe_top;
+static int probe_order;
+static LIST_HEAD(probe_deps);
+
+static ulong probe_time_us(void)
+{
+#ifdef CONFIG_TIMER
+	/* Reading the time would probe the timer, which may be under way */
+	if (!gd->timer)
+		return 0;
+#endif
+	return timer_get_us();
+}
+
+bool dm_probe_stats_needs(struct udevice *dev, struct udevice *dep)
+{
+	struct dm_probe_dep *pd;
+
+	list_for_each_entry(pd, &probe_deps, node) {
+		if (pd->dev == dev && pd->dep == dep)
+			return true;
+	}
+
+	return false;
+}
+
+static void probe_add_dep(struct udevice *dev, struct udevice *dep)
+{
+	struct dm_probe_dep *pd;
+
+	if (dm_probe_stats_needs(dev, dep))
+		return;
+	pd = malloc(sizeof(*pd));
+	if (!pd)
+		return;
+	pd->dev = dev;
+	pd->dep = dep;
+	list_add_tail(&pd->node, &probe_deps);
+}
+
+void dm_probe_stats_start(struct udevice *dev, struct dm_probe_frame *frame)
+{
+	struct udevice *cur;
+
+	frame->dev = NULL;
+
+	/* BSS, and so probe_top, is not usable until we are relocated */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	cur = probe_top ? probe_top->dev : NULL;
+
+	/* Links between parent and child are already shown by 'dm tree' */
+	if (cur && cur != dev && cur != dev->parent && cur->parent != dev)
+		probe_add_dep(cur, dev);
+	if (device_active(dev))
+		return;
+
+	frame->up = probe_top;
+	frame->dev = dev;
+	frame->start = probe_time_us();
+	frame->nested = 0;
+	frame->order = probe_order;
+	probe_top = frame;
+}
+
+void dm_probe_stats_end(struct dm_probe_frame *frame, int ret)
+{
+	struct dm_probe_stats *stats;
+	ulong total = 0;
+
+	if (!frame->dev)
+		return;
+	probe_top = frame->up;
+	if (ret || !device_active(frame->dev))
+		return;
+
+	/* Nothing is timed until the timer itself has been probed */
+	if (frame->start)
+		total = probe_time_us() - frame->start;
+	if (probe_top)
+		probe_top->nested += total;
+
+	/* The device may have been probed again by its parent's probe */
+	stats = &frame->dev->probe_stats;
+	if (stats->order > frame->order)
+		return;
+	stats->total_us = total;
+	stats->self_us = total - min(frame->nested, total);
+	stats->order = ++probe_order;
+}
+
+void dm_probe_stats_unbind(struct udevice *dev)
+{
+	struct dm_probe_dep *pd, *next;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+	list_for_each_entry_safe(pd, next, &probe_deps, node) {
+		if (pd->dev == dev || pd->dep == dev) {
+			list_del(&pd->node);
+			free(pd);
+		}
+	}
+}
+
+static int probe_count(struct udevice *dev, struct udevice **list, int count)
+{
+	struct udevice *child;
+
+	if (dev->probe_stats.order) {
+		if (list)
+			list[count] = dev;
+		count++;
+	}
+	list_for_each_entry(child, &dev->child_head, sibling_node)
+		count = probe_count(child, list, count);
+
+	return count;
+}
+
+static int probe_order_cmp(const void *a, const void *b)
+{
+	const struct udevice *deva = *(const struct udevice **)a;
+	const struct udevice *devb = *(const struct udevice **)b;
+
+	return deva->probe_stats.order - devb->probe_stats.order;
+}
+
+void dm_dump_probe_stats(void)
+{
+	struct udevice *root = dm_root();
+	struct udevice **list;
+	struct dm_probe_dep *pd;
+	char class_name[12];
+	ulong total = 0;
+	int count, i;
+
+	if (!root)
+		return;
+	count = probe_count(root, NULL, 0);
+	list = malloc(count * sizeof(*list));
+	if (!list)
+		return;
+	probe_count(root, list, 0);
+	qsort(list, count, sizeof(*list), probe_order_cmp);
+
+	printf(" Order  Total us   Self us  Class       Name\n");
+	printf("--------------------------------------------------\n");
+	for (i = 0; i < count; i++) {
+		struct udevice *dev = list[i];
+		struct dm_probe_stats *stats = &dev->probe_stats;
+
+		strlcpy(class_name, dev->uclass->uc_drv->name,
+			sizeof(class_name));
+		printf(" %5d  %8lu  %8lu  %-11s %s\n", stats->order,
+		       stats->total_us, stats->self_us, class_name, dev->name);
+		total += stats->self_us;
+	}
+	printf("%d devices probed in %lu us\n", count, total);
+	free(list);
+
+	if (list_empty(&probe_deps))
+		return;
+	printf("\nDevices probed by other devices:\n");
+	list_for_each_entry(pd, &probe_deps, node)
+		printf(" %s -> %s\n", pd->dev->name, pd->dep->name);
+}
@@ -6,11 +6,13 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <dm.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/root.h>
+#include <dm/uclass-internal.h>
 #include "mmc_private.h"
 
 #ifdef CONFIG_DM_MMC_OPS
@@ -31,6 +33,31 @@ int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return ret;
 }
 
+int dm_mmc_send_cmd_async(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	if (!ops->send_cmd_async || !ops->wait_data)
+		return -ENOSYS;
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->send_cmd_async(dev, cmd, data);
+	mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int dm_mmc_wait_data(struct udevice *dev, struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->wait_data)
+		return -ENOSYS;
+	return ops->wait_data(dev, data);
+}
+
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
@@ -136,11 +163,20 @@ void mmc_do_preinit(void)
 {
 	struct udevice *dev;
 	struct uclass *uc;
+	struct mmc **list;
+	int count = 0;
 	int ret;
 
 	ret = uclass_get(UCLASS_MMC, &uc);
 	if (ret)
 		return;
+	uclass_foreach_dev(dev, uc)
+		count++;
+	list = malloc(count * sizeof(*list));
+	if (!list)
+		return;
+
+	count = 0;
 	uclass_foreach_dev(dev, uc) {
 		struct mmc *m = mmc_get_mmc_dev(dev);
 
@@ -149,9 +185,11 @@ void mmc_do_preinit(void)
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 		mmc_set_preinit(m, 1);
 #endif
-		if (m->preinit)
-			mmc_start_init(m);
+		if (m->preinit || IS_ENABLED(CONFIG_MMC_PARALLEL_INIT))
+			list[count++] = m;
 	}
+	mmc_preinit_devices(list, count);
+	free(list);
 }
 
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
@@ -161,16 +199,32 @@ void print_mmc_devices(char separator)
 	char *mmc_type;
 	bool first = true;
 
+#ifdef CONFIG_DM_LAZY_PROBE
+	/* Don't probe devices just to list them */
+	for (uclass_find_first_device(UCLASS_MMC, &dev);
+	     dev;
+	     uclass_find_next_device(&dev), first = false) {
+#else
 	for (uclass_first_device(UCLASS_MMC, &dev);
 	     dev;
 	     uclass_next_device(&dev), first = false) {
+#endif
 		struct mmc *m = mmc_get_mmc_dev(dev);
+		struct blk_desc *desc;
+		struct udevice *bdev;
 
 		if (!first) {
 			printf("%c", separator);
 			if (separator != '\n')
 				puts(" ");
 		}
+		if (!m) {
+			/* Not probed yet, so all we have is the block device */
+			device_find_first_child(dev, &bdev);
+			desc = bdev ? dev_get_uclass_platdata(bdev) : NULL;
+			printf("%s: %d", dev->name, desc ? desc->devnum : -1);
+			continue;
+		}
 		if (m->has_init)
 			mmc_type = IS_SD(m) ? "SD" : "eMMC";
 		else
@@ -249,6 +303,10 @@ static int mmc_select_hwpart(struct udevice *bdev, int hwpart)
 
 static const struct blk_ops mmc_blk_ops = {
 	.read	= mmc_bread,
+#ifdef CONFIG_DM_MMC_OPS
+	.read_async	= mmc_bread_async,
+	.wait	= mmc_bwait,
+#endif
 #ifndef CONFIG_SPL_BUILD
 	.write	= mmc_bwrite,
 	.erase	= mmc_berase,
@@ -186,55 +186,116 @@ int mmc_send_status(struct mmc *mmc, int timeout)
 int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
+	int err;
 
-	if (mmc->ddr_mode)
+	if (mmc->ddr_mode || mmc->cur_bl_len == len)
 		return 0;
 
 	cmd.cmdidx = MMC_CMD_SET_BLOCKLEN;
 	cmd.resp_type = MMC_RSP_R1;
 	cmd.cmdarg = len;
 
-	return mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	mmc->cur_bl_len = err ? 0 : len;
+
+	return err;
 }
 
-static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
-			   lbaint_t blkcnt)
+/*
+ * Tell the card how many blocks the next multi-block transfer has, so that
+ * it ends by itself and no STOP_TRANSMISSION is needed
+ */
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
-	struct mmc_data data;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = blkcnt;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
+/* Get the largest number of blocks to move with one command */
+lbaint_t mmc_max_blocks(struct mmc *mmc)
+{
+	if (mmc->card_caps & MMC_MODE_CMD23)
+		return min_t(lbaint_t, mmc->cfg->b_max, MMC_CMD23_MAX_BLOCKS);
+
+	return mmc->cfg->b_max;
+}
+
+/*
+ * Set up a read command, sending CMD23 first if the card has it. Returns 1
+ * if CMD12 is needed once the data has arrived, 0 if not, -ve on error.
+ */
+static int mmc_prepare_read(struct mmc *mmc, struct mmc_cmd *cmd,
+			    struct mmc_data *data, void *dst, lbaint_t start,
+			    lbaint_t blkcnt)
+{
+	int stop = 0;
+
+	if (blkcnt > 1 && (mmc->card_caps & MMC_MODE_CMD23)) {
+		if (mmc_set_block_count(mmc, blkcnt))
+			return -EIO;
+	} else if (blkcnt > 1) {
+		stop = 1;
+	}
 
 	if (blkcnt > 1)
-		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
 	else
-		cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
 
 	if (mmc->high_capacity)
-		cmd.cmdarg = start;
+		cmd->cmdarg = start;
 	else
-		cmd.cmdarg = start * mmc->read_bl_len;
+		cmd->cmdarg = start * mmc->read_bl_len;
 
-	cmd.resp_type = MMC_RSP_R1;
+	cmd->resp_type = MMC_RSP_R1;
 
-	data.dest = dst;
-	data.blocks = blkcnt;
-	data.blocksize = mmc->read_bl_len;
-	data.flags = MMC_DATA_READ;
+	data->dest = dst;
+	data->blocks = blkcnt;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
-		return 0;
+	return stop;
+}
 
-	if (blkcnt > 1) {
-		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
-		cmd.cmdarg = 0;
-		cmd.resp_type = MMC_RSP_R1b;
-		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+static int mmc_stop_read(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+	cmd.cmdarg = 0;
+	cmd.resp_type = MMC_RSP_R1b;
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-			printf("mmc fail to send stop cmd\n");
+		printf("mmc fail to send stop cmd\n");
 #endif
-			return 0;
-		}
+		return -EIO;
 	}
 
+	return 0;
+}
+
+static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
+			   lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	int stop;
+
+	stop = mmc_prepare_read(mmc, &cmd, &data, dst, start, blkcnt);
+	if (stop < 0)
+		return 0;
+
+	if (mmc_send_cmd(mmc, &cmd, &data))
+		return 0;
+
+	if (stop && mmc_stop_read(mmc))
+		return 0;
+
 	return blkcnt;
 }
 
@@ -250,7 +311,7 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 #endif
 	int dev_num = block_dev->devnum;
 	int err;
-	lbaint_t cur, blocks_todo = blkcnt;
+	lbaint_t cur, max, blocks_todo = blkcnt;
 
 	if (blkcnt == 0)
 		return 0;
@@ -276,9 +337,9 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 	}
 
+	max = mmc_max_blocks(mmc);
 	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
+		cur = min(blocks_todo, max);
 		if (mmc_read_blocks(mmc, dst, start, cur) != cur) {
 			debug("%s: Failed to read blocks\n", __func__);
 			return 0;
@@ -291,6 +352,64 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	return blkcnt;
 }
 
+#if defined(CONFIG_BLK) && defined(CONFIG_DM_MMC_OPS)
+/*
+ * Start a read which the host completes by DMA in the background. Only a
+ * read which fits in one command and covers whole cache lines is done like
+ * this; the block layer does anything else with mmc_bread(). Those checks
+ * come before any command is sent, so that a refused read leaves nothing
+ * behind on the card.
+ */
+int mmc_bread_async(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+		    void *dst)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	struct mmc_cmd cmd;
+	int stop, err;
+
+	if (!mmc || !mmc_get_ops(mmc->dev)->send_cmd_async)
+		return -ENOSYS;
+	if (!blkcnt || blkcnt > mmc_max_blocks(mmc) ||
+	    start + blkcnt > block_dev->lba)
+		return -EINVAL;
+	if (!IS_ALIGNED((ulong)dst | blkcnt * mmc->read_bl_len,
+			ARCH_DMA_MINALIGN))
+		return -ENOSYS;
+
+	err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+	if (err < 0)
+		return err;
+	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
+		return -EIO;
+
+	stop = mmc_prepare_read(mmc, &cmd, &mmc->async_data, dst, start,
+				blkcnt);
+	if (stop < 0)
+		return stop;
+	mmc->async_stop = stop;
+
+	return dm_mmc_send_cmd_async(mmc->dev, &cmd, &mmc->async_data);
+}
+
+ulong mmc_bwait(struct udevice *dev)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+
+	if (!mmc)
+		return 0;
+	if (dm_mmc_wait_data(mmc->dev, &mmc->async_data)) {
+		debug("%s: Failed to read blocks\n", __func__);
+		return 0;
+	}
+	if (mmc->async_stop && mmc_stop_read(mmc))
+		return 0;
+
+	return mmc->async_data.blocks;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -298,6 +417,9 @@ static int mmc_go_idle(struct mmc *mmc)
 
 	udelay(1000);
 
+	/* Forget the block length, since the card is being reset */
+	mmc->cur_bl_len = 0;
+
 	cmd.cmdidx = MMC_CMD_GO_IDLE_STATE;
 	cmd.cmdarg = 0;
 	cmd.resp_type = MMC_RSP_NONE;
@@ -312,51 +434,50 @@ static int mmc_go_idle(struct mmc *mmc)
 	return 0;
 }
 
-static int sd_send_op_cond(struct mmc *mmc)
+/* Send ACMD41 once, returning -EBUSY if the card is still powering up */
+static int sd_send_op_cond_iter(struct mmc *mmc)
 {
-	int timeout = 1000;
-	int err;
 	struct mmc_cmd cmd;
+	int err;
 
-	while (1) {
-		cmd.cmdidx = MMC_CMD_APP_CMD;
-		cmd.resp_type = MMC_RSP_R1;
-		cmd.cmdarg = 0;
-
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	cmd.cmdidx = MMC_CMD_APP_CMD;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
 
-		if (err)
-			return err;
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
-		cmd.resp_type = MMC_RSP_R3;
+	if (err)
+		return err;
 
-		/*
-		 * Most cards do not answer if some reserved bits
-		 * in the ocr are set. However, Some controller
-		 * can set bit 7 (reserved for low voltages), but
-		 * how to manage low voltages SD card is not yet
-		 * specified.
-		 */
-		cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
-			(mmc->cfg->voltages & 0xff8000);
+	cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
 
-		if (mmc->version == SD_VERSION_2)
-			cmd.cmdarg |= OCR_HCS;
+	/*
+	 * Most cards do not answer if some reserved bits
+	 * in the ocr are set. However, Some controller
+	 * can set bit 7 (reserved for low voltages), but
+	 * how to manage low voltages SD card is not yet
+	 * specified.
+	 */
+	cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
+		(mmc->cfg->voltages & 0xff8000);
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	if (mmc->version == SD_VERSION_2)
+		cmd.cmdarg |= OCR_HCS;
 
-		if (err)
-			return err;
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		if (cmd.response[0] & OCR_BUSY)
-			break;
+	if (err)
+		return err;
+	mmc->ocr = cmd.response[0];
 
-		if (timeout-- <= 0)
-			return -EOPNOTSUPP;
+	return mmc->ocr & OCR_BUSY ? 0 : -EBUSY;
+}
 
-		udelay(1000);
-	}
+static int sd_finish_op_cond(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
 
 	if (mmc->version != SD_VERSION_2)
 		mmc->version = SD_VERSION_1_0;
@@ -370,9 +491,9 @@ static int sd_send_op_cond(struct mmc *mmc)
 
 		if (err)
 			return err;
-	}
 
-	mmc->ocr = cmd.response[0];
+		mmc->ocr = cmd.response[0];
+	}
 
 	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
 	mmc->rca = 0;
@@ -380,6 +501,24 @@ static int sd_send_op_cond(struct mmc *mmc)
 	return 0;
 }
 
+static int sd_send_op_cond(struct mmc *mmc)
+{
+	int err;
+
+	err = sd_send_op_cond_iter(mmc);
+	if (err == -EBUSY) {
+		/* Leave the card to power up, see mmc_poll_op_cond() */
+		mmc->op_cond_pending = 1;
+		mmc->op_cond_sd = 1;
+		mmc->op_cond_start = get_timer(0);
+		return 0;
+	}
+	if (err)
+		return err;
+
+	return sd_finish_op_cond(mmc);
+}
+
 static int mmc_send_op_cond_iter(struct mmc *mmc, int use_arg)
 {
 	struct mmc_cmd cmd;
@@ -401,6 +540,32 @@ static int mmc_send_op_cond_iter(struct mmc *mmc, int use_arg)
 	return 0;
 }
 
+static int mmc_finish_op_cond(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
+
+	if (mmc_host_is_spi(mmc)) { /* read OCR for spi */
+		cmd.cmdidx = MMC_CMD_SPI_READ_OCR;
+		cmd.resp_type = MMC_RSP_R3;
+		cmd.cmdarg = 0;
+
+		err = mmc_send_cmd(mmc, &cmd, NULL);
+
+		if (err)
+			return err;
+
+		mmc->ocr = cmd.response[0];
+	}
+
+	mmc->version = MMC_VERSION_UNKNOWN;
+
+	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
+	mmc->rca = 1;
+
+	return 0;
+}
+
 static int mmc_send_op_cond(struct mmc *mmc)
 {
 	int err, i;
@@ -416,56 +581,56 @@ static int mmc_send_op_cond(struct mmc *mmc)
 
 		/* exit if not busy (flag seems to be inverted) */
 		if (mmc->ocr & OCR_BUSY)
-			break;
+			return mmc_finish_op_cond(mmc);
 	}
+
+	/* Some cards seem to need this */
+	mmc_go_idle(mmc);
+
 	mmc->op_cond_pending = 1;
+	mmc->op_cond_sd = 0;
+	mmc->op_cond_start = get_timer(0);
 	return 0;
 }
 
-static int mmc_complete_op_cond(struct mmc *mmc)
+/*
+ * Ask a card which is powering up whether it is ready, without waiting.
+ * Returns 0 once it is, -EBUSY if not yet, other -ve on error.
+ */
+static int mmc_poll_op_cond(struct mmc *mmc)
 {
-	struct mmc_cmd cmd;
-	int timeout = 1000;
-	uint start;
 	int err;
 
-	mmc->op_cond_pending = 0;
-	if (!(mmc->ocr & OCR_BUSY)) {
-		/* Some cards seem to need this */
-		mmc_go_idle(mmc);
-
-		start = get_timer(0);
-		while (1) {
-			err = mmc_send_op_cond_iter(mmc, 1);
-			if (err)
-				return err;
-			if (mmc->ocr & OCR_BUSY)
-				break;
-			if (get_timer(start) > timeout)
-				return -EOPNOTSUPP;
-			udelay(100);
-		}
+	if (mmc->op_cond_sd) {
+		err = sd_send_op_cond_iter(mmc);
+	} else {
+		err = mmc_send_op_cond_iter(mmc, 1);
+		if (!err && !(mmc->ocr & OCR_BUSY))
+			err = -EBUSY;
 	}
+	if (err == -EBUSY && get_timer(mmc->op_cond_start) > 1000)
+		err = -EOPNOTSUPP;
+	if (err == -EBUSY)
+		return err;
 
-	if (mmc_host_is_spi(mmc)) { /* read OCR for spi */
-		cmd.cmdidx = MMC_CMD_SPI_READ_OCR;
-		cmd.resp_type = MMC_RSP_R3;
-		cmd.cmdarg = 0;
+	mmc->op_cond_pending = 0;
+	if (err)
+		return err;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	return mmc->op_cond_sd ? sd_finish_op_cond(mmc) :
+		mmc_finish_op_cond(mmc);
+}
 
-		if (err)
-			return err;
+static int mmc_complete_op_cond(struct mmc *mmc)
+{
+	int err;
 
-		mmc->ocr = cmd.response[0];
+	while (1) {
+		err = mmc_poll_op_cond(mmc);
+		if (err != -EBUSY)
+			return err;
+		udelay(mmc->op_cond_sd ? 1000 : 100);
 	}
-
-	mmc->version = MMC_VERSION_UNKNOWN;
-
-	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
-	mmc->rca = 1;
-
-	return 0;
 }
 
 
@@ -529,6 +694,10 @@ static int mmc_change_freq(struct mmc *mmc)
 
 	mmc->card_caps |= MMC_MODE_4BIT | MMC_MODE_8BIT;
 
+	/* CMD23 has been around since 3.1, but only trust it from 4.5 on */
+	if (mmc->version >= MMC_VERSION_4_5)
+		mmc->card_caps |= MMC_MODE_CMD23;
+
 	err = mmc_send_ext_csd(mmc, ext_csd);
 
 	if (err)
@@ -911,6 +1080,8 @@ retry_scr:
 
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
+	if (mmc->scr[0] & SD_CMD23_SUPPORT)
+		mmc->card_caps |= MMC_MODE_CMD23;
 
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
@@ -1629,6 +1800,8 @@ int mmc_start_init(struct mmc *mmc)
 	if (mmc->has_init)
 		return 0;
 
+	mmc->init_start = timer_get_us();
+	mmc->op_cond_pending = 0;
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 	mmc_adapter_card_type_ident();
 #endif
@@ -1691,11 +1864,88 @@ static int mmc_complete_init(struct mmc *mmc)
 
 	if (!err)
 		err = mmc_startup(mmc);
-	if (err)
+	if (err) {
 		mmc->has_init = 0;
-	else
-		mmc->has_init = 1;
-	return err;
+		return err;
+	}
+
+	mmc->has_init = 1;
+	if (!mmc->init_timed) {
+		bootstage_accum_name(mmc->cfg->name,
+				     timer_get_us() - mmc->init_start);
+		mmc->init_timed = 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Take a card as far through its init as possible without waiting.
+ * Returns 0 once it is ready, -EBUSY while it is powering up, other -ve on
+ * error.
+ */
+static int mmc_poll_init(struct mmc *mmc)
+{
+	int err;
+
+	if (mmc->has_init)
+		return 0;
+	if (!mmc->init_in_progress) {
+		err = mmc_start_init(mmc);
+		if (err)
+			return err;
+	}
+	if (mmc->op_cond_pending) {
+		err = mmc_poll_op_cond(mmc);
+		if (err == -EBUSY)
+			return err;
+		if (err) {
+			mmc->init_in_progress = 0;
+			return err;
+		}
+	}
+
+	return mmc_complete_init(mmc);
+}
+
+int mmc_init_devices(struct mmc **list, int count)
+{
+	int busy, failed = 0, err, i;
+	bool *done;
+
+	done = calloc(count, sizeof(*done));
+	if (!done) {
+		/* Fall back to waiting for each card in turn */
+		for (i = 0; i < count; i++)
+			failed += mmc_init(list[i]) != 0;
+		return failed;
+	}
+
+	/* Start everything off, then go round until nothing is busy */
+	do {
+		busy = 0;
+		for (i = 0; i < count; i++) {
+			if (done[i])
+				continue;
+			err = mmc_poll_init(list[i]);
+			if (err == -EBUSY) {
+				busy++;
+				continue;
+			}
+			done[i] = true;
+			if (!err)
+				continue;
+			failed++;
+			if (err != -ENOMEDIUM)
+				printf("%s: init failed (err=%d)\n",
+				       list[i]->cfg->name, err);
+		}
+		if (busy)
+			udelay(100);
+	} while (busy);
+	free(done);
+
+	return failed;
 }
 
 int mmc_init(struct mmc *mmc)
@@ -1744,6 +1994,18 @@ void mmc_set_preinit(struct mmc *mmc, int preinit)
 	mmc->preinit = preinit;
 }
 
+void mmc_preinit_devices(struct mmc **list, int count)
+{
+	int i;
+
+	if (IS_ENABLED(CONFIG_MMC_PARALLEL_INIT)) {
+		mmc_init_devices(list, count);
+		return;
+	}
+	for (i = 0; i < count; i++)
+		mmc_start_init(list[i]);
+}
+
 #if defined(CONFIG_DM_MMC) && defined(CONFIG_SPL_BUILD)
 static int mmc_probe(bd_t *bis)
 {
@@ -1760,6 +2022,10 @@ static int mmc_probe(bd_t *bis)
 	if (ret)
 		return ret;
 
+	/* Each device is probed when its block device is first used */
+	if (IS_ENABLED(CONFIG_DM_LAZY_PROBE) && IS_ENABLED(CONFIG_BLK))
+		return 0;
+
 	/*
 	 * Try to add them in sequence order. Really with driver model we
 	 * should allow holes, but the current MMC list does not allow that.
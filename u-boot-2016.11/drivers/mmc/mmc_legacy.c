@@ -49,18 +49,28 @@ int get_mmc_num(void)
 
 void mmc_do_preinit(void)
 {
-	struct mmc *m;
+	struct mmc *m, **list;
 	struct list_head *entry;
+	int count = 0;
+
+	list_for_each(entry, &mmc_devices)
+		count++;
+	list = malloc(count * sizeof(*list));
+	if (!list)
+		return;
 
+	count = 0;
 	list_for_each(entry, &mmc_devices) {
 		m = list_entry(entry, struct mmc, link);
 
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 		mmc_set_preinit(m, 1);
 #endif
-		if (m->preinit)
-			mmc_start_init(m);
+		if (m->preinit || IS_ENABLED(CONFIG_MMC_PARALLEL_INIT))
+			list[count++] = m;
 	}
+	mmc_preinit_devices(list, count);
+	free(list);
 }
 
 void mmc_list_init(void)
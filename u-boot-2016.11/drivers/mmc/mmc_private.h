@@ -16,6 +16,8 @@ extern int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+lbaint_t mmc_max_blocks(struct mmc *mmc);
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -23,6 +25,11 @@ void mmc_adapter_card_type_ident(void);
 #ifdef CONFIG_BLK
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
+#ifdef CONFIG_DM_MMC_OPS
+int mmc_bread_async(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+		    void *dst);
+ulong mmc_bwait(struct udevice *dev);
+#endif
 #else
 ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
@@ -103,6 +110,15 @@ int mmc_get_next_devnum(void);
  */
 void mmc_do_preinit(void);
 
+/**
+ * mmc_preinit_devices() - Start, or with CONFIG_MMC_PARALLEL_INIT finish,
+ * the init of the cards found by mmc_do_preinit()
+ *
+ * @list:	Cards to initialise
+ * @count:	Number of cards in @list
+ */
+void mmc_preinit_devices(struct mmc **list, int count);
+
 /**
  * mmc_list_init() - Set up the list of MMC devices
  */
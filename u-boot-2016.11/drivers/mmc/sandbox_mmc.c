@@ -14,26 +14,64 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#define SANDBOX_MMC_CMDS	64
+#define SANDBOX_MMC_POWERUP	3	/* ACMD41s before the card is ready */
+
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	uint cmd_count[SANDBOX_MMC_CMDS];
+	uint block_count;	/* from SET_BLOCK_COUNT, 0 if none */
+	struct mmc_cmd async_cmd;	/* waiting for sandbox_mmc_wait_data() */
+	uint powerup;		/* ACMD41s still to answer with 'busy' */
+	uint powerup_acmds;	/* value of @powerup after each reset */
+	u64 fail_cmds;		/* bit n set: CMDn fails with -EIO */
 };
 
+/* A transfer must match the block count set for it in advance, if any */
+static int sandbox_mmc_check_count(struct sandbox_mmc_plat *plat,
+				   struct mmc_data *data)
+{
+	uint count = plat->block_count;
+
+	plat->block_count = 0;
+	if (count && count != data->blocks) {
+		debug("%s: expected %u blocks, got %u\n", __func__, count,
+		      data->blocks);
+		return -EIO;
+	}
+
+	return 0;
+}
+
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
  * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * Multiple-block reads return a test string. Writes are discarded. The
+ * card takes a few ACMD41s to power up after a reset. The number of times
+ * each command is sent is counted for tests, which can also make commands
+ * fail.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (cmd->cmdidx < SANDBOX_MMC_CMDS) {
+		plat->cmd_count[cmd->cmdidx]++;
+		if (plat->fail_cmds & 1ULL << cmd->cmdidx)
+			return -EIO;
+	}
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		break;
 	case SD_CMD_SEND_RELATIVE_ADDR:
 		cmd->response[0] = 0 << 16; /* mmc->rca */
+		break;
 	case MMC_CMD_GO_IDLE_STATE:
+		plat->powerup = plat->powerup_acmds;
 		break;
 	case SD_CMD_SEND_IF_COND:
 		cmd->response[0] = 0xaa;
@@ -57,12 +95,27 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		memset(data->dest, '\0', data->blocksize);
 		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
+		if (sandbox_mmc_check_count(plat, data))
+			return -EIO;
 		strcpy(data->dest, "this is a test");
 		break;
+	case MMC_CMD_SET_BLOCK_COUNT:
+		plat->block_count = cmd->cmdarg & MMC_CMD23_MAX_BLOCKS;
+		break;
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
+		break;
+	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		if (sandbox_mmc_check_count(plat, data))
+			return -EIO;
+		break;
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
-		cmd->response[0] = OCR_BUSY | OCR_HCS;
+		cmd->response[0] = OCR_HCS;
+		if (plat->powerup)
+			plat->powerup--;
+		else
+			cmd->response[0] |= OCR_BUSY;
 		cmd->response[1] = 0;
 		cmd->response[2] = 0;
 		break;
@@ -74,7 +127,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, with CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_CMD23_SUPPORT);
 		break;
 	}
 	default:
@@ -85,6 +139,28 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+/*
+ * The command is only carried out when its data is waited for, so that
+ * tests can see that nothing arrives before then
+ */
+static int sandbox_mmc_send_cmd_async(struct udevice *dev,
+				      struct mmc_cmd *cmd,
+				      struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	plat->async_cmd = *cmd;
+
+	return 0;
+}
+
+static int sandbox_mmc_wait_data(struct udevice *dev, struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	return sandbox_mmc_send_cmd(dev, &plat->async_cmd, data);
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -99,12 +175,47 @@ static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+	.send_cmd_async = sandbox_mmc_send_cmd_async,
+	.wait_data = sandbox_mmc_wait_data,
 };
 
+uint sandbox_mmc_get_cmd_count(struct udevice *dev, uint cmdidx)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	return cmdidx < SANDBOX_MMC_CMDS ? plat->cmd_count[cmdidx] : 0;
+}
+
+void sandbox_mmc_reset_cmd_counts(struct udevice *dev)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	memset(plat->cmd_count, '\0', sizeof(plat->cmd_count));
+}
+
+void sandbox_mmc_set_powerup(struct udevice *dev, uint acmds)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	plat->powerup_acmds = acmds;
+}
+
+void sandbox_mmc_set_fail_cmd(struct udevice *dev, uint cmdidx, bool fail)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (fail)
+		plat->fail_cmds |= 1ULL << cmdidx;
+	else
+		plat->fail_cmds &= ~(1ULL << cmdidx);
+}
+
 int sandbox_mmc_probe(struct udevice *dev)
 {
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
 
+	sandbox_mmc_reset_cmd_counts(dev);
+
 	return mmc_init(&plat->mmc);
 }
 
@@ -113,8 +224,10 @@ int sandbox_mmc_bind(struct udevice *dev)
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
 	struct mmc_config *cfg = &plat->cfg;
 
+	plat->powerup_acmds = SANDBOX_MMC_POWERUP;
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+			 MMC_MODE_CMD23;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
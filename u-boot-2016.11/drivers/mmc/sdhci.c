@@ -72,12 +72,6 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 				unsigned int start_addr)
 {
 	unsigned int stat, rdy, mask, timeout, block = 0;
-#ifdef CONFIG_MMC_SDMA
-	unsigned char ctrl;
-	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
-	ctrl &= ~SDHCI_CTRL_DMA_MASK;
-	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
-#endif
 
 	timeout = 1000000;
 	rdy = SDHCI_INT_SPACE_AVAIL | SDHCI_INT_DATA_AVAIL;
@@ -99,7 +93,8 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 				break;
 		}
 #ifdef CONFIG_MMC_SDMA
-		if (stat & SDHCI_INT_DMA_END) {
+		if ((host->flags & SDHCI_USE_SDMA) &&
+		    (stat & SDHCI_INT_DMA_END)) {
 			sdhci_writel(host, SDHCI_INT_DMA_END, SDHCI_INT_STATUS);
 			start_addr &= ~(SDHCI_DEFAULT_BOUNDARY_SIZE - 1);
 			start_addr += SDHCI_DEFAULT_BOUNDARY_SIZE;
@@ -116,6 +111,144 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 	return 0;
 }
 
+#ifdef CONFIG_MMC_SDHCI_ADMA
+static void sdhci_adma_write_desc(struct sdhci_host *host, u8 *desc,
+				  dma_addr_t addr, unsigned int len, bool end)
+{
+	u32 attr = SDHCI_ADMA_DESC_VALID | SDHCI_ADMA_DESC_TRAN;
+	__le32 *d = (__le32 *)desc;
+
+	if (end)
+		attr |= SDHCI_ADMA_DESC_END;
+	/* attribute byte, a reserved byte, then the length */
+	d[0] = cpu_to_le32(attr | (len & 0xffff) << 16);
+	d[1] = cpu_to_le32(lower_32_bits(addr));
+	if (host->flags & SDHCI_USE_ADMA64)
+		d[2] = cpu_to_le32(upper_32_bits(addr));
+}
+
+/*
+ * Describe the caller's buffer to the controller in 64 KiB pieces, so that
+ * a transfer of up to b_max blocks goes in one go without any copying or
+ * stopping at SDMA boundaries.
+ */
+static void sdhci_adma_prepare(struct sdhci_host *host, dma_addr_t addr,
+			       unsigned int len)
+{
+	unsigned int size = host->flags & SDHCI_USE_ADMA64 ?
+			SDHCI_ADMA64_DESC_SIZE : SDHCI_ADMA_DESC_SIZE;
+	dma_addr_t table = (unsigned long)host->adma_table;
+	u8 *desc = host->adma_table;
+	unsigned int chunk;
+
+	do {
+		chunk = min(len, (unsigned int)SDHCI_ADMA_MAX_LEN);
+		len -= chunk;
+		sdhci_adma_write_desc(host, desc, addr, chunk, !len);
+		addr += chunk;
+		desc += size;
+	} while (len);
+
+	flush_cache((unsigned long)host->adma_table,
+		    ALIGN(desc - (u8 *)host->adma_table, ARCH_DMA_MINALIGN));
+	sdhci_writel(host, lower_32_bits(table), SDHCI_ADMA_ADDRESS);
+	if (host->flags & SDHCI_USE_ADMA64)
+		sdhci_writel(host, upper_32_bits(table), SDHCI_ADMA_ADDRESS_HI);
+}
+
+static void sdhci_adma_init(struct sdhci_host *host, struct mmc *mmc)
+{
+	unsigned int count, size;
+
+	if (!(host->flags & SDHCI_USE_ADMA) || host->adma_table)
+		return;
+
+	count = DIV_ROUND_UP(mmc->cfg->b_max * MMC_MAX_BLOCK_LEN,
+			     SDHCI_ADMA_MAX_LEN);
+	size = count * (host->flags & SDHCI_USE_ADMA64 ?
+			SDHCI_ADMA64_DESC_SIZE : SDHCI_ADMA_DESC_SIZE);
+	host->adma_table = memalign(ARCH_DMA_MINALIGN,
+				    ALIGN(size, ARCH_DMA_MINALIGN));
+	if (!host->adma_table) {
+		printf("%s: ADMA descriptor table alloc failed, using %s\n",
+		       __func__, host->flags & SDHCI_USE_SDMA ? "SDMA" : "PIO");
+		host->flags &= ~(SDHCI_USE_ADMA | SDHCI_USE_ADMA64);
+	}
+}
+#endif
+
+#if defined(CONFIG_MMC_SDMA) || defined(CONFIG_MMC_SDHCI_ADMA)
+/* Move the transfer to the bounce buffer, which the controller can reach */
+static void sdhci_bounce(struct mmc_data *data, unsigned long *start_addr,
+			 int *is_aligned, int trans_bytes)
+{
+	*is_aligned = 0;
+	*start_addr = (unsigned long)aligned_buffer;
+	if (data->flags != MMC_DATA_READ)
+		memcpy(aligned_buffer, data->src, trans_bytes);
+}
+
+/*
+ * Set up DMA for a transfer, preferring ADMA2 and falling back to SDMA
+ * (through the bounce buffer if need be). Returns false if the data must
+ * go by PIO instead.
+ */
+static bool sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
+			      unsigned long *start_addr, int *is_aligned,
+			      int trans_bytes)
+{
+	unsigned char ctrl;
+	bool fixed = false, high;
+
+	if (data->flags == MMC_DATA_READ)
+		*start_addr = (unsigned long)data->dest;
+	else
+		*start_addr = (unsigned long)data->src;
+
+	/* Only 64-bit ADMA can reach a buffer which is not in the first 4GiB */
+	high = upper_32_bits((u64)*start_addr + trans_bytes - 1) != 0;
+#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
+	/* The controller can only reach this buffer, so always use it */
+	fixed = true;
+#endif
+
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+
+#ifdef CONFIG_MMC_SDHCI_ADMA
+	/* ADMA2 only needs word alignment, so uses the buffer as it is */
+	if ((host->flags & SDHCI_USE_ADMA) && !(*start_addr & 0x3)) {
+		if (fixed || (high && !(host->flags & SDHCI_USE_ADMA64))) {
+			if (!aligned_buffer)
+				return false;
+			sdhci_bounce(data, start_addr, is_aligned, trans_bytes);
+		}
+		if (host->flags & SDHCI_USE_ADMA64)
+			ctrl |= SDHCI_CTRL_ADMA64;
+		else
+			ctrl |= SDHCI_CTRL_ADMA32;
+		sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+		sdhci_adma_prepare(host, *start_addr, trans_bytes);
+		return true;
+	}
+#endif
+	if (!(host->flags & SDHCI_USE_SDMA))
+		return false;
+
+	if (fixed || high || ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
+			      (*start_addr & 0x7) != 0x0)) {
+		if (!aligned_buffer)
+			return false;
+		sdhci_bounce(data, start_addr, is_aligned, trans_bytes);
+	}
+
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+	sdhci_writel(host, *start_addr, SDHCI_DMA_ADDRESS);
+
+	return true;
+}
+#endif
+
 /*
  * No command will be sent by driver if card is busy, so driver must wait
  * for card ready state.
@@ -127,29 +260,69 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 #define SDHCI_CMD_DEFAULT_TIMEOUT		100
 #define SDHCI_READ_STATUS_TIMEOUT		1000
 
-#ifdef CONFIG_DM_MMC_OPS
-static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+/* Wait for the data of a command, if any, and tidy up after it */
+static int sdhci_finish_command(struct sdhci_host *host, struct mmc_data *data,
+				int ret)
 {
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	unsigned int stat;
 
-#else
-static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+	if (!ret && data)
+		ret = sdhci_transfer_data(host, data, host->start_addr);
+
+	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
+		udelay(1000);
+
+	stat = sdhci_readl(host, SDHCI_INT_STATUS);
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+	if (!ret) {
+		/*
+		 * Drop any lines the CPU fetched while the data was on its
+		 * way, e.g. by prefetching beyond the piece it was working on
+		 */
+		if (host->is_dma && data->flags == MMC_DATA_READ &&
+		    IS_ALIGNED(host->start_addr | host->trans_bytes,
+			       ARCH_DMA_MINALIGN))
+			invalidate_dcache_range(host->start_addr,
+						host->start_addr +
+						host->trans_bytes);
+		if (!host->is_aligned && data->flags == MMC_DATA_READ)
+			memcpy(data->dest, aligned_buffer, host->trans_bytes);
+		return 0;
+	}
+
+	sdhci_reset(host, SDHCI_RESET_CMD);
+	sdhci_reset(host, SDHCI_RESET_DATA);
+	if (stat & SDHCI_INT_TIMEOUT)
+		return -ETIMEDOUT;
+	else
+		return -ECOMM;
+}
+
+/*
+ * Send a command and wait for its response. With @async the data is left
+ * to move by DMA and sdhci_finish_command() is called later, or -ENOSYS is
+ * returned before the command is sent if the data cannot go by DMA.
+ */
+static int sdhci_start_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			       struct mmc_data *data, bool async)
 {
-#endif
 	struct sdhci_host *host = mmc->priv;
 	unsigned int stat = 0;
 	int ret = 0;
-	int trans_bytes = 0, is_aligned = 1;
+	bool dma = false;
 	u32 mask, flags, mode;
-	unsigned int time = 0, start_addr = 0;
+	unsigned int time = 0;
 	int mmc_dev = mmc_get_blk_desc(mmc)->devnum;
 	unsigned start = get_timer(0);
 
 	/* Timeout unit - ms */
 	static unsigned int cmd_timeout = SDHCI_CMD_DEFAULT_TIMEOUT;
 
+	host->start_addr = 0;
+	host->trans_bytes = 0;
+	host->is_aligned = 1;
+	host->is_dma = 0;
+
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	mask = SDHCI_CMD_INHIBIT | SDHCI_DATA_INHIBIT;
 
@@ -197,40 +370,28 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	if (data != 0) {
 		sdhci_writeb(host, 0xe, SDHCI_TIMEOUT_CONTROL);
 		mode = SDHCI_TRNS_BLK_CNT_EN;
-		trans_bytes = data->blocks * data->blocksize;
+		host->trans_bytes = data->blocks * data->blocksize;
 		if (data->blocks > 1)
 			mode |= SDHCI_TRNS_MULTI;
 
 		if (data->flags == MMC_DATA_READ)
 			mode |= SDHCI_TRNS_READ;
 
-#ifdef CONFIG_MMC_SDMA
-		if (data->flags == MMC_DATA_READ)
-			start_addr = (unsigned long)data->dest;
-		else
-			start_addr = (unsigned long)data->src;
-		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				(start_addr & 0x7) != 0x0) {
-			is_aligned = 0;
-			start_addr = (unsigned long)aligned_buffer;
-			if (data->flags != MMC_DATA_READ)
-				memcpy(aligned_buffer, data->src, trans_bytes);
-		}
-
-#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
+#if defined(CONFIG_MMC_SDMA) || defined(CONFIG_MMC_SDHCI_ADMA)
+		dma = sdhci_prepare_dma(host, data, &host->start_addr,
+					&host->is_aligned, host->trans_bytes);
+		if (dma)
+			mode |= SDHCI_TRNS_DMA;
+#endif
+		host->is_dma = dma;
 		/*
-		 * Always use this bounce-buffer when
-		 * CONFIG_FIXED_SDHCI_ALIGNED_BUFFER is defined
+		 * The CPU works on the data next to a background read, so the
+		 * read must cover whole cache lines to be invalidated safely
 		 */
-		is_aligned = 0;
-		start_addr = (unsigned long)aligned_buffer;
-		if (data->flags != MMC_DATA_READ)
-			memcpy(aligned_buffer, data->src, trans_bytes);
-#endif
-
-		sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
-		mode |= SDHCI_TRNS_DMA;
-#endif
+		if (async && (!dma || !IS_ALIGNED(host->start_addr |
+						  host->trans_bytes,
+						  ARCH_DMA_MINALIGN)))
+			return -ENOSYS;
 		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
 				data->blocksize),
 				SDHCI_BLOCK_SIZE);
@@ -241,10 +402,9 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	}
 
 	sdhci_writel(host, cmd->cmdarg, SDHCI_ARGUMENT);
-#ifdef CONFIG_MMC_SDMA
-	trans_bytes = ALIGN(trans_bytes, CONFIG_SYS_CACHELINE_SIZE);
-	flush_cache(start_addr, trans_bytes);
-#endif
+	if (dma)
+		flush_cache(host->start_addr, ALIGN(host->trans_bytes,
+						    CONFIG_SYS_CACHELINE_SIZE));
 	sdhci_writew(host, SDHCI_MAKE_CMD(cmd->cmdidx, flags), SDHCI_COMMAND);
 	start = get_timer(0);
 	do {
@@ -269,29 +429,44 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	} else
 		ret = -1;
 
-	if (!ret && data)
-		ret = sdhci_transfer_data(host, data, start_addr);
+	if (async && !ret)
+		return 0;
 
-	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
-		udelay(1000);
+	return sdhci_finish_command(host, data, ret);
+}
 
-	stat = sdhci_readl(host, SDHCI_INT_STATUS);
-	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
-	if (!ret) {
-		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				!is_aligned && (data->flags == MMC_DATA_READ))
-			memcpy(data->dest, aligned_buffer, trans_bytes);
-		return 0;
-	}
+#ifdef CONFIG_DM_MMC_OPS
+static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	return sdhci_start_command(mmc_get_mmc_dev(dev), cmd, data, false);
+}
 
-	sdhci_reset(host, SDHCI_RESET_CMD);
-	sdhci_reset(host, SDHCI_RESET_DATA);
-	if (stat & SDHCI_INT_TIMEOUT)
-		return -ETIMEDOUT;
-	else
-		return -ECOMM;
+#if defined(CONFIG_MMC_SDMA) || defined(CONFIG_MMC_SDHCI_ADMA)
+static int sdhci_send_command_async(struct udevice *dev, struct mmc_cmd *cmd,
+				    struct mmc_data *data)
+{
+	if (!data)
+		return -ENOSYS;
+
+	return sdhci_start_command(mmc_get_mmc_dev(dev), cmd, data, true);
 }
 
+static int sdhci_wait_data(struct udevice *dev, struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	return sdhci_finish_command(mmc->priv, data, 0);
+}
+#endif
+#else
+static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	return sdhci_start_command(mmc, cmd, data, false);
+}
+#endif
+
 static int sdhci_set_clock(struct mmc *mmc, unsigned int clock)
 {
 	struct sdhci_host *host = mmc->priv;
@@ -482,6 +657,10 @@ static int sdhci_init(struct mmc *mmc)
 		}
 	}
 
+#ifdef CONFIG_MMC_SDHCI_ADMA
+	sdhci_adma_init(host, mmc);
+#endif
+
 	sdhci_set_power(host, fls(mmc->cfg->voltages) - 1);
 
 	if (host->quirks & SDHCI_QUIRK_NO_CD) {
@@ -524,6 +703,10 @@ int sdhci_probe(struct udevice *dev)
 const struct dm_mmc_ops sdhci_ops = {
 	.send_cmd	= sdhci_send_command,
 	.set_ios	= sdhci_set_ios,
+#if defined(CONFIG_MMC_SDMA) || defined(CONFIG_MMC_SDHCI_ADMA)
+	.send_cmd_async	= sdhci_send_command_async,
+	.wait_data	= sdhci_wait_data,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
@@ -540,12 +723,22 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 
 	caps = sdhci_readl(host, SDHCI_CAPABILITIES);
 
+	host->flags = 0;
 #ifdef CONFIG_MMC_SDMA
 	if (!(caps & SDHCI_CAN_DO_SDMA)) {
 		printf("%s: Your controller doesn't support SDMA!!\n",
 		       __func__);
 		return -EINVAL;
 	}
+	host->flags |= SDHCI_USE_SDMA;
+#endif
+#ifdef CONFIG_MMC_SDHCI_ADMA
+	/* Without ADMA2 we carry on with SDMA or PIO */
+	if (caps & SDHCI_CAN_DO_ADMA2) {
+		host->flags |= SDHCI_USE_ADMA;
+		if ((caps & SDHCI_CAN_64BIT) && sizeof(dma_addr_t) > 4)
+			host->flags |= SDHCI_USE_ADMA64;
+	}
 #endif
 	if (host->quirks & SDHCI_QUIRK_REG32_RW)
 		host->version =
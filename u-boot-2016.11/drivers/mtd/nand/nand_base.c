@@ -1984,6 +1984,76 @@ out:
 	return ret;
 }
 
+/**
+ * nand_read_bbm - [GENERIC] read the bad block markers of a run of blocks
+ * @mtd: MTD device structure
+ * @from: offset of the first page to read in the first block
+ * @numblocks: number of consecutive blocks to read
+ * @numpages: number of consecutive pages to read in each block
+ * @offs: offset of the marker in the OOB area
+ * @len: length of the marker
+ * @buf: buffer for @numblocks * @numpages markers of @len bytes each
+ *
+ * Rather than reading the whole OOB area of every page through the MTD
+ * interface, this reads just the marker bytes, with the device held and the
+ * chip selected for the whole run. Returns -ENOTSUPP if the driver has its
+ * own way of reading the OOB area or the marker, since the marker may then
+ * not be where the column address says.
+ */
+int nand_read_bbm(struct mtd_info *mtd, loff_t from, int numblocks,
+		  int numpages, int offs, int len, uint8_t *buf)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int chipnr = -1;
+	int col = offs, count = len;
+	int i, j;
+
+	if (chip->ecc.read_oob != nand_read_oob_std ||
+	    chip->block_bad != nand_block_bad)
+		return -ENOTSUPP;
+	if (offs < 0 || len <= 0 || offs + len > mtd->oobsize)
+		return -EINVAL;
+
+	/* A 16-bit bus can only read whole words */
+	if (chip->options & NAND_BUSWIDTH_16) {
+		col = offs & ~1;
+		count = ALIGN(offs + len, 2) - col;
+	}
+
+	nand_get_device(mtd, FL_READING);
+	for (i = 0; i < numblocks; i++) {
+		loff_t ofs = from + ((loff_t)i << chip->bbt_erase_shift);
+
+		WATCHDOG_RESET();
+		if ((int)(ofs >> chip->chip_shift) != chipnr) {
+			if (chipnr >= 0)
+				chip->select_chip(mtd, -1);
+			chipnr = (int)(ofs >> chip->chip_shift);
+			chip->select_chip(mtd, chipnr);
+		}
+
+		for (j = 0; j < numpages; j++, ofs += mtd->writesize) {
+			int page = (int)(ofs >> chip->page_shift) &
+				chip->pagemask;
+
+			chip->cmdfunc(mtd, NAND_CMD_READOOB, col, page);
+			chip->read_buf(mtd, chip->oob_poi, count);
+			memcpy(buf, chip->oob_poi + offs - col, len);
+			buf += len;
+
+			if (chip->options & NAND_NEED_READRDY) {
+				if (!chip->dev_ready)
+					udelay(chip->chip_delay);
+				else
+					nand_wait_ready(mtd);
+			}
+		}
+	}
+	chip->select_chip(mtd, -1);
+	nand_release_device(mtd);
+
+	return 0;
+}
 
 /**
  * nand_write_page_raw - [INTERN] raw page write function
@@ -438,6 +438,20 @@ static int scan_block_fast(struct mtd_info *mtd, struct nand_bbt_descr *bd,
 	return 0;
 }
 
+/* Check the markers of a block read by nand_read_bbm() */
+static int scan_markers(const uint8_t *marker, struct nand_bbt_descr *bd,
+			int numpages)
+{
+	int j;
+
+	for (j = 0; j < numpages; j++, marker += bd->len) {
+		if (memcmp(marker, bd->pattern, bd->len))
+			return 1;
+	}
+
+	return 0;
+}
+
 /**
  * create_bbt - [GENERIC] Create a bad block table by scanning the device
  * @mtd: MTD device structure
@@ -454,7 +468,9 @@ static int create_bbt(struct mtd_info *mtd, uint8_t *buf,
 {
 	struct nand_chip *this = mtd_to_nand(mtd);
 	int i, numblocks, numpages;
-	int startblock;
+	int startblock, run = 0, runblocks;
+	bool fast = true;
+	uint8_t *marker = buf;
 	loff_t from;
 
 	pr_info("Scanning device for bad blocks\n");
@@ -483,14 +499,34 @@ static int create_bbt(struct mtd_info *mtd, uint8_t *buf,
 	if (this->bbt_options & NAND_BBT_SCANLASTPAGE)
 		from += mtd->erasesize - (mtd->writesize * numpages);
 
+	/* Read the markers of as many blocks at once as fit in the buffer */
+	runblocks = (1 << this->bbt_erase_shift) / (numpages * bd->len);
+
 	for (i = startblock; i < numblocks; i++) {
 		int ret;
 
 		BUG_ON(bd->options & NAND_BBT_NO_OOB);
 
-		ret = scan_block_fast(mtd, bd, from, buf, numpages);
-		if (ret < 0)
-			return ret;
+		if (fast && !run) {
+			run = min(numblocks - i, runblocks);
+			ret = nand_read_bbm(mtd, from, run, numpages, bd->offs,
+					    bd->len, buf);
+			if (ret == -ENOTSUPP)
+				fast = false;
+			else if (ret)
+				return ret;
+			marker = buf;
+		}
+
+		if (fast) {
+			ret = scan_markers(marker, bd, numpages);
+			marker += numpages * bd->len;
+			run--;
+		} else {
+			ret = scan_block_fast(mtd, bd, from, buf, numpages);
+			if (ret < 0)
+				return ret;
+		}
 
 		if (ret) {
 			bbt_mark_entry(this, i, BBT_BLOCK_FACTORY_BAD);
@@ -56,7 +56,7 @@ static const char *sandbox_sf_state_name(enum sandbox_sf_state state)
 #define STAT_WIP	(1 << 0)
 #define STAT_WEL	(1 << 1)
 
-/* Assume all SPI flashes have 3 byte addresses since they do atm */
+/* Flashes use 3 address bytes, or 4 for the 4-byte address commands */
 #define SF_ADDR_LEN	3
 
 #define IDCODE_LEN 3
@@ -83,14 +83,16 @@ struct sandbox_spi_flash {
 	uint erase_size;
 	/* Current position in the flash; used when reading/writing/etc... */
 	uint off;
-	/* How many address bytes we've consumed */
-	uint addr_bytes, pad_addr_bytes;
+	/* How many address bytes we've consumed, and how many we expect */
+	uint addr_bytes, pad_addr_bytes, addr_len;
 	/* The current flash status (see STAT_XXX defines above) */
 	u16 status;
 	/* Data describing the flash we're emulating */
 	const struct spi_flash_params *data;
 	/* The file on disk to serv up data from */
 	int fd;
+	/* Number of times each command has been received */
+	uint cmd_count[256];
 };
 
 struct sandbox_spi_flash_plat_data {
@@ -222,6 +224,7 @@ static void sandbox_sf_cs_activate(struct udevice *dev)
 	sbsf->off = 0;
 	sbsf->addr_bytes = 0;
 	sbsf->pad_addr_bytes = 0;
+	sbsf->addr_len = SF_ADDR_LEN;
 	sbsf->state = SF_CMD;
 	sbsf->cmd = SF_CMD;
 }
@@ -255,6 +258,33 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 		sandbox_spi_tristate(tx, 1);
 
 	sbsf->cmd = rx[0];
+	sbsf->cmd_count[sbsf->cmd]++;
+
+	/* Handle 4-byte address commands as their 3-byte equivalents */
+	if (sbsf->data->flags & ADDR_4B) {
+		uint cmd = sbsf->cmd;
+
+		switch (cmd) {
+		case CMD_READ_ARRAY_FAST_4B:
+			sbsf->cmd = CMD_READ_ARRAY_FAST;
+			break;
+		case CMD_READ_ARRAY_SLOW_4B:
+			sbsf->cmd = CMD_READ_ARRAY_SLOW;
+			break;
+		case CMD_PAGE_PROGRAM_4B:
+			sbsf->cmd = CMD_PAGE_PROGRAM;
+			break;
+		case CMD_ERASE_4K_4B:
+			sbsf->cmd = CMD_ERASE_4K;
+			break;
+		case CMD_ERASE_64K_4B:
+			sbsf->cmd = CMD_ERASE_64K;
+			break;
+		}
+		if (sbsf->cmd != cmd)
+			sbsf->addr_len = SF_ADDR_LEN + 1;
+	}
+
 	switch (sbsf->cmd) {
 	case CMD_READ_ID:
 		sbsf->state = SF_ID;
@@ -292,7 +322,7 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 				sbsf->data->nr_sectors;
 		} else if (sbsf->cmd == CMD_ERASE_4K && (flags & SECT_4K)) {
 			sbsf->erase_size = 4 << 10;
-		} else if (sbsf->cmd == CMD_ERASE_64K && !(flags & SECT_4K)) {
+		} else if (sbsf->cmd == CMD_ERASE_64K) {
 			sbsf->erase_size = 64 << 10;
 		} else {
 			debug(" cmd unknown: %#x\n", sbsf->cmd);
@@ -361,6 +391,10 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 				/* Extract correct byte from ID 0x00aabbcc */
 				id = sbsf->data->jedec >>
 					(8 * (IDCODE_LEN - 1 - sbsf->off));
+			} else if (sbsf->off < IDCODE_LEN + 2) {
+				/* Then the extended ID 0xddee, if any */
+				id = sbsf->data->ext_jedec >>
+					(8 * (IDCODE_LEN + 1 - sbsf->off));
 			} else {
 				id = 0;
 			}
@@ -373,7 +407,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 			debug(" addr: bytes:%u rx:%02x ", sbsf->addr_bytes,
 			      rx[pos]);
 
-			if (sbsf->addr_bytes++ < SF_ADDR_LEN)
+			if (sbsf->addr_bytes++ < sbsf->addr_len)
 				sbsf->off = (sbsf->off << 8) | rx[pos];
 			debug("addr:%06x\n", sbsf->off);
 
@@ -383,7 +417,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 
 			/* See if we're done processing */
 			if (sbsf->addr_bytes <
-					SF_ADDR_LEN + sbsf->pad_addr_bytes)
+					sbsf->addr_len + sbsf->pad_addr_bytes)
 				break;
 
 			/* Next state! */
@@ -589,6 +623,13 @@ int sandbox_sf_bind_emul(struct sandbox_state *state, int busnum, int cs,
 	return 0;
 }
 
+uint sandbox_sf_get_cmd_count(struct udevice *emul, uint cmd)
+{
+	struct sandbox_spi_flash *sbsf = dev_get_priv(emul);
+
+	return sbsf->cmd_count[cmd & 0xff];
+}
+
 void sandbox_sf_unbind_emul(struct sandbox_state *state, int busnum, int cs)
 {
 	struct udevice *dev;
@@ -22,12 +22,19 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-static void spi_flash_addr(u32 addr, u8 *cmd)
+/* Fill in the address after the command and return the command length */
+static int spi_flash_addr(struct spi_flash *flash, u32 addr, u8 *cmd)
 {
+	int len = 1;
+
 	/* cmd[0] is actual command */
-	cmd[1] = addr >> 16;
-	cmd[2] = addr >> 8;
-	cmd[3] = addr >> 0;
+	if (flash->flags & SNOR_F_4B_OPCODES)
+		cmd[len++] = addr >> 24;
+	cmd[len++] = addr >> 16;
+	cmd[len++] = addr >> 8;
+	cmd[len++] = addr >> 0;
+
+	return len;
 }
 
 static int read_sr(struct spi_flash *flash, u8 *rs)
@@ -149,6 +156,10 @@ static int spi_flash_write_bar(struct spi_flash *flash, u32 offset)
 	u8 cmd, bank_sel;
 	int ret;
 
+	/* The whole address goes with each command */
+	if (flash->flags & SNOR_F_4B_OPCODES)
+		return 0;
+
 	bank_sel = offset / (SPI_FLASH_16MB_BOUN << flash->shift);
 	if (bank_sel == flash->bank_curr)
 		goto bar_end;
@@ -170,7 +181,8 @@ static int spi_flash_read_bar(struct spi_flash *flash, u8 idcode0)
 	u8 curr_bank = 0;
 	int ret;
 
-	if (flash->size <= SPI_FLASH_16MB_BOUN)
+	if (flash->size <= SPI_FLASH_16MB_BOUN ||
+	    flash->flags & SNOR_F_4B_OPCODES)
 		goto bar_end;
 
 	switch (idcode0) {
@@ -327,7 +339,8 @@ int spi_flash_write_common(struct spi_flash *flash, const u8 *cmd,
 int spi_flash_cmd_erase_ops(struct spi_flash *flash, u32 offset, size_t len)
 {
 	u32 erase_size, erase_addr;
-	u8 cmd[SPI_FLASH_CMD_LEN];
+	u8 cmd[SPI_FLASH_CMD_MAX_LEN];
+	int cmdsz;
 	int ret = -1;
 
 	erase_size = flash->erase_size;
@@ -344,8 +357,17 @@ int spi_flash_cmd_erase_ops(struct spi_flash *flash, u32 offset, size_t len)
 		}
 	}
 
-	cmd[0] = flash->erase_cmd;
 	while (len) {
+		/* Use the larger erase where a whole block is to go */
+		if (flash->block_erase_size &&
+		    !(offset % flash->block_erase_size) &&
+		    len >= flash->block_erase_size) {
+			cmd[0] = flash->block_erase_cmd;
+			erase_size = flash->block_erase_size;
+		} else {
+			cmd[0] = flash->erase_cmd;
+			erase_size = flash->erase_size;
+		}
 		erase_addr = offset;
 
 #ifdef CONFIG_SF_DUAL_FLASH
@@ -357,12 +379,12 @@ int spi_flash_cmd_erase_ops(struct spi_flash *flash, u32 offset, size_t len)
 		if (ret < 0)
 			return ret;
 #endif
-		spi_flash_addr(erase_addr, cmd);
+		cmdsz = spi_flash_addr(flash, erase_addr, cmd);
 
 		debug("SF: erase %2x %2x %2x %2x (%x)\n", cmd[0], cmd[1],
 		      cmd[2], cmd[3], erase_addr);
 
-		ret = spi_flash_write_common(flash, cmd, sizeof(cmd), NULL, 0);
+		ret = spi_flash_write_common(flash, cmd, cmdsz, NULL, 0);
 		if (ret < 0) {
 			debug("SF: erase failed\n");
 			break;
@@ -382,7 +404,8 @@ int spi_flash_cmd_write_ops(struct spi_flash *flash, u32 offset,
 	unsigned long byte_addr, page_size;
 	u32 write_addr;
 	size_t chunk_len, actual;
-	u8 cmd[SPI_FLASH_CMD_LEN];
+	u8 cmd[SPI_FLASH_CMD_MAX_LEN];
+	int cmdsz;
 	int ret = -1;
 
 	page_size = flash->page_size;
@@ -415,12 +438,12 @@ int spi_flash_cmd_write_ops(struct spi_flash *flash, u32 offset,
 			chunk_len = min(chunk_len,
 					(size_t)spi->max_write_size);
 
-		spi_flash_addr(write_addr, cmd);
+		cmdsz = spi_flash_addr(flash, write_addr, cmd);
 
 		debug("SF: 0x%p => cmd = { 0x%02x 0x%02x%02x%02x } chunk_len = %zu\n",
 		      buf + actual, cmd[0], cmd[1], cmd[2], cmd[3], chunk_len);
 
-		ret = spi_flash_write_common(flash, cmd, sizeof(cmd),
+		ret = spi_flash_write_common(flash, cmd, cmdsz,
 					buf + actual, chunk_len);
 		if (ret < 0) {
 			debug("SF: write failed\n");
@@ -492,7 +515,7 @@ int spi_flash_cmd_read_ops(struct spi_flash *flash, u32 offset,
 		return 0;
 	}
 
-	cmdsz = SPI_FLASH_CMD_LEN + flash->dummy_byte;
+	cmdsz = SPI_FLASH_CMD_MAX_LEN + flash->dummy_byte;
 	cmd = calloc(1, cmdsz);
 	if (!cmd) {
 		debug("SF: Failed to allocate cmd\n");
@@ -515,12 +538,15 @@ int spi_flash_cmd_read_ops(struct spi_flash *flash, u32 offset,
 #endif
 		remain_len = ((SPI_FLASH_16MB_BOUN << flash->shift) *
 				(bank_sel + 1)) - offset;
-		if (len < remain_len)
+		if (len < remain_len || flash->flags & SNOR_F_4B_OPCODES)
 			read_len = len;
 		else
 			read_len = remain_len;
+		if (spi->max_read_size)
+			read_len = min(read_len, (u32)spi->max_read_size);
 
-		spi_flash_addr(read_addr, cmd);
+		cmdsz = spi_flash_addr(flash, read_addr, cmd) +
+			flash->dummy_byte;
 
 		ret = spi_flash_read_common(flash, cmd, cmdsz, data, read_len);
 		if (ret < 0) {
@@ -971,6 +997,36 @@ int spi_flash_decode_fdt(const void *blob, struct spi_flash *flash)
 }
 #endif /* CONFIG_IS_ENABLED(OF_CONTROL) */
 
+/* Switch to the 4-byte address form of the read, write and erase commands */
+static void spi_flash_set_4b_opcodes(struct spi_flash *flash)
+{
+	static const u8 opcodes[][2] = {
+		{ CMD_READ_ARRAY_SLOW, CMD_READ_ARRAY_SLOW_4B },
+		{ CMD_READ_ARRAY_FAST, CMD_READ_ARRAY_FAST_4B },
+		{ CMD_READ_DUAL_OUTPUT_FAST, CMD_READ_DUAL_OUTPUT_FAST_4B },
+		{ CMD_READ_DUAL_IO_FAST, CMD_READ_DUAL_IO_FAST_4B },
+		{ CMD_READ_QUAD_OUTPUT_FAST, CMD_READ_QUAD_OUTPUT_FAST_4B },
+		{ CMD_READ_QUAD_IO_FAST, CMD_READ_QUAD_IO_FAST_4B },
+		{ CMD_PAGE_PROGRAM, CMD_PAGE_PROGRAM_4B },
+		{ CMD_QUAD_PAGE_PROGRAM, CMD_QUAD_PAGE_PROGRAM_4B },
+		{ CMD_ERASE_4K, CMD_ERASE_4K_4B },
+		{ CMD_ERASE_64K, CMD_ERASE_64K_4B },
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(opcodes); i++) {
+		if (flash->read_cmd == opcodes[i][0])
+			flash->read_cmd = opcodes[i][1];
+		if (flash->write_cmd == opcodes[i][0])
+			flash->write_cmd = opcodes[i][1];
+		if (flash->erase_cmd == opcodes[i][0])
+			flash->erase_cmd = opcodes[i][1];
+		if (flash->block_erase_cmd == opcodes[i][0])
+			flash->block_erase_cmd = opcodes[i][1];
+	}
+	flash->flags |= SNOR_F_4B_OPCODES;
+}
+
 #ifdef CONFIG_SPI_FLASH_SPANSION
 static int spansion_s25fss_disable_4KB_erase(struct spi_slave *spi)
 {
@@ -1160,6 +1216,9 @@ int spi_flash_scan(struct spi_flash *flash)
 	if (params->flags & SECT_4K) {
 		flash->erase_cmd = CMD_ERASE_4K;
 		flash->erase_size = 4096 << flash->shift;
+		/* The chip can still erase a whole sector at once */
+		flash->block_erase_cmd = CMD_ERASE_64K;
+		flash->block_erase_size = flash->sector_size;
 	} else
 #endif
 	{
@@ -1216,6 +1275,15 @@ int spi_flash_scan(struct spi_flash *flash)
 		flash->dummy_byte = 1;
 	}
 
+	/*
+	 * Above 16MiB per die, use the 4-byte address commands if the chip
+	 * has them. This avoids switching banks through the BAR and lets a
+	 * read cross the 16MiB boundary in one transfer.
+	 */
+	if (params->flags & ADDR_4B &&
+	    params->sector_size * params->nr_sectors > SPI_FLASH_16MB_BOUN)
+		spi_flash_set_4b_opcodes(flash);
+
 #ifdef CONFIG_SPI_FLASH_STMICRO
 	if (params->flags & E_FSR)
 		flash->flags |= SNOR_F_USE_FSR;
@@ -1235,6 +1303,18 @@ int spi_flash_scan(struct spi_flash *flash)
 		return -EINVAL;
 	}
 #endif
+#ifdef CONFIG_DM_SPI
+	/* Use the controller's direct-mapped window if it covers the flash */
+	if (!flash->memory_map) {
+		ulong map_base;
+		uint map_size, map_offset;
+
+		if (!dm_spi_get_mmap(spi->dev, &map_base, &map_size,
+				     &map_offset) &&
+		    !map_offset && map_size >= flash->size)
+			flash->memory_map = map_sysmem(map_base, flash->size);
+	}
+#endif
 
 #ifndef CONFIG_SPL_BUILD
 	printf("SF: Detected %s with page size ", flash->name);
@@ -1247,10 +1327,11 @@ int spi_flash_scan(struct spi_flash *flash)
 #endif
 
 #ifndef CONFIG_SPI_FLASH_BAR
-	if (((flash->dual_flash == SF_SINGLE_FLASH) &&
+	if (!(flash->flags & SNOR_F_4B_OPCODES) &&
+	    (((flash->dual_flash == SF_SINGLE_FLASH) &&
 	     (flash->size > SPI_FLASH_16MB_BOUN)) ||
 	     ((flash->dual_flash > SF_SINGLE_FLASH) &&
-	     (flash->size > SPI_FLASH_16MB_BOUN << 1))) {
+	     (flash->size > SPI_FLASH_16MB_BOUN << 1)))) {
 		puts("SF: Warning - Only lower 16MiB accessible,");
 		puts(" Full access #define CONFIG_SPI_FLASH_BAR\n");
 	}
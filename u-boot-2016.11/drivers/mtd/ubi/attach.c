@@ -76,6 +76,7 @@
 #include <linux/crc32.h>
 #include <linux/random.h>
 #else
+#include <cpu_work.h>
 #include <div64.h>
 #include <linux/err.h>
 #endif
@@ -91,6 +92,23 @@ static int self_check_ai(struct ubi_device *ubi, struct ubi_attach_info *ai);
 static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
 
+/* Number of PEBs whose headers are read before any of them is processed */
+#define UBI_SCAN_BATCH	32
+
+/**
+ * struct scan_batch - headers of a batch of PEBs read by 'read_batch()'.
+ * @ubi: UBI device description object
+ * @hr: the headers of each PEB in the batch
+ * @count: number of PEBs in the batch
+ * @cpus: number of CPUs checking their CRCs
+ */
+struct scan_batch {
+	const struct ubi_device *ubi;
+	struct ubi_hdr_read *hr;
+	int count;
+	int cpus;
+};
+
 /**
  * add_to_list - add physical eraseblock to a list.
  * @ai: attaching information
@@ -806,6 +824,7 @@ out_unlock:
  * @pnum: the physical eraseblock number
  * @vid: The volume ID of the found volume will be stored in this pointer
  * @sqnum: The sqnum of the found volume will be stored in this pointer
+ * @hr: the headers of this PEB if they have already been read, else %NULL
  *
  * This function reads UBI headers of PEB @pnum, checks them, and adds
  * information about this PEB to the corresponding list or RB-tree in the
@@ -813,7 +832,8 @@ out_unlock:
  * successfully handled and a negative error code in case of failure.
  */
 static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
-		    int pnum, int *vid, unsigned long long *sqnum)
+		    int pnum, int *vid, unsigned long long *sqnum,
+		    const struct ubi_hdr_read *hr)
 {
 	long long uninitialized_var(ec);
 	int err, bitflips = 0, vol_id = -1, ec_err = 0;
@@ -821,7 +841,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	dbg_bld("scan PEB %d", pnum);
 
 	/* Skip bad physical eraseblocks */
-	err = ubi_io_is_bad(ubi, pnum);
+	err = hr ? hr->bad : ubi_io_is_bad(ubi, pnum);
 	if (err < 0)
 		return err;
 	else if (err) {
@@ -829,7 +849,13 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	/* Headers which were not read cleanly are read again one by one */
+	if (hr && hr->read_err)
+		hr = NULL;
+	if (hr)
+		err = ubi_io_check_ec_hdr(ubi, pnum, hr, ech);
+	else
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -912,7 +938,10 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+	if (hr)
+		err = ubi_io_check_vid_hdr(ubi, pnum, hr, vidh);
+	else
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1211,6 +1240,47 @@ static void destroy_ai(struct ubi_attach_info *ai)
 	kfree(ai);
 }
 
+/* Work out the header CRCs of every @sb->cpus'th PEB in the batch */
+static void scan_crc_work(void *arg, int index)
+{
+	struct scan_batch *sb = arg;
+	struct ubi_hdr_read *hr;
+	int i;
+
+	for (i = index; i < sb->count; i += sb->cpus) {
+		hr = &sb->hr[i];
+		if (!hr->bad && !hr->read_err)
+			ubi_io_crc_hdrs(sb->ubi, hr);
+	}
+}
+
+/**
+ * read_batch - read the headers of a batch of PEBs.
+ * @ubi: UBI device description object
+ * @sb: the batch, with @sb->count set
+ * @start: first PEB of the batch
+ *
+ * This function reads both headers of each PEB with one flash read, then
+ * checks all their CRCs at once, spread across the available CPUs. Errors
+ * are left in @sb for 'scan_peb()' to deal with in order.
+ */
+static void read_batch(struct ubi_device *ubi, struct scan_batch *sb,
+		       int start)
+{
+	struct ubi_hdr_read *hr;
+	int i;
+
+	for (i = 0; i < sb->count; i++) {
+		hr = &sb->hr[i];
+		hr->bad = ubi_io_is_bad(ubi, start + i);
+		if (!hr->bad)
+			ubi_io_read_hdrs(ubi, start + i, hr);
+	}
+
+	sb->cpus = min(cpu_work_cpus(), sb->count);
+	cpu_work_run(scan_crc_work, sb, sb->cpus);
+}
+
 /**
  * scan_all - scan entire MTD device.
  * @ubi: UBI device description object
@@ -1224,10 +1294,12 @@ static void destroy_ai(struct ubi_attach_info *ai)
 static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		    int start)
 {
-	int err, pnum;
+	int err, pnum, i, hdrs_size;
 	struct rb_node *rb1, *rb2;
 	struct ubi_ainf_volume *av;
 	struct ubi_ainf_peb *aeb;
+	struct scan_batch sb;
+	void *bufs;
 
 	err = -ENOMEM;
 
@@ -1239,14 +1311,31 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = start; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
+	hdrs_size = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	sb.ubi = ubi;
+	sb.hr = kcalloc(UBI_SCAN_BATCH, sizeof(*sb.hr), GFP_KERNEL);
+	bufs = kmalloc_array(UBI_SCAN_BATCH, hdrs_size, GFP_KERNEL);
+	if (!sb.hr || !bufs)
+		goto out_bufs;
+	for (i = 0; i < UBI_SCAN_BATCH; i++)
+		sb.hr[i].buf = bufs + i * hdrs_size;
 
-		dbg_gen("process PEB %d", pnum);
-		err = scan_peb(ubi, ai, pnum, NULL, NULL);
-		if (err < 0)
-			goto out_vidh;
+	for (pnum = start; pnum < ubi->peb_count; pnum += sb.count) {
+		sb.count = min(UBI_SCAN_BATCH, ubi->peb_count - pnum);
+		read_batch(ubi, &sb, pnum);
+
+		for (i = 0; i < sb.count; i++) {
+			cond_resched();
+
+			dbg_gen("process PEB %d", pnum + i);
+			err = scan_peb(ubi, ai, pnum + i, NULL, NULL,
+				       &sb.hr[i]);
+			if (err < 0)
+				goto out_bufs;
+		}
 	}
+	kfree(bufs);
+	kfree(sb.hr);
 
 	ubi_msg(ubi, "scanning is finished");
 
@@ -1290,6 +1379,9 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	return 0;
 
+out_bufs:
+	kfree(bufs);
+	kfree(sb.hr);
 out_vidh:
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
@@ -1354,7 +1446,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 		cond_resched();
 
 		dbg_gen("process PEB %d", pnum);
-		err = scan_peb(ubi, *ai, pnum, &vol_id, &sqnum);
+		err = scan_peb(ubi, *ai, pnum, &vol_id, &sqnum, NULL);
 		if (err < 0)
 			goto out_vidh;
 
@@ -1399,6 +1491,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	unsigned long start = get_timer(0);
 
 	ai = alloc_ai();
 	if (!ai)
@@ -1415,8 +1508,14 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 		err = scan_all(ubi, ai, 0);
 	else {
 		err = scan_fast(ubi, &ai);
-		if (err > 0 || mtd_is_eccerr(err)) {
+		/*
+		 * Anything wrong with the fastmap, including reading it, means
+		 * the device has to be scanned after all
+		 */
+		if (err && err != -ENOMEM) {
 			if (err != UBI_NO_FASTMAP) {
+				ubi_warn(ubi, "cannot attach by fastmap (%d), scanning",
+					 err);
 				destroy_ai(ai);
 				ai = alloc_ai();
 				if (!ai)
@@ -1477,6 +1576,8 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	}
 #endif
 
+	ubi_msg(ubi, "attached %d PEBs by %s in %lu ms", ubi->peb_count,
+		ubi->fm ? "fastmap" : "scanning", get_timer(start));
 	destroy_ai(ai);
 	return 0;
 
@@ -699,52 +699,16 @@ bad:
 	return 1;
 }
 
-/**
- * ubi_io_read_ec_hdr - read and check an erase counter header.
- * @ubi: UBI device description object
- * @pnum: physical eraseblock to read from
- * @ec_hdr: a &struct ubi_ec_hdr object where to store the read erase counter
- * header
- * @verbose: be verbose if the header is corrupted or was not found
- *
- * This function reads erase counter header from physical eraseblock @pnum and
- * stores it in @ec_hdr. This function also checks CRC checksum of the read
- * erase counter header. The following codes may be returned:
- *
- * o %0 if the CRC checksum is correct and the header was successfully read;
- * o %UBI_IO_BITFLIPS if the CRC is correct, but bit-flips were detected
- *   and corrected by the flash driver; this is harmless but may indicate that
- *   this eraseblock may become bad soon (but may be not);
- * o %UBI_IO_BAD_HDR if the erase counter header is corrupted (a CRC error);
- * o %UBI_IO_BAD_HDR_EBADMSG is the same as %UBI_IO_BAD_HDR, but there also was
- *   a data integrity error (uncorrectable ECC error in case of NAND);
- * o %UBI_IO_FF if only 0xFF bytes were read (the PEB is supposedly empty)
- * o a negative error code in case of failure.
+/*
+ * Check an erase counter header which has been read with result @read_err
+ * and whose CRC is @crc. Returns as for ubi_io_read_ec_hdr().
  */
-int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
-		       struct ubi_ec_hdr *ec_hdr, int verbose)
+static int check_ec_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, uint32_t crc,
+			int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
-
-	dbg_io("read EC header from PEB %d", pnum);
-	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
-
-	read_err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
-	if (read_err) {
-		if (read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
-			return read_err;
-
-		/*
-		 * We read all the data, but either a correctable bit-flip
-		 * occurred, or MTD reported a data integrity error
-		 * (uncorrectable ECC error in case of NAND). The former is
-		 * harmless, the later may mean that the read data is
-		 * corrupted. But we have a CRC check-sum and we will detect
-		 * this. If the EC header is still OK, we just report this as
-		 * there was a bit-flip, to force scrubbing.
-		 */
-	}
+	uint32_t magic, hdr_crc;
+	int err;
 
 	magic = be32_to_cpu(ec_hdr->magic);
 	if (magic != UBI_EC_HDR_MAGIC) {
@@ -783,7 +747,6 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		return UBI_IO_BAD_HDR;
 	}
 
-	crc = crc32(UBI_CRC32_INIT, ec_hdr, UBI_EC_HDR_SIZE_CRC);
 	hdr_crc = be32_to_cpu(ec_hdr->hdr_crc);
 
 	if (hdr_crc != crc) {
@@ -815,6 +778,57 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 	return read_err ? UBI_IO_BITFLIPS : 0;
 }
 
+/**
+ * ubi_io_read_ec_hdr - read and check an erase counter header.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to read from
+ * @ec_hdr: a &struct ubi_ec_hdr object where to store the read erase counter
+ * header
+ * @verbose: be verbose if the header is corrupted or was not found
+ *
+ * This function reads erase counter header from physical eraseblock @pnum and
+ * stores it in @ec_hdr. This function also checks CRC checksum of the read
+ * erase counter header. The following codes may be returned:
+ *
+ * o %0 if the CRC checksum is correct and the header was successfully read;
+ * o %UBI_IO_BITFLIPS if the CRC is correct, but bit-flips were detected
+ *   and corrected by the flash driver; this is harmless but may indicate that
+ *   this eraseblock may become bad soon (but may be not);
+ * o %UBI_IO_BAD_HDR if the erase counter header is corrupted (a CRC error);
+ * o %UBI_IO_BAD_HDR_EBADMSG is the same as %UBI_IO_BAD_HDR, but there also was
+ *   a data integrity error (uncorrectable ECC error in case of NAND);
+ * o %UBI_IO_FF if only 0xFF bytes were read (the PEB is supposedly empty)
+ * o a negative error code in case of failure.
+ */
+int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
+		       struct ubi_ec_hdr *ec_hdr, int verbose)
+{
+	int read_err;
+
+	dbg_io("read EC header from PEB %d", pnum);
+	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+
+	read_err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
+	if (read_err) {
+		if (read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
+			return read_err;
+
+		/*
+		 * We read all the data, but either a correctable bit-flip
+		 * occurred, or MTD reported a data integrity error
+		 * (uncorrectable ECC error in case of NAND). The former is
+		 * harmless, the later may mean that the read data is
+		 * corrupted. But we have a CRC check-sum and we will detect
+		 * this. If the EC header is still OK, we just report this as
+		 * there was a bit-flip, to force scrubbing.
+		 */
+	}
+
+	return check_ec_hdr(ubi, pnum, ec_hdr, read_err,
+			    crc32(UBI_CRC32_INIT, ec_hdr, UBI_EC_HDR_SIZE_CRC),
+			    verbose);
+}
+
 /**
  * ubi_io_write_ec_hdr - write an erase counter header.
  * @ubi: UBI device description object
@@ -978,37 +992,16 @@ bad:
 	return 1;
 }
 
-/**
- * ubi_io_read_vid_hdr - read and check a volume identifier header.
- * @ubi: UBI device description object
- * @pnum: physical eraseblock number to read from
- * @vid_hdr: &struct ubi_vid_hdr object where to store the read volume
- * identifier header
- * @verbose: be verbose if the header is corrupted or wasn't found
- *
- * This function reads the volume identifier header from physical eraseblock
- * @pnum and stores it in @vid_hdr. It also checks CRC checksum of the read
- * volume identifier header. The error codes are the same as in
- * 'ubi_io_read_ec_hdr()'.
- *
- * Note, the implementation of this function is also very similar to
- * 'ubi_io_read_ec_hdr()', so refer commentaries in 'ubi_io_read_ec_hdr()'.
+/*
+ * Check a volume identifier header which has been read with result
+ * @read_err and whose CRC is @crc. Returns as for ubi_io_read_vid_hdr().
  */
-int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
-			struct ubi_vid_hdr *vid_hdr, int verbose)
+static int check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err,
+			 uint32_t crc, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
-	void *p;
-
-	dbg_io("read VID header from PEB %d", pnum);
-	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
-
-	p = (char *)vid_hdr - ubi->vid_hdr_shift;
-	read_err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
-			  ubi->vid_hdr_alsize);
-	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
-		return read_err;
+	uint32_t magic, hdr_crc;
+	int err;
 
 	magic = be32_to_cpu(vid_hdr->magic);
 	if (magic != UBI_VID_HDR_MAGIC) {
@@ -1037,7 +1030,6 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 		return UBI_IO_BAD_HDR;
 	}
 
-	crc = crc32(UBI_CRC32_INIT, vid_hdr, UBI_VID_HDR_SIZE_CRC);
 	hdr_crc = be32_to_cpu(vid_hdr->hdr_crc);
 
 	if (hdr_crc != crc) {
@@ -1063,6 +1055,121 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	return read_err ? UBI_IO_BITFLIPS : 0;
 }
 
+/**
+ * ubi_io_read_vid_hdr - read and check a volume identifier header.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ * @vid_hdr: &struct ubi_vid_hdr object where to store the read volume
+ * identifier header
+ * @verbose: be verbose if the header is corrupted or wasn't found
+ *
+ * This function reads the volume identifier header from physical eraseblock
+ * @pnum and stores it in @vid_hdr. It also checks CRC checksum of the read
+ * volume identifier header. The error codes are the same as in
+ * 'ubi_io_read_ec_hdr()'.
+ *
+ * Note, the implementation of this function is also very similar to
+ * 'ubi_io_read_ec_hdr()', so refer commentaries in 'ubi_io_read_ec_hdr()'.
+ */
+int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_vid_hdr *vid_hdr, int verbose)
+{
+	int read_err;
+	void *p;
+
+	dbg_io("read VID header from PEB %d", pnum);
+	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
+
+	p = (char *)vid_hdr - ubi->vid_hdr_shift;
+	read_err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
+			  ubi->vid_hdr_alsize);
+	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
+		return read_err;
+
+	return check_vid_hdr(ubi, pnum, vid_hdr, read_err,
+			     crc32(UBI_CRC32_INIT, vid_hdr,
+				   UBI_VID_HDR_SIZE_CRC),
+			     verbose);
+}
+
+/**
+ * ubi_io_read_hdrs - read both headers of a physical eraseblock at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ * @hr: where to put the headers; @hr->buf must have room for
+ *      @ubi->vid_hdr_aloffset + @ubi->vid_hdr_alsize bytes
+ *
+ * This function reads the start of physical eraseblock @pnum, up to the end
+ * of the VID header, with a single flash read, which on NAND is one
+ * multi-page read instead of two separate ones. Once 'ubi_io_crc_hdrs()'
+ * has worked out their CRCs, the headers are checked by
+ * 'ubi_io_check_ec_hdr()' and 'ubi_io_check_vid_hdr()'. Returns zero if the
+ * read was clean and a non-zero code as for 'ubi_io_read()' otherwise, in
+ * which case the caller should read the headers one at a time so that each
+ * gets its own result.
+ */
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum, struct ubi_hdr_read *hr)
+{
+	dbg_io("read headers from PEB %d", pnum);
+	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
+
+	hr->read_err = ubi_io_read(ubi, hr->buf, pnum, 0,
+				   ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize);
+
+	return hr->read_err;
+}
+
+/**
+ * ubi_io_crc_hdrs - work out the CRCs of headers read by 'ubi_io_read_hdrs()'.
+ * @ubi: UBI device description object
+ * @hr: headers which were read
+ *
+ * This only touches memory, so it may run on a secondary CPU.
+ */
+void ubi_io_crc_hdrs(const struct ubi_device *ubi, struct ubi_hdr_read *hr)
+{
+	hr->ec_crc = crc32(UBI_CRC32_INIT, hr->buf, UBI_EC_HDR_SIZE_CRC);
+	hr->vid_crc = crc32(UBI_CRC32_INIT, hr->buf + ubi->vid_hdr_offset,
+			    UBI_VID_HDR_SIZE_CRC);
+}
+
+/**
+ * ubi_io_check_ec_hdr - check an EC header read by 'ubi_io_read_hdrs()'.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number it came from
+ * @hr: the headers, with their CRCs
+ * @ec_hdr: where to put the erase counter header
+ *
+ * Returns the same as 'ubi_io_read_ec_hdr()' would have.
+ */
+int ubi_io_check_ec_hdr(struct ubi_device *ubi, int pnum,
+			const struct ubi_hdr_read *hr,
+			struct ubi_ec_hdr *ec_hdr)
+{
+	memcpy(ec_hdr, hr->buf, UBI_EC_HDR_SIZE);
+
+	return check_ec_hdr(ubi, pnum, ec_hdr, hr->read_err, hr->ec_crc, 0);
+}
+
+/**
+ * ubi_io_check_vid_hdr - check a VID header read by 'ubi_io_read_hdrs()'.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number it came from
+ * @hr: the headers, with their CRCs
+ * @vid_hdr: where to put the volume identifier header
+ *
+ * Returns the same as 'ubi_io_read_vid_hdr()' would have.
+ */
+int ubi_io_check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 const struct ubi_hdr_read *hr,
+			 struct ubi_vid_hdr *vid_hdr)
+{
+	memcpy(vid_hdr, hr->buf + ubi->vid_hdr_offset, UBI_VID_HDR_SIZE);
+
+	return check_vid_hdr(ubi, pnum, vid_hdr, hr->read_err, hr->vid_crc,
+			     0);
+}
+
 /**
  * ubi_io_write_vid_hdr - write a volume identifier header.
  * @ubi: UBI device description object
@@ -745,6 +745,25 @@ struct ubi_attach_info {
 	struct kmem_cache *aeb_slab_cache;
 };
 
+/**
+ * struct ubi_hdr_read - both headers of a PEB, read in one go.
+ * @buf: the start of the PEB, up to the end of the VID header
+ * @read_err: what 'ubi_io_read()' returned when reading @buf
+ * @bad: non-zero if the PEB is bad, in which case @buf was not read
+ * @ec_crc: CRC of the EC header in @buf
+ * @vid_crc: CRC of the VID header in @buf
+ *
+ * Attaching reads the headers of a batch of PEBs like this, then checks
+ * their CRCs on all available CPUs before going through them in order.
+ */
+struct ubi_hdr_read {
+	void *buf;
+	int read_err;
+	int bad;
+	uint32_t ec_crc;
+	uint32_t vid_crc;
+};
+
 /**
  * struct ubi_work - UBI work description data structure.
  * @list: a link in the list of pending works
@@ -895,6 +914,14 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose);
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum, struct ubi_hdr_read *hr);
+void ubi_io_crc_hdrs(const struct ubi_device *ubi, struct ubi_hdr_read *hr);
+int ubi_io_check_ec_hdr(struct ubi_device *ubi, int pnum,
+			const struct ubi_hdr_read *hr,
+			struct ubi_ec_hdr *ec_hdr);
+int ubi_io_check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 const struct ubi_hdr_read *hr,
+			 struct ubi_vid_hdr *vid_hdr);
 
 /* build.c */
 int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
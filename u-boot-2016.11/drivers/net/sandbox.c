@@ -12,6 +12,7 @@
 #include <malloc.h>
 #include <net.h>
 #include <asm/test.h>
+#include <asm/unaligned.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -54,6 +55,200 @@ void sandbox_eth_skip_timeout(void)
 	skip_timeout = true;
 }
 
+#define SB_TFTP_PORT		69
+#define SB_TFTP_DATA_PORT	2069
+#define SB_TFTP_BLOCK_SIZE	512
+#define SB_TFTP_RRQ		1
+#define SB_TFTP_DATA		3
+#define SB_TFTP_ACK		4
+#define SB_TFTP_OACK		6
+
+/*
+ * struct sb_tftp - state of the mock TFTP server
+ *
+ * data: contents of the file served, or NULL to not answer TFTP requests
+ * size: size of the file in bytes
+ * drop_block: block to leave out the first time it is sent, or 0
+ * windowsize: windowsize option from the last request, 0 if none
+ * acks: number of ACKs received since the last request
+ * client_hwaddr, client_ipaddr, client_port: where to send data blocks
+ * next_block: next block of the window to send
+ * window_end: last block of the window
+ * restart: block to start the next window from once this one is sent
+ */
+static struct sb_tftp {
+	const uchar *data;
+	int size;
+	int drop_block;
+	int windowsize;
+	int acks;
+	uchar client_hwaddr[ARP_HLEN];
+	struct in_addr client_ipaddr;
+	int client_port;
+	int next_block;
+	int window_end;
+	int restart;
+} sb_tftp;
+
+/*
+ * sandbox_eth_tftp_serve()
+ *
+ * Answer TFTP read requests with a mock server, which supports the RFC 7440
+ * windowsize option but no others.
+ *
+ * data - Contents of the file to send, or NULL to stop serving
+ * size - Size of the file in bytes
+ * drop_block - If non-zero, this block is lost the first time it is sent
+ */
+void sandbox_eth_tftp_serve(const void *data, int size, int drop_block)
+{
+	memset(&sb_tftp, '\0', sizeof(sb_tftp));
+	sb_tftp.data = data;
+	sb_tftp.size = size;
+	sb_tftp.drop_block = drop_block;
+}
+
+/*
+ * sandbox_eth_tftp_windowsize()
+ *
+ * Returns the windowsize requested by the client, or 0 if none
+ */
+int sandbox_eth_tftp_windowsize(void)
+{
+	return sb_tftp.windowsize;
+}
+
+/*
+ * sandbox_eth_tftp_acks()
+ *
+ * Returns the number of ACKs the mock TFTP server has received
+ */
+int sandbox_eth_tftp_acks(void)
+{
+	return sb_tftp.acks;
+}
+
+static void sb_tftp_start_window(int block)
+{
+	int last = sb_tftp.size / SB_TFTP_BLOCK_SIZE + 1;
+
+	sb_tftp.next_block = block;
+	sb_tftp.window_end = min(block + max(sb_tftp.windowsize, 1) - 1, last);
+	sb_tftp.restart = 0;
+}
+
+/* Build a UDP packet from the server with a payload of @len bytes */
+static void sb_tftp_reply(struct eth_sandbox_priv *priv, int len)
+{
+	struct ethernet_hdr *eth = (void *)priv->recv_packet_buffer;
+	struct ip_udp_hdr *ip = (void *)priv->recv_packet_buffer +
+		ETHER_HDR_SIZE;
+
+	memcpy(eth->et_dest, sb_tftp.client_hwaddr, ARP_HLEN);
+	memcpy(eth->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	net_set_ip_header((uchar *)ip, sb_tftp.client_ipaddr,
+			  priv->fake_host_ipaddr);
+	ip->ip_len = htons(IP_UDP_HDR_SIZE + len);
+	ip->ip_p = IPPROTO_UDP;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+	ip->udp_src = htons(SB_TFTP_DATA_PORT);
+	ip->udp_dst = htons(sb_tftp.client_port);
+	ip->udp_len = htons(UDP_HDR_SIZE + len);
+	ip->udp_xsum = 0;
+
+	priv->recv_packet_length = ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+}
+
+/* Send the next block of the window, if any */
+static void sb_tftp_send_data(struct eth_sandbox_priv *priv)
+{
+	uchar *pkt = priv->recv_packet_buffer + ETHER_HDR_SIZE +
+		IP_UDP_HDR_SIZE;
+	int block, offset, len;
+
+	for (;;) {
+		if (sb_tftp.next_block > sb_tftp.window_end)
+			return;
+		block = sb_tftp.next_block++;
+		if (block != sb_tftp.drop_block)
+			break;
+		/* Lose this block, but only once */
+		sb_tftp.drop_block = 0;
+	}
+
+	offset = (block - 1) * SB_TFTP_BLOCK_SIZE;
+	len = min(sb_tftp.size - offset, SB_TFTP_BLOCK_SIZE);
+	put_unaligned_be16(SB_TFTP_DATA, pkt);
+	put_unaligned_be16(block, pkt + 2);
+	memcpy(pkt + 4, sb_tftp.data + offset, len);
+	sb_tftp_reply(priv, 4 + len);
+
+	if (sb_tftp.next_block > sb_tftp.window_end && sb_tftp.restart)
+		sb_tftp_start_window(sb_tftp.restart);
+}
+
+/* Handle a TFTP request or ACK from the client */
+static void sb_tftp_receive(struct eth_sandbox_priv *priv,
+			    struct ethernet_hdr *eth, struct ip_udp_hdr *ip)
+{
+	uchar *pkt = (uchar *)ip + IP_UDP_HDR_SIZE;
+	int len = ntohs(ip->udp_len) - UDP_HDR_SIZE;
+	int port = ntohs(ip->udp_dst);
+	char *opt, *end = (char *)pkt + len;
+
+	if (len < 4)
+		return;
+	if (port == SB_TFTP_PORT &&
+	    get_unaligned_be16(pkt) == SB_TFTP_RRQ) {
+		memcpy(sb_tftp.client_hwaddr, eth->et_src, ARP_HLEN);
+		sb_tftp.client_ipaddr = net_read_ip(&ip->ip_src);
+		sb_tftp.client_port = ntohs(ip->udp_src);
+		sb_tftp.windowsize = 0;
+		sb_tftp.acks = 0;
+
+		/* Skip the file name and mode, then look at the options */
+		opt = (char *)pkt + 2;
+		opt += strnlen(opt, end - opt) + 1;
+		opt += strnlen(opt, end - opt) + 1;
+		while (opt < end) {
+			char *val = opt + strnlen(opt, end - opt) + 1;
+
+			if (val >= end)
+				break;
+			if (!strcmp(opt, "windowsize"))
+				sb_tftp.windowsize = simple_strtoul(val, NULL,
+								    10);
+			opt = val + strnlen(val, end - val) + 1;
+		}
+
+		if (!sb_tftp.windowsize) {
+			/* Options are ignored: send the first block now */
+			sb_tftp_start_window(1);
+			return;
+		}
+		pkt = priv->recv_packet_buffer + ETHER_HDR_SIZE +
+			IP_UDP_HDR_SIZE;
+		put_unaligned_be16(SB_TFTP_OACK, pkt);
+		len = 2 + sprintf((char *)pkt + 2, "windowsize%c%d", 0,
+				  sb_tftp.windowsize) + 1;
+		sb_tftp.next_block = 1;
+		sb_tftp.window_end = 0;
+		sb_tftp_reply(priv, len);
+	} else if (port == SB_TFTP_DATA_PORT &&
+		   get_unaligned_be16(pkt) == SB_TFTP_ACK) {
+		int block = get_unaligned_be16(pkt + 2);
+
+		sb_tftp.acks++;
+		/* Restart from the block after the ACKed one */
+		if (sb_tftp.next_block > sb_tftp.window_end)
+			sb_tftp_start_window(block + 1);
+		else
+			sb_tftp.restart = block + 1;
+	}
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -146,6 +341,8 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 
 				priv->recv_packet_length = length;
 			}
+		} else if (ip->ip_p == IPPROTO_UDP && sb_tftp.data) {
+			sb_tftp_receive(priv, eth, ip);
 		}
 	}
 
@@ -160,6 +357,8 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 		sandbox_timer_add_offset(11000UL);
 		skip_timeout = false;
 	}
+	if (!priv->recv_packet_length && sb_tftp.data)
+		sb_tftp_send_data(priv);
 
 	if (priv->recv_packet_length) {
 		int lcl_recv_packet_length = priv->recv_packet_length;
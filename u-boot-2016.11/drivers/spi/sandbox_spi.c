@@ -11,6 +11,7 @@
 #include <common.h>
 #include <dm.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <spi.h>
 #include <spi_flash.h>
 #include <os.h>
@@ -18,7 +19,9 @@
 #include <linux/errno.h>
 #include <asm/spi.h>
 #include <asm/state.h>
+#include <asm/test.h>
 #include <dm/device-internal.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -26,6 +29,24 @@ DECLARE_GLOBAL_DATA_PTR;
 # define CONFIG_SPI_IDLE_VAL 0xFF
 #endif
 
+/* Flash read command (3-byte address) used to fill a mapped window */
+#define SANDBOX_SPI_MAP_READ	0x03
+
+/**
+ * struct sandbox_spi_priv - controller features enabled by tests
+ *
+ * @map: copy of the flash on @map_cs, refreshed at each mapped access
+ * @map_size: size of @map in bytes, 0 if there is no map
+ * @map_cs: chip select which is mapped
+ * @max_read_size: longest transfer the controller can read, 0 for no limit
+ */
+struct sandbox_spi_priv {
+	void *map;
+	uint map_size;
+	uint map_cs;
+	uint max_read_size;
+};
+
 const char *sandbox_spi_parse_spec(const char *arg, unsigned long *bus,
 				   unsigned long *cs)
 {
@@ -49,8 +70,9 @@ __weak int sandbox_spi_get_emul(struct sandbox_state *state,
 	return -ENOENT;
 }
 
-static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
-			    const void *dout, void *din, unsigned long flags)
+static int sandbox_spi_emul_xfer(struct udevice *slave, unsigned int bitlen,
+				 const void *dout, void *din,
+				 unsigned long flags)
 {
 	struct udevice *bus = slave->parent;
 	struct sandbox_state *state = state_get_current();
@@ -124,6 +146,38 @@ static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
 	return ret;
 }
 
+/* Read the mapped window from the flash, as the controller would */
+static int sandbox_spi_fill_map(struct udevice *slave)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(slave->parent);
+	u8 cmd[4] = { SANDBOX_SPI_MAP_READ, 0, 0, 0 };
+	int ret;
+
+	ret = sandbox_spi_emul_xfer(slave, sizeof(cmd) * 8, cmd, NULL,
+				    SPI_XFER_BEGIN);
+	if (ret)
+		return ret;
+
+	return sandbox_spi_emul_xfer(slave, priv->map_size * 8, NULL,
+				     priv->map, SPI_XFER_END);
+}
+
+static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
+			    const void *dout, void *din, unsigned long flags)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(slave->parent);
+
+	if (flags & SPI_XFER_MMAP)
+		return priv->map ? sandbox_spi_fill_map(slave) : -EFAULT;
+	if (din && priv->max_read_size && bitlen / 8 > priv->max_read_size) {
+		printf("%s: read of %u bytes is too long\n", __func__,
+		       bitlen / 8);
+		return -EMSGSIZE;
+	}
+
+	return sandbox_spi_emul_xfer(slave, bitlen, dout, din, flags);
+}
+
 static int sandbox_spi_set_speed(struct udevice *bus, uint speed)
 {
 	return 0;
@@ -144,11 +198,69 @@ static int sandbox_cs_info(struct udevice *bus, uint cs,
 	return 0;
 }
 
+static int sandbox_spi_get_mmap(struct udevice *dev, ulong *map_basep,
+				uint *map_sizep, uint *offsetp)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(dev->parent);
+
+	if (!priv->map || spi_chip_select(dev) != priv->map_cs)
+		return -EFAULT;
+	*map_basep = map_to_sysmem(priv->map);
+	*map_sizep = priv->map_size;
+	*offsetp = 0;
+
+	return 0;
+}
+
+int sandbox_spi_set_mmap(struct udevice *bus, uint cs, uint size)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(bus);
+
+	/* The window is filled with a 3-byte address read */
+	if (size > SZ_16M)
+		return -EINVAL;
+	free(priv->map);
+	priv->map = NULL;
+	priv->map_size = 0;
+	if (!size)
+		return 0;
+	priv->map = malloc(size);
+	if (!priv->map)
+		return -ENOMEM;
+	priv->map_size = size;
+	priv->map_cs = cs;
+
+	return 0;
+}
+
+void sandbox_spi_set_max_read_size(struct udevice *bus, uint size)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(bus);
+
+	priv->max_read_size = size;
+}
+
+static int sandbox_spi_child_pre_probe(struct udevice *dev)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(dev->parent);
+	struct spi_slave *slave = dev_get_parent_priv(dev);
+
+	slave->max_read_size = priv->max_read_size;
+
+	return 0;
+}
+
+static int sandbox_spi_remove(struct udevice *bus)
+{
+	return sandbox_spi_set_mmap(bus, 0, 0);
+}
+
 static const struct dm_spi_ops sandbox_spi_ops = {
 	.xfer		= sandbox_spi_xfer,
 	.set_speed	= sandbox_spi_set_speed,
 	.set_mode	= sandbox_spi_set_mode,
 	.cs_info	= sandbox_cs_info,
+	.get_mmap	= sandbox_spi_get_mmap,
 };
 
 static const struct udevice_id sandbox_spi_ids[] = {
@@ -161,4 +273,7 @@ U_BOOT_DRIVER(spi_sandbox) = {
 	.id	= UCLASS_SPI,
 	.of_match = sandbox_spi_ids,
 	.ops	= &sandbox_spi_ops,
+	.child_pre_probe = sandbox_spi_child_pre_probe,
+	.remove	= sandbox_spi_remove,
+	.priv_auto_alloc_size = sizeof(struct sandbox_spi_priv),
 };
@@ -27,6 +27,9 @@
 #ifdef CONFIG_FASTBOOT_FLASH_NAND_DEV
 #include <fb_nand.h>
 #endif
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+#include <image-sparse.h>
+#endif
 
 #define FASTBOOT_VERSION		"0.4"
 
@@ -62,6 +65,86 @@ static struct f_fastboot *fastboot_func;
 static unsigned int download_size;
 static unsigned int download_bytes;
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+enum {
+	STREAM_IDLE,		/* download goes to the buffer */
+	STREAM_ACTIVE,		/* download is being written to stream_part */
+	STREAM_DONE,		/* download was written to stream_part */
+};
+
+/* Partition given by "oem stream", to which the next download goes */
+static char stream_part[32];
+static struct sparse_stream stream;
+static int stream_state;
+static int stream_ret;
+
+static bool fb_stream_armed(void)
+{
+	return stream_part[0] != '\0';
+}
+
+/*
+ * Write downloaded data to the partition if it is a sparse image. This
+ * returns true if the data was consumed, false if it should be buffered.
+ */
+static bool fb_stream_data(const void *buffer, unsigned int len)
+{
+	int ret = -ENOSYS;
+
+	if (!fb_stream_armed())
+		return false;
+
+	/* The first piece decides whether this download is streamed */
+	if (!download_bytes) {
+		stream_state = STREAM_IDLE;
+		if (len < sizeof(sparse_header_t) ||
+		    !is_sparse_image((void *)buffer))
+			return false;
+#ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
+		ret = fb_mmc_stream_start(stream_part, &stream);
+#endif
+		if (ret) {
+			sparse_stream_finish(&stream);
+			return false;
+		}
+		stream_state = STREAM_ACTIVE;
+	}
+	if (stream_state != STREAM_ACTIVE)
+		return false;
+
+	/* Errors are remembered in the stream and reported by "flash" */
+	sparse_stream_write(&stream, buffer, len);
+
+	return true;
+}
+
+static void fb_stream_finish(void)
+{
+	if (stream_state != STREAM_ACTIVE)
+		return;
+
+	stream_ret = sparse_stream_finish(&stream);
+	stream_state = STREAM_DONE;
+	if (!stream_ret)
+		printf("\n........ wrote %llu bytes to '%s'",
+		       stream.bytes_written, stream_part);
+}
+#else
+static inline bool fb_stream_armed(void)
+{
+	return false;
+}
+
+static inline bool fb_stream_data(const void *buffer, unsigned int len)
+{
+	return false;
+}
+
+static inline void fb_stream_finish(void)
+{
+}
+#endif
+
 static struct usb_endpoint_descriptor fs_ep_in = {
 	.bLength            = USB_DT_ENDPOINT_SIZE,
 	.bDescriptorType    = USB_DT_ENDPOINT,
@@ -487,8 +570,11 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	if (buffer_size < transfer_size)
 		transfer_size = buffer_size;
 
-	memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
-	       buffer, transfer_size);
+	/* Anything too large for the buffer is rejected by "flash" */
+	if (!fb_stream_data(buffer, transfer_size) &&
+	    download_bytes + transfer_size <= CONFIG_FASTBOOT_BUF_SIZE)
+		memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
+		       buffer, transfer_size);
 
 	pre_dot_num = download_bytes / BYTES_PER_DOT;
 	download_bytes += transfer_size;
@@ -509,6 +595,7 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 		download_size = 0;
 		req->complete = rx_handler_command;
 		req->length = EP_BUFFER_SIZE;
+		fb_stream_finish();
 
 		strcpy(response, "OKAY");
 		fastboot_tx_write_str(response);
@@ -535,7 +622,8 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 
 	if (0 == download_size) {
 		strcpy(response, "FAILdata invalid size");
-	} else if (download_size > CONFIG_FASTBOOT_BUF_SIZE) {
+	} else if (download_size > CONFIG_FASTBOOT_BUF_SIZE &&
+		   !fb_stream_armed()) {
 		download_size = 0;
 		strcpy(response, "FAILdata too large");
 	} else {
@@ -593,6 +681,25 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 	/* initialize the response buffer */
 	fb_response_str = response;
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	if (stream_state == STREAM_DONE) {
+		if (strcmp(cmd, stream_part))
+			fastboot_fail("image was written to another partition");
+		else if (stream_ret)
+			fastboot_fail(stream.err);
+		else
+			fastboot_okay("");
+		stream_state = STREAM_IDLE;
+		stream_part[0] = '\0';
+		fastboot_tx_write_str(response);
+		return;
+	}
+#endif
+	if (download_bytes > CONFIG_FASTBOOT_BUF_SIZE) {
+		fastboot_tx_write_str("FAILdata too large");
+		return;
+	}
+
 	fastboot_fail("no flash device defined");
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
 	fb_mmc_flash_write(cmd, (void *)CONFIG_FASTBOOT_BUF_ADDR,
@@ -620,6 +727,13 @@ static void cb_oem(struct usb_ep *ep, struct usb_request *req)
                 else
 			fastboot_tx_write_str("OKAY");
 	} else
+#endif
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	if (strncmp("stream ", cmd + 4, 7) == 0) {
+		strlcpy(stream_part, cmd + 11, sizeof(stream_part));
+		stream_state = STREAM_IDLE;
+		fastboot_tx_write_str("OKAY");
+	} else
 #endif
 	if (strncmp("unlock", cmd + 4, 8) == 0) {
 		fastboot_tx_write_str("FAILnot implemented");
@@ -127,7 +127,7 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	void *line;
-	int pixels = priv->font_size * vid_priv->line_length;
+	int pixels = priv->font_size * vid_priv->xsize;
 	int i;
 
 	line = vid_priv->fb + row * priv->font_size * vid_priv->line_length;
@@ -162,6 +162,8 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	default:
 		return -ENOSYS;
 	}
+	video_damage(dev->parent, 0, row * priv->font_size, vid_priv->xsize,
+		     priv->font_size);
 
 	return 0;
 }
@@ -169,15 +171,25 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 				     uint rowsrc, uint count)
 {
+	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(dev);
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	void *dst;
 	void *src;
 	int i, diff;
 
-	dst = vid_priv->fb + rowdst * priv->font_size * vid_priv->line_length;
-	src = vid_priv->fb + rowsrc * priv->font_size * vid_priv->line_length;
-	memmove(dst, src, priv->font_size * vid_priv->line_length * count);
+	/* Scrolling the whole console up can be done by panning */
+	if (rowdst || rowsrc + count != vc_priv->rows ||
+	    video_scroll(dev->parent, rowsrc * priv->font_size)) {
+		dst = vid_priv->fb +
+			rowdst * priv->font_size * vid_priv->line_length;
+		src = vid_priv->fb +
+			rowsrc * priv->font_size * vid_priv->line_length;
+		memmove(dst, src,
+			priv->font_size * vid_priv->line_length * count);
+		video_damage(dev->parent, 0, rowdst * priv->font_size,
+			     vid_priv->xsize, count * priv->font_size);
+	}
 
 	/* Scroll up our position history */
 	diff = (rowsrc - rowdst) * priv->font_size;
@@ -296,6 +308,8 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 		line += vid_priv->line_length;
 	}
 	free(data);
+	video_damage(vid, VID_TO_PIXEL(x) + xoff, y + max(linenum, 0), width,
+		     height);
 
 	return width_frac;
 }
@@ -358,6 +372,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 		}
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent, xstart, ystart, pixels, yend - ystart);
 
 	return 0;
 }
@@ -52,12 +52,23 @@ static int sandbox_sdl_bind(struct udevice *dev)
 	plat->xres = fdtdec_get_int(blob, node, "xres", LCD_MAX_WIDTH);
 	plat->yres = fdtdec_get_int(blob, node, "yres", LCD_MAX_HEIGHT);
 	plat->bpix = VIDEO_BPP16;
-	uc_plat->size = plat->xres * plat->yres * (1 << plat->bpix) / 8;
+	/* Room for two screens, so that the console can scroll by panning */
+	uc_plat->size = 2 * plat->xres * plat->yres * (1 << plat->bpix) / 8;
 	debug("%s: Frame buffer size %x\n", __func__, uc_plat->size);
 
 	return ret;
 }
 
+static int sandbox_sdl_pan(struct udevice *dev, uint yoffset)
+{
+	/* sandbox_sdl_sync() is passed the new start of the frame buffer */
+	return 0;
+}
+
+static const struct video_ops sandbox_sdl_ops = {
+	.pan	= sandbox_sdl_pan,
+};
+
 static const struct udevice_id sandbox_sdl_ids[] = {
 	{ .compatible = "sandbox,lcd-sdl" },
 	{ }
@@ -69,5 +80,6 @@ U_BOOT_DRIVER(sdl_sandbox) = {
 	.of_match = sandbox_sdl_ids,
 	.bind	= sandbox_sdl_bind,
 	.probe	= sandbox_sdl_probe,
+	.ops	= &sandbox_sdl_ops,
 	.platdata_auto_alloc_size	= sizeof(struct sandbox_sdl_plat),
 };
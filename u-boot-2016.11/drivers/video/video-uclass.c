@@ -39,6 +39,12 @@
  * video_post_probe(). This function also clears the frame buffer and
  * allocates a suitable text console device. This can then be used to write
  * text to the video device.
+ *
+ * Whatever draws into the frame buffer records the area it changed with
+ * video_damage(), and video_sync() then flushes just those lines. If the
+ * driver can pan the display and @size covers more than one screen, the
+ * console scrolls with video_scroll(), which moves the start of the
+ * displayed area through that memory instead of copying the screen.
  */
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -87,47 +93,166 @@ int video_reserve(ulong *addrp)
 	return 0;
 }
 
-static int video_clear(struct udevice *dev)
+/* Set @count lines from line @y of the display to the background colour */
+static void video_fill_lines(struct video_priv *priv, int y, int count)
 {
-	struct video_priv *priv = dev_get_uclass_priv(dev);
+	void *start = priv->fb + y * priv->line_length;
+	int size = count * priv->line_length;
 
 	if (priv->bpix == VIDEO_BPP32) {
-		u32 *ppix = priv->fb;
-		u32 *end = priv->fb + priv->fb_size;
+		u32 *ppix = start;
+		u32 *end = start + size;
 
 		while (ppix < end)
 			*ppix++ = priv->colour_bg;
 	} else {
-		memset(priv->fb, priv->colour_bg, priv->fb_size);
+		memset(start, priv->colour_bg, size);
 	}
+}
+
+static int video_clear(struct udevice *dev)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+
+	video_fill_lines(priv, 0, priv->ysize);
+	video_damage(dev, 0, 0, priv->xsize, priv->ysize);
 
 	return 0;
 }
 
-/* Flush video activity to the caches */
-void video_sync(struct udevice *vid)
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
 {
-	/*
-	 * flush_dcache_range() is declared in common.h but it seems that some
-	 * architectures do not actually implement it. Is there a way to find
-	 * out whether it exists? For now, ARM is safe.
-	 */
-#if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
 	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_damage *damage = &priv->damage;
+	int xend = min(x + width, (int)priv->xsize);
+	int yend = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= xend || y >= yend)
+		return;
+	if (damage->xend) {
+		x = min(x, damage->xstart);
+		y = min(y, damage->ystart);
+		xend = max(xend, damage->xend);
+		yend = max(yend, damage->yend);
+	}
+	damage->xstart = x;
+	damage->ystart = y;
+	damage->xend = xend;
+	damage->yend = yend;
+}
 
-	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   (ulong)priv->fb + priv->fb_size);
+int video_scroll(struct udevice *vid, int lines)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_ops *ops = video_get_ops(vid);
+	struct video_damage *damage = &priv->damage;
+	int keep = priv->ysize - lines;
+
+	if (!ops || !ops->pan || priv->pan_stopped || lines <= 0 ||
+	    keep <= 0 || priv->fb_lines < priv->ysize + lines)
+		return -ENOSYS;
+
+	if (priv->yoffset + priv->ysize + lines <= priv->fb_lines) {
+		/* What was damaged has moved up with the rest */
+		priv->yoffset += lines;
+		damage->ystart = max(damage->ystart - lines, 0);
+		damage->yend -= lines;
+		if (damage->yend <= 0)
+			memset(damage, '\0', sizeof(*damage));
+	} else {
+		/* Out of room: copy what stays on the display to the start */
+		memmove(priv->fb_base, priv->fb + lines * priv->line_length,
+			keep * priv->line_length);
+		priv->yoffset = 0;
+		video_damage(vid, 0, 0, priv->xsize, keep);
 	}
-#elif defined(CONFIG_VIDEO_SANDBOX_SDL)
+	priv->fb = priv->fb_base + priv->yoffset * priv->line_length;
+	priv->pan_pending = true;
+
+	video_fill_lines(priv, keep, lines);
+	video_damage(vid, 0, keep, priv->xsize, lines);
+
+	return 0;
+}
+
+/* Flush video activity to the caches */
+void video_sync(struct udevice *vid)
+{
 	struct video_priv *priv = dev_get_uclass_priv(vid);
-	static ulong last_sync;
+	struct video_ops *ops = video_get_ops(vid);
+	struct video_damage *damage = &priv->damage;
+
+	if (damage->xend) {
+		/*
+		 * flush_dcache_range() is declared in common.h but it seems
+		 * that some architectures do not actually implement it. Is
+		 * there a way to find out whether it exists? For now, ARM is
+		 * safe.
+		 */
+#if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
+		if (priv->flush_dcache) {
+			ulong start = (ulong)priv->fb +
+				damage->ystart * priv->line_length;
+			ulong end = (ulong)priv->fb +
+				damage->yend * priv->line_length;
+
+			/* A line need not start or end on a cache line */
+			flush_dcache_range(rounddown(start, ARCH_DMA_MINALIGN),
+					   roundup(end, ARCH_DMA_MINALIGN));
+		}
+#elif defined(CONFIG_VIDEO_SANDBOX_SDL)
+		static ulong last_sync;
 
-	if (get_timer(last_sync) > 10) {
+		/* This redraws the whole window, so don't do it too often */
+		if (get_timer(last_sync) <= 10)
+			return;
 		sandbox_sdl_sync(priv->fb);
 		last_sync = get_timer(0);
-	}
 #endif
+		memset(damage, '\0', sizeof(*damage));
+	}
+
+	/* Show the new start of the frame buffer once it is in memory */
+	if (priv->pan_pending) {
+		priv->pan_pending = false;
+		ops->pan(vid, priv->yoffset);
+	}
+}
+
+void video_stop_pan(struct udevice *vid)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_ops *ops = video_get_ops(vid);
+
+	priv->pan_stopped = true;
+	if (priv->yoffset) {
+		memmove(priv->fb_base, priv->fb, priv->fb_size);
+		priv->yoffset = 0;
+		priv->fb = priv->fb_base;
+		priv->pan_pending = true;
+		video_damage(vid, 0, 0, priv->xsize, priv->ysize);
+	}
+	video_sync(vid);
+
+	/* video_sync() may have put off the pan, but it must happen now */
+	if (priv->pan_pending) {
+		priv->pan_pending = false;
+		ops->pan(vid, 0);
+	}
+}
+
+void video_stop_pan_all(void)
+{
+	struct udevice *dev;
+
+	for (uclass_find_first_device(UCLASS_VIDEO, &dev);
+	     dev;
+	     uclass_find_next_device(&dev)) {
+		if (device_active(dev))
+			video_stop_pan(dev);
+	}
 }
 
 void video_sync_all(void)
@@ -172,6 +297,7 @@ static int video_pre_remove(struct udevice *dev)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
+	video_stop_pan(dev);
 	free(priv->cmap);
 
 	return 0;
@@ -191,6 +317,8 @@ static int video_post_probe(struct udevice *dev)
 	priv->fb = map_sysmem(plat->base, plat->size);
 	priv->line_length = priv->xsize * VNBYTES(priv->bpix);
 	priv->fb_size = priv->line_length * priv->ysize;
+	priv->fb_base = priv->fb;
+	priv->fb_lines = plat->size / priv->line_length;
 
 	/* Set up colours - we could in future support other colours */
 #ifdef CONFIG_SYS_WHITE_ON_BLACK
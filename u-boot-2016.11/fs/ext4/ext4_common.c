@@ -1945,6 +1945,196 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	return blknr;
 }
 
+static int ext4fs_extent_cache_add(struct ext4_extent_cache *cache,
+				   struct ext4_extent *extent)
+{
+	struct ext4_extent_map *map;
+	unsigned long long start;
+	uint32_t len = le16_to_cpu(extent->ee_len);
+
+	/* Uninitialized extents read as zeroes, just like holes */
+	if (len > EXT4_EXT_INIT_MAX_LEN)
+		return 0;
+
+	if (cache->count == cache->size) {
+		int size = cache->size ? cache->size * 2 : 16;
+
+		map = realloc(cache->maps, size * sizeof(*map));
+		if (!map)
+			return -ENOMEM;
+		cache->maps = map;
+		cache->size = size;
+	}
+
+	start = le16_to_cpu(extent->ee_start_hi);
+	start = (start << 32) + le32_to_cpu(extent->ee_start_lo);
+
+	map = &cache->maps[cache->count++];
+	map->lblk = le32_to_cpu(extent->ee_block);
+	map->len = len;
+	map->pblk = start;
+
+	return 0;
+}
+
+static int ext4fs_extent_cache_walk(struct ext4_extent_cache *cache,
+				    struct ext4_extent_header *ext_block,
+				    int depth)
+{
+	struct ext4_extent_idx *index;
+	unsigned long long block;
+	int blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+	int entries = le16_to_cpu(ext_block->eh_entries);
+	int i, ret = 0;
+	char *buf;
+
+	if (le16_to_cpu(ext_block->eh_magic) != EXT4_EXT_MAGIC ||
+	    le16_to_cpu(ext_block->eh_depth) != depth)
+		return -EINVAL;
+
+	if (depth == 0) {
+		struct ext4_extent *extent =
+			(struct ext4_extent *)(ext_block + 1);
+
+		for (i = 0; i < entries && !ret; i++)
+			ret = ext4fs_extent_cache_add(cache, &extent[i]);
+		return ret;
+	}
+
+	buf = zalloc(blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	index = (struct ext4_extent_idx *)(ext_block + 1);
+	for (i = 0; i < entries && !ret; i++) {
+		block = le16_to_cpu(index[i].ei_leaf_hi);
+		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
+
+		if (!ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
+				    buf)) {
+			ret = -EIO;
+			break;
+		}
+		cache->tree_reads++;
+		ret = ext4fs_extent_cache_walk(cache,
+				(struct ext4_extent_header *)buf, depth - 1);
+	}
+	free(buf);
+
+	return ret;
+}
+
+static int ext4fs_build_extent_cache(struct ext2_inode *inode,
+				     struct ext4_extent_cache *cache)
+{
+	struct ext4_extent_header *ext_block =
+		(struct ext4_extent_header *)inode->b.blocks.dir_blocks;
+	int ret;
+
+	memset(cache, '\0', sizeof(*cache));
+	ret = ext4fs_extent_cache_walk(cache, ext_block,
+				       le16_to_cpu(ext_block->eh_depth));
+	if (ret) {
+		printf("invalid extent block\n");
+		free(cache->maps);
+		return ret;
+	}
+	debug("ext4fs: %d extents, %d tree blocks read\n", cache->count,
+	      cache->tree_reads);
+
+	return 0;
+}
+
+/**
+ * ext4fs_get_extent_cache() - get the extents of an open file
+ *
+ * The first call walks the extent tree of @node once, reading each index
+ * and leaf block a single time. The result stays with the node until it is
+ * freed, so later reads of the same file, such as the one per entry made
+ * while iterating a directory, do not walk the tree again.
+ *
+ * @node:	Node of the file, whose inode must use extents
+ * @return extents sorted by logical block, or NULL on error
+ */
+struct ext4_extent_cache *ext4fs_get_extent_cache(struct ext2fs_node *node)
+{
+	struct ext4_extent_cache *cache = node->extent_cache;
+
+	if (cache)
+		return cache;
+	cache = malloc(sizeof(*cache));
+	if (!cache)
+		return NULL;
+	if (ext4fs_build_extent_cache(&node->inode, cache)) {
+		free(cache);
+		return NULL;
+	}
+	node->extent_cache = cache;
+
+	return cache;
+}
+
+/**
+ * ext4fs_extent_cache_lookup() - find the physical block of a file block
+ *
+ * Lookups are expected to be mostly sequential, so the search starts from
+ * the extent found last time.
+ *
+ * @cache:	Extent cache built by ext4fs_build_extent_cache()
+ * @fileblock:	Logical block within the file
+ * @return physical block number, or 0 if @fileblock is not allocated
+ */
+long int ext4fs_extent_cache_lookup(struct ext4_extent_cache *cache,
+				    uint32_t fileblock)
+{
+	struct ext4_extent_map *map;
+	int lo = 0, hi = cache->count;
+
+	if (cache->cur < cache->count) {
+		map = &cache->maps[cache->cur];
+		if (fileblock >= map->lblk) {
+			if (fileblock < map->lblk + map->len)
+				return map->pblk + fileblock - map->lblk;
+			lo = cache->cur + 1;
+			if (lo < cache->count &&
+			    fileblock < cache->maps[lo].lblk)
+				return 0;
+		} else {
+			hi = cache->cur;
+		}
+	}
+
+	/* Find the last extent starting at or before fileblock */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (cache->maps[mid].lblk <= fileblock)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (!lo)
+		return 0;
+
+	map = &cache->maps[lo - 1];
+	if (fileblock >= map->lblk + map->len)
+		return 0;
+	cache->cur = lo - 1;
+
+	return map->pblk + fileblock - map->lblk;
+}
+
+void ext4fs_free_extent_cache(struct ext2fs_node *node)
+{
+	if (!node->extent_cache)
+		return;
+	free(node->extent_cache->maps);
+	free(node->extent_cache);
+	node->extent_cache = NULL;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -1985,6 +2175,7 @@ void ext4fs_close(void)
 		ext4fs_file = NULL;
 	}
 	if (ext4fs_root != NULL) {
+		ext4fs_free_extent_cache(&ext4fs_root->diropen);
 		free(ext4fs_root);
 		ext4fs_root = NULL;
 	}
@@ -2354,6 +2545,7 @@ int ext4fs_mount(unsigned part_length)
 	data->diropen.data = data;
 	data->diropen.ino = 2;
 	data->diropen.inode_read = 1;
+	data->diropen.extent_cache = NULL;
 	data->inode = &data->diropen.inode;
 
 	status = ext4fs_read_inode(data, 2, data->inode);
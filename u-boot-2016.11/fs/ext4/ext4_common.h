@@ -48,8 +48,32 @@ static inline void *zalloc(size_t size)
 	return p;
 }
 
+/*
+ * A run of logical file blocks mapped to consecutive physical blocks
+ */
+struct ext4_extent_map {
+	uint32_t lblk;		/* first logical block */
+	uint32_t len;		/* number of blocks */
+	uint64_t pblk;		/* first physical block */
+};
+
+/*
+ * All the extents of one file, collected by walking its extent tree once
+ */
+struct ext4_extent_cache {
+	struct ext4_extent_map *maps;
+	int count;		/* number of valid entries in maps */
+	int size;		/* number of allocated entries in maps */
+	int cur;		/* entry returned by the last lookup */
+	int tree_reads;		/* extent tree blocks read to build the cache */
+};
+
 int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
+struct ext4_extent_cache *ext4fs_get_extent_cache(struct ext2fs_node *node);
+long int ext4fs_extent_cache_lookup(struct ext4_extent_cache *cache,
+				    uint32_t fileblock);
+void ext4fs_free_extent_cache(struct ext2fs_node *node);
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos, loff_t len,
 		     char *buf, loff_t *actread);
 int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
@@ -37,8 +37,10 @@ struct ext_filesystem *get_fs(void)
 
 void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 {
-	if ((node != &ext4fs_root->diropen) && (node != currroot))
+	if ((node != &ext4fs_root->diropen) && (node != currroot)) {
+		ext4fs_free_extent_cache(node);
 		free(node);
+	}
 }
 
 /*
@@ -62,6 +64,7 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
+	struct ext4_extent_cache *extents = NULL;
 	short status;
 
 	/* Adjust len so it we can't read past the end of the file. */
@@ -70,12 +73,23 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
+	/* Map the whole extent tree once rather than once per block */
+	if (le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL) {
+		extents = ext4fs_get_extent_cache(node);
+		if (!extents)
+			return -1;
+	}
+
 	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
 		lbaint_t blknr;
 		int blockoff = pos - (blocksize * i);
 		int blockend = blocksize;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
+
+		if (extents)
+			blknr = ext4fs_extent_cache_lookup(extents, i);
+		else
+			blknr = read_allocated_block(&(node->inode), i);
 		if (blknr < 0)
 			return -1;
 
@@ -162,90 +162,178 @@ static void get_name(dir_entry *dirent, char *s_name)
 	downcase(s_name);
 }
 
+/*
+ * Set up the FAT cache used by get_fatent(). The table is read in windows
+ * of FATCACHEBLOCKS sectors as they are needed, so a small file only reads
+ * the part of the table its cluster chain is in. There are enough windows
+ * for the whole table if it fits in CONFIG_FS_FAT_CACHE_SIZE, so following
+ * a fragmented chain never reads a sector twice. Otherwise the windows are
+ * recycled in LRU order. Window buffers are only allocated when first used.
+ */
+static int fat_cache_init(fsdata *mydata)
+{
+	__u32 winsize = FATCACHEBLOCKS * mydata->sect_size;
+	int i;
+
+	mydata->fatcache_blocks = FATCACHEBLOCKS;
+	mydata->fatcache_wins = min_t(__u32,
+				      DIV_ROUND_UP(mydata->fatlength,
+						   FATCACHEBLOCKS),
+				      CONFIG_FS_FAT_CACHE_SIZE / winsize);
+	if (!mydata->fatcache_wins)
+		mydata->fatcache_wins = 1;
+
+	mydata->fatcache = calloc(mydata->fatcache_wins,
+				  sizeof(struct fat_cache_win));
+	if (!mydata->fatcache)
+		return -1;
+	for (i = 0; i < mydata->fatcache_wins; i++)
+		mydata->fatcache[i].bufnum = -1;
+	mydata->fatcache_tick = 0;
+	mydata->fat_sect_reads = 0;
+
+	debug("FAT cache: %d window(s) of %u sectors\n",
+	      mydata->fatcache_wins, mydata->fatcache_blocks);
+
+	return 0;
+}
+
+static void fat_cache_free(fsdata *mydata)
+{
+	int i;
+
+	debug("FAT cache: %u FAT sectors read\n", mydata->fat_sect_reads);
+
+	for (i = 0; i < mydata->fatcache_wins; i++)
+		free(mydata->fatcache[i].buf);
+	free(mydata->fatcache);
+	mydata->fatcache = NULL;
+	mydata->fatcache_wins = 0;
+}
+
+/*
+ * Return the FAT cache window 'bufnum', reading it if needed.
+ * On failure NULL is returned.
+ */
+static __u8 *fat_cache_get(fsdata *mydata, int bufnum)
+{
+	struct fat_cache_win *win, *lru = NULL, *lru_alloc = NULL;
+	__u32 getsize = mydata->fatcache_blocks;
+	__u32 startblock = bufnum * getsize;
+	int i;
+
+	for (i = 0; i < mydata->fatcache_wins; i++) {
+		win = &mydata->fatcache[i];
+		if (win->bufnum == bufnum) {
+			win->used = ++mydata->fatcache_tick;
+			return win->buf;
+		}
+		if (!lru || win->used < lru->used)
+			lru = win;
+		if (win->buf && (!lru_alloc || win->used < lru_alloc->used))
+			lru_alloc = win;
+	}
+
+	if (!lru->buf) {
+		lru->buf = memalign(ARCH_DMA_MINALIGN,
+				    getsize * mydata->sect_size);
+		/* Out of memory: recycle a window we already have */
+		if (!lru->buf)
+			lru = lru_alloc;
+		if (!lru) {
+			debug("Error: allocating FAT cache\n");
+			return NULL;
+		}
+	}
+
+	if (startblock + getsize > mydata->fatlength)
+		getsize = mydata->fatlength - startblock;
+
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	lru->bufnum = -1;
+	if (disk_read(startblock, getsize, lru->buf) < 0) {
+		debug("Error reading FAT blocks\n");
+		return NULL;
+	}
+	mydata->fat_sect_reads += getsize;
+	lru->bufnum = bufnum;
+	lru->used = ++mydata->fatcache_tick;
+
+	return lru->buf;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
  */
 static __u32 get_fatent(fsdata *mydata, __u32 entry)
 {
-	__u32 bufnum;
+	__u32 bufnum, entries;
 	__u32 off16, offset;
 	__u32 ret = 0x00;
 	__u16 val1, val2;
+	__u8 *fatbuf;
 
+	entries = mydata->fatcache_blocks * mydata->sect_size;
 	switch (mydata->fatsize) {
 	case 32:
-		bufnum = entry / FAT32BUFSIZE;
-		offset = entry - bufnum * FAT32BUFSIZE;
+		entries /= 4;
 		break;
 	case 16:
-		bufnum = entry / FAT16BUFSIZE;
-		offset = entry - bufnum * FAT16BUFSIZE;
+		entries /= 2;
 		break;
 	case 12:
-		bufnum = entry / FAT12BUFSIZE;
-		offset = entry - bufnum * FAT12BUFSIZE;
+		entries = (entries * 2) / 3;
 		break;
 
 	default:
 		/* Unsupported FAT size */
 		return ret;
 	}
+	bufnum = entry / entries;
+	offset = entry - bufnum * entries;
 
 	debug("FAT%d: entry: 0x%04x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	/* Find the block of FAT entries in the cache. */
+	fatbuf = fat_cache_get(mydata, bufnum);
+	if (!fatbuf)
+		return ret;
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *) fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *) fatbuf)[offset]);
 		break;
 	case 12:
 		off16 = (offset * 3) / 4;
 
 		switch (offset & 0x3) {
 		case 0:
-			ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[off16]);
+			ret = FAT2CPU16(((__u16 *) fatbuf)[off16]);
 			ret &= 0xfff;
 			break;
 		case 1:
-			val1 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			val1 = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			val1 &= 0xf000;
-			val2 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16 + 1]);
+			val2 = FAT2CPU16(((__u16 *)fatbuf)[off16 + 1]);
 			val2 &= 0x00ff;
 			ret = (val2 << 4) | (val1 >> 12);
 			break;
 		case 2:
-			val1 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			val1 = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			val1 &= 0xff00;
-			val2 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16 + 1]);
+			val2 = FAT2CPU16(((__u16 *)fatbuf)[off16 + 1]);
 			val2 &= 0x000f;
 			ret = (val2 << 8) | (val1 >> 8);
 			break;
 		case 3:
-			ret = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			ret = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			ret = (ret & 0xfff0) >> 4;
 			break;
 		default:
@@ -875,10 +963,7 @@ int do_fat_read_at(const char *filename, loff_t pos, void *buffer,
 					(mydata->clust_size * 2);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	if (fat_cache_init(mydata)) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
@@ -1231,7 +1316,7 @@ rootdir_done:
 	debug("Size: %u, got: %llu\n", FAT2CPU32(dentptr->size), *size);
 
 exit:
-	free(mydata->fatbuf);
+	fat_cache_free(mydata);
 	return ret;
 }
 
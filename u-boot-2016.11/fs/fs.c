@@ -7,6 +7,7 @@
 #include <config.h>
 #include <errno.h>
 #include <common.h>
+#include <hash.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
@@ -303,7 +304,12 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	 * means read the whole file.
 	 */
 	buf = map_sysmem(addr, len);
+	hash_stream_start(buf);
 	ret = info->read(filename, buf, offset, len, actread);
+	if (ret == 0)
+		hash_stream_finish(*actread);
+	else
+		hash_stream_abort();
 	unmap_sysmem(buf);
 
 	/* If we requested a specific number of bytes, check we got it */
@@ -1503,6 +1503,10 @@ static int mount_ubifs(struct ubifs_info *c)
 	}
 #endif
 
+#ifdef __UBOOT__
+	ubifs_tnc_snap_load(c);
+#endif
+
 	err = dbg_check_idx_size(c, c->bi.old_idx_sz);
 	if (err)
 		goto out_lpt;
@@ -1684,6 +1688,9 @@ out_orphans:
 out_journal:
 	destroy_journal(c);
 out_lpt:
+#ifdef __UBOOT__
+	ubifs_tnc_snap_free(c);
+#endif
 	ubifs_lpt_free(c, 0);
 out_master:
 	kfree(c->mst_node);
@@ -1749,6 +1756,7 @@ void ubifs_umount(struct ubifs_info *c)
 	kfree(c->bottom_up_buf);
 	ubifs_debugging_exit(c);
 #ifdef __UBOOT__
+	ubifs_tnc_snap_free(c);
 	/* Finally free U-Boot's global copy of superblock */
 	if (ubifs_sb != NULL) {
 		free(ubifs_sb->s_fs_info);
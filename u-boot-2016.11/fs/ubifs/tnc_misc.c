@@ -272,11 +272,22 @@ static int read_znode(struct ubifs_info *c, int lnum, int offs, int len,
 	if (!idx)
 		return -ENOMEM;
 
+#ifdef __UBOOT__
+	if (ubifs_tnc_snap_read(c, idx, len, lnum, offs)) {
+		err = ubifs_read_node(c, idx, UBIFS_IDX_NODE, len, lnum, offs);
+		if (err < 0) {
+			kfree(idx);
+			return err;
+		}
+		ubifs_tnc_snap_add(c, idx, len, lnum, offs);
+	}
+#else
 	err = ubifs_read_node(c, idx, UBIFS_IDX_NODE, len, lnum, offs);
 	if (err < 0) {
 		kfree(idx);
 		return err;
 	}
+#endif
 
 	znode->child_cnt = le16_to_cpu(idx->child_cnt);
 	znode->level = le16_to_cpu(idx->level);
@@ -0,0 +1,397 @@
+/*
+ * Snapshot of UBIFS indexing nodes kept in memory between boots
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+/*
+ * Looking up a file walks the index from the root and reads an indexing node
+ * from flash for each znode which is not yet in the TNC. That is several
+ * scattered reads per path component, repeated on every boot. Index nodes are
+ * never changed in place: the ones written by a commit stay where they are
+ * until the next commit, which also writes a new master node. So the nodes
+ * read during one boot are saved, with the UUID and the master node's sequence
+ * number, to a region of RAM which survives a reset. The next mount of the
+ * same file-system copies that region in with one read and only goes to flash
+ * for nodes which are not in it. If anything does not match - another volume,
+ * a commit since, a bad CRC - the snapshot is ignored and rebuilt.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <linux/crc32.h>
+#include "ubifs.h"
+
+/* There is no address which is safe on every board, so insist on one */
+#if !(CONFIG_UBIFS_TNC_SNAPSHOT_ADDR + 0)
+#error "Set CONFIG_UBIFS_TNC_SNAPSHOT_ADDR to memory kept across resets"
+#endif
+
+#define TNC_SNAP_MAGIC		0x434e5455	/* "UTNC" */
+#define TNC_SNAP_VERSION	1
+
+/**
+ * struct tnc_snap_hdr - header of the snapshot in the stash region
+ *
+ * @magic: TNC_SNAP_MAGIC
+ * @crc: CRC32 of the rest of the snapshot, from @version to the end
+ * @version: TNC_SNAP_VERSION
+ * @size: total size of the snapshot in bytes, including this header
+ * @count: number of entries following the header
+ * @sqnum: sequence number of the master node the nodes belong to
+ * @cmt_no: commit number from that master node
+ * @uuid: file-system UUID from the superblock
+ */
+struct tnc_snap_hdr {
+	__le32 magic;
+	__le32 crc;
+	__le32 version;
+	__le32 size;
+	__le32 count;
+	__le32 padding;
+	__le64 sqnum;
+	__le64 cmt_no;
+	__u8 uuid[16];
+};
+
+/**
+ * struct tnc_snap_ent - one indexing node, sorted by @lnum then @offs
+ *
+ * @lnum: LEB of the node on flash
+ * @offs: offset of the node in that LEB
+ * @len: length of the node
+ * @data: offset of the node's contents from the start of the snapshot
+ */
+struct tnc_snap_ent {
+	__le32 lnum;
+	__le32 offs;
+	__le32 len;
+	__le32 data;
+};
+
+/**
+ * struct ubifs_tnc_snap - snapshot state for a mounted file-system
+ *
+ * @buf: copy of the valid snapshot found at mount, or NULL if none
+ * @ents: entries in @buf
+ * @count: number of entries in @ents
+ * @added: nodes read from flash since, each a struct tnc_snap_ent (with @data
+ *	unused) followed by the node padded to 8 bytes
+ * @added_size: bytes used in @added
+ * @added_alloc: bytes allocated for @added
+ * @added_count: number of nodes in @added
+ * @full: set once the nodes no longer fit in the stash region
+ * @hits: index nodes taken from @buf
+ * @reads: index nodes read from flash
+ */
+struct ubifs_tnc_snap {
+	void *buf;
+	struct tnc_snap_ent *ents;
+	int count;
+	void *added;
+	int added_size;
+	int added_alloc;
+	int added_count;
+	bool full;
+	unsigned int hits;
+	unsigned int reads;
+};
+
+static int check_snap(struct ubifs_info *c, const struct tnc_snap_hdr *hdr)
+{
+	const struct tnc_snap_ent *ent = (const void *)(hdr + 1);
+	int size = le32_to_cpu(hdr->size);
+	int count = le32_to_cpu(hdr->count);
+	int i;
+
+	if (le32_to_cpu(hdr->magic) != TNC_SNAP_MAGIC)
+		return -ENOENT;
+	if (le32_to_cpu(hdr->version) != TNC_SNAP_VERSION ||
+	    size < (int)sizeof(*hdr) || size > CONFIG_UBIFS_TNC_SNAPSHOT_SIZE ||
+	    count < 0 ||
+	    count > (size - (int)sizeof(*hdr)) / (int)sizeof(*ent))
+		return -EINVAL;
+	if (memcmp(hdr->uuid, c->uuid, sizeof(hdr->uuid)) ||
+	    le64_to_cpu(hdr->sqnum) != le64_to_cpu(c->mst_node->ch.sqnum) ||
+	    le64_to_cpu(hdr->cmt_no) != c->cmt_no)
+		return -ESTALE;
+	if (crc32(UBIFS_CRC32_INIT, (const void *)&hdr->version, size - 8) !=
+	    le32_to_cpu(hdr->crc))
+		return -EBADMSG;
+
+	for (i = 0; i < count; i++, ent++) {
+		int data = le32_to_cpu(ent->data);
+		int len = le32_to_cpu(ent->len);
+
+		if (len < UBIFS_IDX_NODE_SZ || len > c->max_idx_node_sz ||
+		    data < (int)sizeof(*hdr) || data > size - len)
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * ubifs_tnc_snap_load - take in the snapshot from the stash region.
+ * @c: UBIFS file-system description object
+ *
+ * This is called when mounting, once the master node has been read and
+ * before anything is looked up in the index. Failing to allocate memory just
+ * leaves the snapshot disabled; there is nothing here which stops the mount.
+ */
+void ubifs_tnc_snap_load(struct ubifs_info *c)
+{
+	const struct tnc_snap_hdr *hdr;
+	struct ubifs_tnc_snap *snap;
+	int ret, size;
+
+	if (!c->ro_mount)
+		return;
+	snap = kzalloc(sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		return;
+	c->tnc_snap = snap;
+
+	hdr = map_sysmem(CONFIG_UBIFS_TNC_SNAPSHOT_ADDR,
+			 CONFIG_UBIFS_TNC_SNAPSHOT_SIZE);
+	ret = check_snap(c, hdr);
+	if (ret) {
+		if (ret != -ENOENT)
+			ubifs_msg(c, "TNC snapshot not used (err %d)", ret);
+		goto out;
+	}
+
+	size = le32_to_cpu(hdr->size);
+	snap->buf = malloc(size);
+	if (!snap->buf)
+		goto out;
+	memcpy(snap->buf, hdr, size);
+	snap->ents = snap->buf + sizeof(*hdr);
+	snap->count = le32_to_cpu(hdr->count);
+	ubifs_msg(c, "TNC snapshot: %d index nodes", snap->count);
+out:
+	unmap_sysmem(hdr);
+}
+
+/**
+ * ubifs_tnc_snap_read - read an indexing node from the snapshot.
+ * @c: UBIFS file-system description object
+ * @buf: buffer to read to
+ * @len: node length
+ * @lnum: LEB of the node
+ * @offs: offset of the node
+ *
+ * Returns zero if the node was found in the snapshot and %-ENOENT if it must
+ * be read from flash, which includes a copy which fails the node checks.
+ */
+int ubifs_tnc_snap_read(struct ubifs_info *c, void *buf, int len, int lnum,
+			int offs)
+{
+	struct ubifs_tnc_snap *snap = c->tnc_snap;
+	const struct ubifs_ch *ch;
+	int lo = 0, hi;
+
+	if (!snap)
+		return -ENOENT;
+	hi = snap->count;
+	while (lo < hi) {
+		const struct tnc_snap_ent *ent = &snap->ents[(lo + hi) / 2];
+		int elnum = le32_to_cpu(ent->lnum);
+		int eoffs = le32_to_cpu(ent->offs);
+
+		if (elnum < lnum || (elnum == lnum && eoffs < offs)) {
+			lo = (lo + hi) / 2 + 1;
+		} else if (elnum > lnum || eoffs > offs) {
+			hi = (lo + hi) / 2;
+		} else {
+			if (le32_to_cpu(ent->len) != len)
+				break;
+			/*
+			 * Check the node as ubifs_read_node() would. It was
+			 * written by the commit the master node closes, so it
+			 * cannot be newer than that either.
+			 */
+			ch = snap->buf + le32_to_cpu(ent->data);
+			if (ch->node_type != UBIFS_IDX_NODE ||
+			    le32_to_cpu(ch->len) != len ||
+			    le64_to_cpu(ch->sqnum) >
+			    le64_to_cpu(c->mst_node->ch.sqnum) ||
+			    ubifs_check_node(c, ch, lnum, offs, 1, 1)) {
+				ubifs_msg(c, "bad TNC snapshot node at %d:%d",
+					  lnum, offs);
+				break;
+			}
+			memcpy(buf, ch, len);
+			snap->hits++;
+			return 0;
+		}
+	}
+	snap->reads++;
+
+	return -ENOENT;
+}
+
+/**
+ * ubifs_tnc_snap_add - note an indexing node read from flash.
+ * @c: UBIFS file-system description object
+ * @buf: the node, already checked by ubifs_read_node()
+ * @len: node length
+ * @lnum: LEB of the node
+ * @offs: offset of the node
+ */
+void ubifs_tnc_snap_add(struct ubifs_info *c, const void *buf, int len,
+			int lnum, int offs)
+{
+	struct ubifs_tnc_snap *snap = c->tnc_snap;
+	struct tnc_snap_ent *ent;
+	int size = sizeof(*ent) + ALIGN(len, 8);
+
+	if (!snap || snap->full)
+		return;
+	if (snap->added_size + size > snap->added_alloc) {
+		int alloc = max(snap->added_alloc * 2, 16 << 10);
+		void *added = realloc(snap->added, alloc);
+
+		if (!added) {
+			snap->full = true;
+			return;
+		}
+		snap->added = added;
+		snap->added_alloc = alloc;
+	}
+
+	ent = snap->added + snap->added_size;
+	ent->lnum = cpu_to_le32(lnum);
+	ent->offs = cpu_to_le32(offs);
+	ent->len = cpu_to_le32(len);
+	memcpy(ent + 1, buf, len);
+	snap->added_size += size;
+	snap->added_count++;
+}
+
+static int ent_cmp(const void *a, const void *b)
+{
+	const struct tnc_snap_ent *ea = *(const struct tnc_snap_ent **)a;
+	const struct tnc_snap_ent *eb = *(const struct tnc_snap_ent **)b;
+	int lnum = le32_to_cpu(ea->lnum) - le32_to_cpu(eb->lnum);
+
+	if (lnum)
+		return lnum;
+	return le32_to_cpu(ea->offs) - le32_to_cpu(eb->offs);
+}
+
+/* Find the contents of an entry, either in the snapshot or in 'added' */
+static const void *ent_data(struct ubifs_tnc_snap *snap,
+			    const struct tnc_snap_ent *ent)
+{
+	if ((void *)ent >= snap->added &&
+	    (void *)ent < snap->added + snap->added_size)
+		return ent + 1;
+
+	return snap->buf + le32_to_cpu(ent->data);
+}
+
+/**
+ * ubifs_tnc_snap_save - write the snapshot back to the stash region.
+ * @c: UBIFS file-system description object
+ *
+ * Merges the nodes read from flash since mounting into the snapshot and
+ * writes it out, if there are any and it fits. This is called after a file
+ * has been read, so that the stash is ready for the next boot even if the
+ * file-system is never unmounted.
+ */
+void ubifs_tnc_snap_save(struct ubifs_info *c)
+{
+	struct ubifs_tnc_snap *snap = c->tnc_snap;
+	const struct tnc_snap_ent **list;
+	struct tnc_snap_ent *ents;
+	struct tnc_snap_hdr *hdr;
+	int count, size, data, i;
+	void *buf, *stash;
+
+	if (!snap || !snap->added_count)
+		return;
+	debug("UBIFS: TNC snapshot hits %u, flash reads %u\n", snap->hits,
+	      snap->reads);
+
+	count = snap->count + snap->added_count;
+	list = malloc(count * sizeof(*list));
+	if (!list)
+		return;
+	size = sizeof(*hdr) + count * sizeof(*ents);
+	for (i = 0; i < snap->count; i++) {
+		list[i] = &snap->ents[i];
+		size += ALIGN(le32_to_cpu(list[i]->len), 8);
+	}
+	for (data = 0; i < count; i++) {
+		list[i] = snap->added + data;
+		data += sizeof(**list) + ALIGN(le32_to_cpu(list[i]->len), 8);
+	}
+	size += snap->added_size - snap->added_count * sizeof(*ents);
+	if (size > CONFIG_UBIFS_TNC_SNAPSHOT_SIZE) {
+		ubifs_msg(c, "TNC snapshot of %d bytes does not fit", size);
+		snap->full = true;
+		snap->added_size = 0;
+		snap->added_count = 0;
+		goto out_list;
+	}
+	qsort(list, count, sizeof(*list), ent_cmp);
+
+	buf = malloc(size);
+	if (!buf)
+		goto out_list;
+	hdr = buf;
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = cpu_to_le32(TNC_SNAP_MAGIC);
+	hdr->version = cpu_to_le32(TNC_SNAP_VERSION);
+	hdr->size = cpu_to_le32(size);
+	hdr->count = cpu_to_le32(count);
+	hdr->sqnum = c->mst_node->ch.sqnum;
+	hdr->cmt_no = cpu_to_le64(c->cmt_no);
+	memcpy(hdr->uuid, c->uuid, sizeof(hdr->uuid));
+
+	ents = buf + sizeof(*hdr);
+	data = sizeof(*hdr) + count * sizeof(*ents);
+	for (i = 0; i < count; i++) {
+		int len = le32_to_cpu(list[i]->len);
+
+		ents[i] = *list[i];
+		ents[i].data = cpu_to_le32(data);
+		memcpy(buf + data, ent_data(snap, list[i]), len);
+		memset(buf + data + len, '\0', ALIGN(len, 8) - len);
+		data += ALIGN(len, 8);
+	}
+	hdr->crc = cpu_to_le32(crc32(UBIFS_CRC32_INIT,
+				     (const void *)&hdr->version, size - 8));
+
+	stash = map_sysmem(CONFIG_UBIFS_TNC_SNAPSHOT_ADDR, size);
+	memcpy(stash, buf, size);
+	unmap_sysmem(stash);
+
+	/* The new snapshot serves the rest of this boot */
+	free(snap->buf);
+	snap->buf = buf;
+	snap->ents = ents;
+	snap->count = count;
+	snap->added_size = 0;
+	snap->added_count = 0;
+out_list:
+	free(list);
+}
+
+/**
+ * ubifs_tnc_snap_free - free the snapshot state.
+ * @c: UBIFS file-system description object
+ */
+void ubifs_tnc_snap_free(struct ubifs_info *c)
+{
+	struct ubifs_tnc_snap *snap = c->tnc_snap;
+
+	if (!snap)
+		return;
+	free(snap->added);
+	free(snap->buf);
+	kfree(snap);
+	c->tnc_snap = NULL;
+}
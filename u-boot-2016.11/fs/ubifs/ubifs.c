@@ -917,6 +917,7 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 		*actread = i * PAGE_SIZE;
 	} else {
 		*actread = size;
+		ubifs_tnc_snap_save(c);
 	}
 
 put_inode:
@@ -1579,6 +1579,7 @@ struct ubifs_budg_info {
 };
 
 struct ubifs_debug_info;
+struct ubifs_tnc_snap;
 
 /**
  * struct ubifs_info - UBIFS file-system description data structure
@@ -1826,6 +1827,8 @@ struct ubifs_debug_info;
  * @size_tree: inode size information for recovery
  * @mount_opts: UBIFS-specific mount options
  *
+ * @tnc_snap: snapshot of indexing nodes kept between boots (U-Boot only)
+ *
  * @dbg: debugging-related information
  */
 struct ubifs_info {
@@ -2057,6 +2060,9 @@ struct ubifs_info {
 	struct rb_root size_tree;
 	struct ubifs_mount_opts mount_opts;
 
+#ifdef CONFIG_UBIFS_TNC_SNAPSHOT
+	struct ubifs_tnc_snap *tnc_snap;
+#endif
 #ifndef __UBOOT__
 	struct ubifs_debug_info *dbg;
 #endif
@@ -2402,5 +2408,27 @@ int ubifs_decompress(const struct ubifs_info *c, const void *buf, int len,
 
 #ifdef __UBOOT__
 void ubifs_umount(struct ubifs_info *c);
+
+/* tnc_snap.c */
+#ifdef CONFIG_UBIFS_TNC_SNAPSHOT
+void ubifs_tnc_snap_load(struct ubifs_info *c);
+int ubifs_tnc_snap_read(struct ubifs_info *c, void *buf, int len, int lnum,
+			int offs);
+void ubifs_tnc_snap_add(struct ubifs_info *c, const void *buf, int len,
+			int lnum, int offs);
+void ubifs_tnc_snap_save(struct ubifs_info *c);
+void ubifs_tnc_snap_free(struct ubifs_info *c);
+#else
+static inline void ubifs_tnc_snap_load(struct ubifs_info *c) {}
+static inline int ubifs_tnc_snap_read(struct ubifs_info *c, void *buf, int len,
+				      int lnum, int offs)
+{
+	return -ENOENT;
+}
+static inline void ubifs_tnc_snap_add(struct ubifs_info *c, const void *buf,
+				      int len, int lnum, int offs) {}
+static inline void ubifs_tnc_snap_save(struct ubifs_info *c) {}
+static inline void ubifs_tnc_snap_free(struct ubifs_info *c) {}
+#endif
 #endif
 #endif /* !__UBIFS_H__ */
@@ -69,6 +69,15 @@ struct blk_desc {
 	 * device. Once these functions are removed we can drop this field.
 	 */
 	struct udevice *bdev;
+	struct blk_async_read {
+		lbaint_t start;
+		lbaint_t blkcnt;
+		void *buffer;
+		unsigned long result;	/* if it finished when started */
+		bool active;		/* blk_dwait() has yet to be called */
+		bool pending;		/* the driver is still reading */
+		bool cached;		/* found in the block cache */
+	} async;
 #else
 	unsigned long	(*block_read)(struct blk_desc *block_dev,
 				      lbaint_t start,
@@ -131,13 +140,51 @@ void blkcache_fill(int iftype, int dev,
  */
 void blkcache_invalidate(int iftype, int dev);
 
+/**
+ * blkcache_remove() - discard the cache and statistics for a device
+ * which is going away.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ */
+void blkcache_remove(int iftype, int dev);
+
+/**
+ * blkcache_read_ahead() - read a sequential run of blocks with read-ahead
+ *
+ * If @start continues the previous read on this device and read-ahead is
+ * enabled, a full read-ahead window is read from the device, added to the
+ * cache and the requested blocks are copied to @buffer.
+ *
+ * @param block_dev - block device to read from
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to read
+ * @param buffer - buffer to contain the data
+ * @param read - function to read blocks from the device
+ *
+ * @return - @blkcnt if the blocks were read, '0' if read-ahead does not
+ * apply and the caller should read the blocks itself.
+ */
+ulong blkcache_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer,
+			  ulong (*read)(struct blk_desc *block_dev,
+					lbaint_t start, lbaint_t blkcnt,
+					void *buffer));
+
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param max_bytes - maximum size in bytes of the cached data
+ * @param blocks - maximum blocks per read to be cached
+ */
+void blkcache_configure(unsigned max_bytes, unsigned blocks);
+
+/**
+ * blkcache_set_readahead() - set the size of the read-ahead window
+ *
+ * @param blocks - blocks to read ahead, '0' to disable read-ahead
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_set_readahead(unsigned blocks);
 
 /*
  * statistics of the block cache
@@ -145,9 +192,24 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
-	unsigned entries; /* current entry count */
-	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned entries; /* current number of cached blocks */
+	unsigned bytes; /* current size of cached data */
+	unsigned max_bytes;
+	unsigned max_blocks_per_read;
+	unsigned readahead; /* read-ahead window in blocks */
+};
+
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned reads; /* reads issued to the device */
+	unsigned long blocks; /* blocks read from the device */
+	unsigned readaheads;
 };
 
 /**
@@ -157,6 +219,13 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - walk per-device statistics and reset them
+ *
+ * @param func - called with the statistics of each device
+ */
+void blkcache_dev_stats(void (*func)(struct block_cache_dev_stats *dev));
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -170,8 +239,21 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline ulong blkcache_read_ahead(struct blk_desc *block_dev,
+				       lbaint_t start, lbaint_t blkcnt,
+				       void *buffer,
+				       ulong (*read)(struct blk_desc *block_dev,
+						     lbaint_t start,
+						     lbaint_t blkcnt,
+						     void *buffer))
+{
+	return 0;
+}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
+static inline void blkcache_remove(int iftype, int dev) {}
+
 #endif
 
 #ifdef CONFIG_BLK
@@ -192,6 +274,33 @@ struct blk_ops {
 	unsigned long (*read)(struct udevice *dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer);
 
+	/**
+	 * read_async() - start reading from a block device (optional)
+	 *
+	 * This starts a read and returns without waiting for the data, so
+	 * that the caller can get on with something else meanwhile. Only
+	 * one read can be in progress on a device and nothing else may be
+	 * done with the device until wait() has been called.
+	 *
+	 * @dev:	Device to read from
+	 * @start:	Start block number to read (0=first)
+	 * @blkcnt:	Number of blocks to read
+	 * @buffer:	Destination buffer for data read
+	 * @return 0 if the read was started, -ve error number if not, in
+	 * which case the caller can use read() instead
+	 */
+	int (*read_async)(struct udevice *dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer);
+
+	/**
+	 * wait() - wait for the read started by read_async() to finish
+	 *
+	 * @dev:	Device which is reading
+	 * @return number of blocks read, or -ve error number (see the
+	 * IS_ERR_VALUE() macro
+	 */
+	unsigned long (*wait)(struct udevice *dev);
+
 	/**
 	 * write() - write to a block device
 	 *
@@ -252,6 +361,71 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dread_async() - Start reading from a block device
+ *
+ * The data is not valid, and the device must not otherwise be used, until
+ * blk_dwait() has been called. If the driver cannot read in the background
+ * the read is done straight away and blk_dwait() just returns the result,
+ * so callers need not care whether the device supports this. The same
+ * happens if @buffer or the length of the read is not a multiple of
+ * ARCH_DMA_MINALIGN, since the cache lines it shares could not safely be
+ * invalidated once the data arrives.
+ *
+ * @block_dev:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer for data read
+ * @return 0 if OK, -EBUSY if a read is already in progress
+ */
+int blk_dread_async(struct blk_desc *block_dev, lbaint_t start,
+		    lbaint_t blkcnt, void *buffer);
+
+/**
+ * blk_dwait() - Wait for a read started by blk_dread_async()
+ *
+ * @block_dev:	Block device which is reading
+ * @return number of blocks read, or -ve error number (see the
+ * IS_ERR_VALUE() macro
+ */
+unsigned long blk_dwait(struct blk_desc *block_dev);
+
+/* Amount read at a time by blk_read_pipe() */
+#define BLK_PIPE_CHUNK_SIZE	(1 << 20)
+
+/**
+ * blk_pipe_func - Process a piece of data read by blk_read_pipe()
+ *
+ * @priv:	Private data passed to blk_read_pipe()
+ * @buf:	Start of the piece just read
+ * @len:	Length of the piece in bytes
+ * @return 0 to carry on, 1 to stop reading as nothing more is needed,
+ * -ve on error
+ */
+typedef int (*blk_pipe_func)(void *priv, void *buf, unsigned long len);
+
+/**
+ * blk_read_pipe() - Read blocks, working on each piece while reading the next
+ *
+ * The data is read in pieces of BLK_PIPE_CHUNK_SIZE into @buffer. Once a
+ * piece has arrived the read of the next one is started and then @func is
+ * called on it, so that the device and the CPU are busy at the same time.
+ * Each piece is passed to hash_stream_update() before @func sees it.
+ * Reads only overlap when @buffer is aligned to ARCH_DMA_MINALIGN.
+ *
+ * @block_dev:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer for data read
+ * @func:	Function to call on each piece, or NULL
+ * @priv:	Private data for @func
+ * @return number of blocks read, which is less than @blkcnt if @func
+ * stopped early, or -ve error number (see the IS_ERR_VALUE() macro)
+ */
+unsigned long blk_read_pipe(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer, blk_pipe_func func,
+			    void *priv);
+
 /**
  * blk_get_device() - Find and probe a block device ready for use
  *
@@ -380,6 +554,10 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
 
+	if (blkcache_read_ahead(block_dev, start, blkcnt, buffer,
+				block_dev->block_read))
+		return blkcnt;
+
 	/*
 	 * We could check if block_read is NULL and return -ENOSYS. But this
 	 * bloats the code slightly (cause some board to fail to build), and
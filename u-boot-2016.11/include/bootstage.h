@@ -198,6 +198,8 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SCSI,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_HASH,
+	BOOTSTAGE_ID_ACCUM_DM_R,
 	BOOTSTAGE_ID_FPGA_INIT,
 
 	/* a few spare for the user, from here */
@@ -299,6 +301,18 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * Record the time taken by an activity which has no id of its own
+ *
+ * This adds an accumulator with a new id, for things like devices which
+ * each need their own entry in the report.
+ *
+ * @param name		Textual name to display in the report
+ * @param time_us	Time taken by the activity in microseconds
+ * @return new id, or BOOTSTAGE_ID_COUNT if the table is full
+ */
+int bootstage_accum_name(const char *name, uint32_t time_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -381,6 +395,11 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline int bootstage_accum_name(const char *name, uint32_t time_us)
+{
+	return 0;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -825,9 +825,46 @@ int gzwrite(unsigned char *src, int len,
 	    u64 startoffs,
 	    u64 szexpected);
 
+/**
+ * gunzip_blk() - Read gzipped data from a block device and decompress it
+ *
+ * Each piece of the data is decompressed while the next one is being read,
+ * so this takes little longer than reading it.
+ *
+ * @dst:	Where to put the decompressed data
+ * @dstlen:	Space available at @dst
+ * @src:	Where to read the compressed data
+ * @desc:	Block device to read from
+ * @start:	First block of the compressed data
+ * @blkcnt:	Number of blocks to read at most; reading stops at the end
+ *		of the compressed data
+ * @lenp:	Returns the length of the decompressed data
+ * @return 0 if OK, -1 on error
+ */
+int gunzip_blk(void *dst, int dstlen, void *src, struct blk_desc *desc,
+	       lbaint_t start, lbaint_t blkcnt, unsigned long *lenp);
+
 /* lib/lz4_wrapper.c */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4fn_blk() - Read an LZ4 frame from a block device and decompress it
+ *
+ * Each block of the frame is decompressed as soon as it has been read,
+ * while the rest is still being read.
+ *
+ * @src:	Where to read the frame, which must not overlap @dst
+ * @desc:	Block device to read from
+ * @start:	First block of the frame
+ * @blkcnt:	Number of blocks to read at most; reading stops at the end
+ *		of the frame
+ * @dst:	Where to put the decompressed data
+ * @dstn:	Space available at @dst, returns the decompressed length
+ * @return 0 if OK, -ve on error, as for ulz4fn()
+ */
+int ulz4fn_blk(void *src, struct blk_desc *desc, lbaint_t start,
+	       lbaint_t blkcnt, void *dst, size_t *dstn);
+
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
 	   int(*compar)(const void *, const void *));
@@ -0,0 +1,74 @@
+/*
+ * Running work on secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __CPU_WORK_H
+#define __CPU_WORK_H
+
+/* Most CPUs which can take part in cpu_work_run(), including this one */
+#define CPU_WORK_MAX_CPUS	8
+
+/**
+ * cpu_work_func - A piece of work which runs on one CPU
+ *
+ * @arg:	Argument passed to cpu_work_run()
+ * @index:	Which piece this is, 0 to count - 1
+ */
+typedef void (*cpu_work_func)(void *arg, int index);
+
+#ifdef CONFIG_CPU_WORK
+/**
+ * cpu_work_cpus() - Find out how many CPUs cpu_work_run() can use
+ *
+ * This is the number the architecture provides, limited by the 'workcpus'
+ * environment variable if it is set.
+ *
+ * @return number of CPUs, including this one (so at least 1)
+ */
+int cpu_work_cpus(void);
+
+/**
+ * cpu_work_run() - Run pieces of work in parallel and wait for them
+ *
+ * @func is called once for each index from 0 to @count - 1. This CPU runs
+ * index 0 and each other index is started on a secondary CPU. If that is
+ * not possible, this CPU runs it too once its own work is done. The pieces
+ * of work must not use the console, malloc() or drivers, only memory.
+ *
+ * @func:	Function to call
+ * @arg:	Argument to pass to @func
+ * @count:	Number of pieces of work, at most cpu_work_cpus()
+ * @return 0 if ok, -EINVAL if @count is out of range
+ */
+int cpu_work_run(cpu_work_func func, void *arg, int count);
+
+/*
+ * Architecture hooks. The defaults provide no secondary CPUs.
+ *
+ * arch_cpu_work_cpus() returns the number of CPUs available, including
+ * this one. arch_cpu_work_start() starts func(arg, cpu) on CPU @cpu and
+ * returns 0, or returns -ve if it cannot. arch_cpu_work_wait() waits for
+ * the work started on CPU @cpu to finish.
+ */
+int arch_cpu_work_cpus(void);
+int arch_cpu_work_start(int cpu, cpu_work_func func, void *arg);
+void arch_cpu_work_wait(int cpu);
+#else
+static inline int cpu_work_cpus(void)
+{
+	return 1;
+}
+
+static inline int cpu_work_run(cpu_work_func func, void *arg, int count)
+{
+	if (count != 1)
+		return -EINVAL;
+	func(arg, 0);
+
+	return 0;
+}
+#endif
+
+#endif /* __CPU_WORK_H */
@@ -172,4 +172,87 @@ static inline void devres_release_all(struct udevice *dev)
 }
 
 #endif /* ! CONFIG_DEVRES */
+
+/**
+ * struct dm_probe_frame - A device_probe() call in progress
+ *
+ * These are kept on the stack of device_probe() and linked together while
+ * probes are nested, so that the time spent probing other devices can be
+ * separated from the time a device's own probe takes.
+ *
+ * @up: The probe which this one is nested inside, or NULL
+ * @dev: Device being probed, or NULL if nothing is being recorded
+ * @start: Time when the probe started, in microseconds
+ * @nested: Microseconds spent in nested probes so far
+ * @order: Number of probes recorded when this one started
+ */
+struct dm_probe_frame {
+	struct dm_probe_frame *up;
+	struct udevice *dev;
+	ulong start;
+	ulong nested;
+	int order;
+};
+
+#if CONFIG_IS_ENABLED(DM_PROBE_STATS)
+/**
+ * dm_probe_stats_start() - Note that a device is about to be probed
+ *
+ * If another device is being probed, this records that it depends on @dev.
+ *
+ * @dev:	Device about to be probed
+ * @frame:	Frame to record the probe in, which must remain valid until
+ *		dm_probe_stats_end() is called
+ */
+void dm_probe_stats_start(struct udevice *dev, struct dm_probe_frame *frame);
+
+/**
+ * dm_probe_stats_end() - Record the time a probe took
+ *
+ * @frame:	Frame passed to dm_probe_stats_start()
+ * @ret:	Return value of the probe; failed probes are not recorded
+ */
+void dm_probe_stats_end(struct dm_probe_frame *frame, int ret);
+
+/**
+ * dm_probe_stats_needs() - Check whether one device needed another
+ *
+ * @dev:	Device to check
+ * @dep:	Possible dependency
+ * @return true if @dep was probed, or found to be probed already, while
+ * @dev was being probed (other than as its parent or child)
+ */
+bool dm_probe_stats_needs(struct udevice *dev, struct udevice *dep);
+
+/**
+ * dm_probe_stats_unbind() - Forget the dependencies of a device
+ *
+ * This is called when the device is unbound.
+ *
+ * @dev:	Device being unbound
+ */
+void dm_probe_stats_unbind(struct udevice *dev);
+
+#else
+
+static inline void dm_probe_stats_start(struct udevice *dev,
+					struct dm_probe_frame *frame)
+{
+}
+
+static inline void dm_probe_stats_end(struct dm_probe_frame *frame, int ret)
+{
+}
+
+static inline bool dm_probe_stats_needs(struct udevice *dev,
+					struct udevice *dep)
+{
+	return false;
+}
+
+static inline void dm_probe_stats_unbind(struct udevice *dev)
+{
+}
+
+#endif
 #endif
@@ -46,6 +46,21 @@ struct driver_info;
 
 #define DM_FLAG_OF_PLATDATA		(1 << 8)
 
+/**
+ * struct dm_probe_stats - Probe timing for a device
+ *
+ * @total_us: Microseconds spent in device_probe(), including the time taken
+ *	to probe parents and any devices probed by this one
+ * @self_us: As @total_us but excluding the time spent probing other devices
+ * @order: Position of this device in the order of probing (1 = first), 0 if
+ *	it has not been probed since relocation
+ */
+struct dm_probe_stats {
+	ulong total_us;
+	ulong self_us;
+	int order;
+};
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -87,6 +102,9 @@ struct driver_info;
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
  *		automatically when the device is removed / unbound
+ * @probe_stats: Time taken by the last successful probe of this device and
+ *		its position in the probe order, when CONFIG_DM_PROBE_STATS
+ *		is enabled
  */
 struct udevice {
 	const struct driver *driver;
@@ -110,6 +128,9 @@ struct udevice {
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
+#if CONFIG_IS_ENABLED(DM_PROBE_STATS)
+	struct dm_probe_stats probe_stats;
+#endif
 };
 
 /* Maximum sequence number supported */
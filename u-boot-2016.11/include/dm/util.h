@@ -48,4 +48,13 @@ static inline void dm_dump_devres(void)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_PROBE_STATS)
+/* Dump out the probe time of each device and the dependencies between them */
+void dm_dump_probe_stats(void);
+#else
+static inline void dm_dump_probe_stats(void)
+{
+}
+#endif
+
 #endif
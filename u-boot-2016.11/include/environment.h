@@ -222,6 +222,72 @@ int env_import(const char *buf, int check);
 /* Export from hash table into binary representation */
 int env_export(env_t *env_out);
 
+#ifdef CONFIG_ENV_JOURNAL
+/**
+ * struct env_journal - environment saved as a base image plus deltas
+ *
+ * The base is an ordinary env_t written by @write_base. Each saveenv
+ * appends a record holding just the variables that changed to a separate
+ * journal area; the base is only rewritten, and the journal erased, when
+ * the journal is full. The journal starts with a header holding the CRC
+ * of its base and a generation number which every record repeats, so
+ * records left over from an older base are ignored.
+ *
+ * @size:	Size of the journal area in bytes
+ * @align:	Records start on a multiple of this, e.g. the media block size
+ * @read:	Read @len bytes at @offset within the journal area
+ * @write:	Write @len bytes at @offset within the journal area
+ * @erase:	Erase the whole journal area, or NULL if the media can be
+ *		rewritten without erasing
+ * @write_base:	Write a full environment image, as saveenv does without
+ *		a journal
+ * @priv:	Private data for the backend
+ * @next:	Offset of the next free slot in the journal area
+ * @seq:	Sequence number of the next record
+ * @gen:	Generation of the journal, bumped each time a base is written
+ * @saved:	Environment as held on the media, as exported by hexport_r(),
+ *		or NULL if it is not known and the next save must write a base
+ */
+struct env_journal {
+	ulong size;
+	ulong align;
+	int (*read)(struct env_journal *j, ulong offset, ulong len, void *buf);
+	int (*write)(struct env_journal *j, ulong offset, ulong len,
+		     const void *buf);
+	int (*erase)(struct env_journal *j);
+	int (*write_base)(struct env_journal *j, env_t *env);
+	void *priv;
+
+	ulong next;
+	u32 seq;
+	u32 gen;
+	char *saved;
+};
+
+/**
+ * env_journal_load() - replay the journal on top of an imported base
+ *
+ * @j:		Journal to read
+ * @htab:	Hash table the base has already been imported into
+ * @base:	Base image, or NULL if no valid base was found
+ * @return number of records replayed, or -ve on error
+ */
+int env_journal_load(struct env_journal *j, struct hsearch_data *htab,
+		     const env_t *base);
+
+/**
+ * env_journal_save() - save the changes since the last load or save
+ *
+ * Appends a record to the journal, or writes a new base when the journal
+ * is full or its state is not known.
+ *
+ * @j:		Journal to write
+ * @htab:	Hash table to save
+ * @return 0 if OK, -ve on error
+ */
+int env_journal_save(struct env_journal *j, struct hsearch_data *htab);
+#endif
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENVIRONMENT_H_ */
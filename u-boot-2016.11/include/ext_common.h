@@ -199,6 +199,7 @@ struct ext2fs_node {
 	struct ext2_inode inode;
 	int ino;
 	int inode_read;
+	struct ext4_extent_cache *extent_cache;	/* built on first read */
 };
 
 /* Information about a "mounted" ext2 filesystem. */
@@ -33,6 +33,8 @@
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/* FAT table cache windows used while reading, see get_fatent() */
+#define FATCACHEBLOCKS	(FATBUFBLOCKS * 8)
 
 /* Filesystem identifiers */
 #define FAT12_SIGN	"FAT12   "
@@ -158,6 +160,15 @@ typedef struct dir_slot {
 	__u8	name11_12[4];	/* Last 2 characters in name */
 } dir_slot;
 
+/*
+ * A window of the FAT table held in memory
+ */
+struct fat_cache_win {
+	__u8	*buf;		/* fatcache_blocks sectors of the FAT */
+	int	bufnum;		/* Window number, -1 if unused */
+	__u32	used;		/* Value of fatcache_tick when last used */
+};
+
 /*
  * Private filesystem parameters
  *
@@ -174,7 +185,12 @@ typedef struct {
 	__u16	sect_size;	/* Size of sectors in bytes */
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
-	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	int	fatbufnum;	/* Used by get_fatent_value, init to -1 */
+	struct fat_cache_win *fatcache;	/* FAT windows used by get_fatent */
+	int	fatcache_wins;	/* Number of windows in fatcache */
+	__u32	fatcache_blocks; /* Size of each window in sectors */
+	__u32	fatcache_tick;	/* LRU clock for fatcache */
+	__u32	fat_sect_reads;	/* FAT sectors read, for statistics */
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
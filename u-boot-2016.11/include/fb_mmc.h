@@ -7,3 +7,14 @@
 void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 			unsigned int download_bytes);
 void fb_mmc_erase(const char *cmd);
+
+struct sparse_stream;
+
+/**
+ * fb_mmc_stream_start() - Get ready to write a sparse image as it downloads
+ *
+ * @cmd:	Name of the partition to write
+ * @ss:		Returns the stream to pass the image to
+ * @return 0 if OK, -ve on error
+ */
+int fb_mmc_stream_start(const char *cmd, struct sparse_stream *ss);
@@ -15,6 +15,7 @@
 enum {
 	HASH_FLAG_VERIFY	= 1 << 0,	/* Enable verify mode */
 	HASH_FLAG_ENV		= 1 << 1,	/* Allow env vars */
+	HASH_FLAG_LOADED	= 1 << 2,	/* Use digest from loading */
 };
 
 #if defined(CONFIG_SHA1SUM_VERIFY) || defined(CONFIG_CRC32_VERIFY)
@@ -114,6 +115,97 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+#if defined(CONFIG_HASH_STREAM) && !defined(CONFIG_SPL_BUILD)
+/**
+ * hash_stream_start() - Start hashing data as it is loaded into memory
+ *
+ * If the 'loadhash' environment variable names a progressive hash
+ * algorithm, a stream is started for the region beginning at @start and
+ * any digest left by a previous load is dropped. Loaders then pass each
+ * piece of data they store to hash_stream_update().
+ *
+ * @start:	First byte of the region being loaded
+ * @return 0 if a stream was started, -ENOENT if 'loadhash' is not set,
+ * other -ve on error
+ */
+int hash_stream_start(const void *start);
+
+/**
+ * hash_stream_update() - Feed freshly loaded data to the stream
+ *
+ * Data which continues the region is hashed straight away, while it is
+ * still in the cache. Data stored elsewhere (e.g. filesystem metadata) is
+ * ignored, and anything skipped over is hashed from memory by
+ * hash_stream_finish(). Rewriting data which has already been hashed
+ * abandons the stream.
+ *
+ * @buf:	Where the data was stored
+ * @len:	Number of bytes stored
+ */
+void hash_stream_update(const void *buf, unsigned long len);
+
+/**
+ * hash_stream_active() - Check whether loaded data is being hashed
+ *
+ * @return true if a stream has been started and not yet finished
+ */
+bool hash_stream_active(void);
+
+/**
+ * hash_stream_finish() - Complete the stream and record its digest
+ *
+ * @len:	Final length of the loaded region
+ * @return 0 if ok, -ENOENT if no stream is active, other -ve on error
+ */
+int hash_stream_finish(unsigned long len);
+
+/**
+ * hash_stream_abort() - Abandon the stream, e.g. when the load failed
+ */
+void hash_stream_abort(void);
+
+/**
+ * hash_stream_lookup() - Get the digest recorded while a region was loaded
+ *
+ * Nothing notices if the region is changed after loading, so this is only
+ * for callers which have been told that the data is as it was loaded.
+ *
+ * @algo_name:	Hash algorithm wanted
+ * @data:	Start of the region
+ * @len:	Length of the region
+ * @output:	Returns the digest (HASH_MAX_DIGEST_SIZE bytes is enough)
+ * @return digest size in bytes if ok, -ENOENT if no digest matching all of
+ * @algo_name, @data and @len is available
+ */
+int hash_stream_lookup(const char *algo_name, const void *data,
+		       unsigned long len, uint8_t *output);
+#else
+static inline int hash_stream_start(const void *start)
+{
+	return -ENOENT;
+}
+
+static inline void hash_stream_update(const void *buf, unsigned long len) {}
+
+static inline bool hash_stream_active(void)
+{
+	return false;
+}
+
+static inline int hash_stream_finish(unsigned long len)
+{
+	return -ENOENT;
+}
+
+static inline void hash_stream_abort(void) {}
+
+static inline int hash_stream_lookup(const char *algo_name, const void *data,
+				     unsigned long len, uint8_t *output)
+{
+	return -ENOENT;
+}
+#endif
+
 #endif /* !USE_HOSTCC */
 
 /**
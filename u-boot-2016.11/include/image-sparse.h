@@ -36,5 +36,94 @@ static inline int is_sparse_image(void *buf)
 	return 0;
 }
 
+/* States of the sparse image parser */
+enum sparse_state {
+	SPARSE_FILE_HDR,	/* reading the file header */
+	SPARSE_CHUNK_HDR,	/* reading a chunk header */
+	SPARSE_CHUNK_HDR_SKIP,	/* skipping the rest of a long chunk header */
+	SPARSE_RAW,		/* writing raw data */
+	SPARSE_FILL,		/* reading a fill value */
+	SPARSE_SKIP,		/* skipping data which is not written */
+	SPARSE_DONE,		/* all chunks seen */
+	SPARSE_ERROR,		/* failed; see err */
+};
+
+/**
+ * struct sparse_stream - state of a sparse image being written in pieces
+ *
+ * The image can arrive in pieces of any size, e.g. as a download comes in.
+ * Raw and fill chunks are written to storage as soon as there is a block's
+ * worth and don't-care chunks are skipped over.
+ *
+ * @info:		Storage being written
+ * @header:		Sparse file header
+ * @chunk:		Header of the current chunk
+ * @fill_val:		Value for the current fill chunk
+ * @state:		Current state of the parser
+ * @got:		Bytes of the current header or fill value seen so far
+ * @need:		Bytes still to come in the current state
+ * @chunk_no:		Number of chunks started
+ * @blk:		Next block to write
+ * @blkcnt:		Number of storage blocks in the current chunk
+ * @total_blocks:	Number of sparse blocks processed
+ * @bytes_written:	Number of bytes written to storage
+ * @buf:		Buffer for raw data which does not fill a block, and
+ *			for fill patterns
+ * @buf_len:		Number of bytes of raw data in @buf
+ * @buf_blks:		Size of @buf in storage blocks
+ * @err:		Message describing the failure, if any
+ */
+struct sparse_stream {
+	struct sparse_storage *info;
+	sparse_header_t header;
+	chunk_header_t chunk;
+	uint32_t fill_val;
+	enum sparse_state state;
+	uint32_t got;
+	uint64_t need;
+	uint32_t chunk_no;
+	lbaint_t blk;
+	lbaint_t blkcnt;
+	uint32_t total_blocks;
+	unsigned long long bytes_written;
+	void *buf;
+	uint32_t buf_len;
+	lbaint_t buf_blks;
+	const char *err;
+};
+
+/**
+ * sparse_stream_start() - Get ready to write a sparse image in pieces
+ *
+ * @ss:		Stream to set up
+ * @info:	Storage to write to, which must remain valid until
+ *		sparse_stream_finish() is called
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int sparse_stream_start(struct sparse_stream *ss, struct sparse_storage *info);
+
+/**
+ * sparse_stream_write() - Process the next piece of a sparse image
+ *
+ * @ss:		Stream to write to
+ * @data:	Next part of the image
+ * @len:	Length of @data in bytes
+ * @return 0 if OK, -ve on error, in which case ss->err describes it
+ */
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			unsigned int len);
+
+/**
+ * sparse_stream_finish() - Check that a sparse image was complete
+ *
+ * This must be called once for every call to sparse_stream_start(), even if
+ * there was an error, so that the stream's buffer is freed.
+ *
+ * @ss:		Stream to finish
+ * @return 0 if the whole image was written, -ve on error, in which case
+ *	ss->err describes it
+ */
+int sparse_stream_finish(struct sparse_stream *ss);
+
 void write_sparse_image(struct sparse_storage *info, const char *part_name,
 			void *data, unsigned sz);
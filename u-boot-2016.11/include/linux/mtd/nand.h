@@ -908,6 +908,8 @@ extern int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 			   int allowbbt);
 extern int nand_do_read(struct mtd_info *mtd, loff_t from, size_t len,
 			size_t *retlen, uint8_t *buf);
+extern int nand_read_bbm(struct mtd_info *mtd, loff_t from, int numblocks,
+			 int numpages, int offs, int len, uint8_t *buf);
 
 /*
 * Constants for oob configuration
@@ -58,8 +58,13 @@
 #define MMC_MODE_8BIT		(1 << 3)
 #define MMC_MODE_SPI		(1 << 4)
 #define MMC_MODE_DDR_52MHz	(1 << 5)
+#define MMC_MODE_CMD23		(1 << 6)	/* SET_BLOCK_COUNT */
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_CMD23_SUPPORT	0x00000002
+
+/* Largest transfer which CMD23 can describe */
+#define MMC_CMD23_MAX_BLOCKS	0xffff
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -355,12 +360,42 @@ struct dm_mmc_ops {
 	 * @return 0 if write-enabled, 1 if write-protected, -ve on error
 	 */
 	int (*get_wp)(struct udevice *dev);
+
+	/**
+	 * send_cmd_async() - Send a command and leave its data moving
+	 *
+	 * This is like send_cmd() but returns once the command has been
+	 * answered, while the data is still being transferred by DMA.
+	 * wait_data() must be called before anything else is done with the
+	 * device. This is optional.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to transfer, which must stay valid until
+	 *		wait_data() is called
+	 * @return 0 if OK, -ENOSYS if this transfer cannot be done in the
+	 * background, other -ve on error
+	 */
+	int (*send_cmd_async)(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data);
+
+	/**
+	 * wait_data() - Wait for the data of a send_cmd_async() command
+	 *
+	 * @dev:	Device which is transferring
+	 * @data:	Data passed to send_cmd_async()
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*wait_data)(struct udevice *dev, struct mmc_data *data);
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
 
 int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		    struct mmc_data *data);
+int dm_mmc_send_cmd_async(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data);
+int dm_mmc_wait_data(struct udevice *dev, struct mmc_data *data);
 int dm_mmc_set_ios(struct udevice *dev);
 int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
@@ -432,6 +467,7 @@ struct mmc {
 	uint tran_speed;
 	uint read_bl_len;
 	uint write_bl_len;
+	uint cur_bl_len;	/* block length last set by CMD16, 0 if unknown */
 	uint erase_grp_size;	/* in 512-byte sectors */
 	uint hc_wp_grp_size;	/* in 512-byte sectors */
 	struct sd_ssr	ssr;	/* SD status register */
@@ -446,12 +482,20 @@ struct mmc {
 	struct blk_desc block_dev;
 #endif
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
+	char op_cond_sd;	/* 1 if that is ACMD41 rather than CMD1 */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
+	char init_timed;	/* 1 once the init time is in bootstage */
+	ulong op_cond_start;	/* get_timer() when op_cond polling began */
+	ulong init_start;	/* timer_get_us() at mmc_start_init() */
 	int ddr_mode;
 #ifdef CONFIG_DM_MMC
 	struct udevice *dev;	/* Device for this MMC controller */
 #endif
+#ifdef CONFIG_DM_MMC_OPS
+	struct mmc_data async_data;	/* read started by mmc_bread_async() */
+	bool async_stop;		/* it needs CMD12 when done */
+#endif
 };
 
 struct mmc_hwpart_conf {
@@ -551,6 +595,21 @@ int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
  */
 int mmc_start_init(struct mmc *mmc);
 
+/**
+ * mmc_init_devices() - Initialise several cards together
+ *
+ * Every card is started with mmc_start_init() and then each is polled in
+ * turn until it has powered up, so that cards which take hundreds of
+ * milliseconds to do so wait at the same time rather than one after the
+ * other. Cards which are already initialised are left alone. If there is no
+ * memory to track them, the cards are initialised one after the other.
+ *
+ * @list:	Cards to initialise
+ * @count:	Number of cards in @list
+ * @return number of cards which failed to initialise
+ */
+int mmc_init_devices(struct mmc **list, int count);
+
 /**
  * Set preinit flag of mmc device.
  *
@@ -330,4 +330,24 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/**
+ * Start a host thread
+ *
+ * The thread must not call back into U-Boot code which uses global state,
+ * since none of that is thread-safe.
+ *
+ * @param threadp	Returns a handle for os_thread_join()
+ * @param func		Function to run in the thread
+ * @param arg		Argument to pass to @func
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_create(void **threadp, void *(*func)(void *arg), void *arg);
+
+/**
+ * Wait for a host thread to finish
+ *
+ * @param thread	Handle returned by os_thread_create()
+ */
+void os_thread_join(void *thread);
+
 #endif
@@ -13,6 +13,15 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+#ifdef CONFIG_BLK
+	/* read started by host_block_read_async(), done by a host thread */
+	void *thread;
+	unsigned long start;
+	unsigned long blkcnt;
+	unsigned long blksz;
+	void *buffer;
+	long result;
+#endif
 };
 
 int host_dev_bind(int dev, char *filename);
@@ -182,6 +182,7 @@
 /* 55-57 reserved */
 
 #define SDHCI_ADMA_ADDRESS	0x58
+#define SDHCI_ADMA_ADDRESS_HI	0x5C
 
 /* 60-FB reserved */
 
@@ -218,6 +219,24 @@
 #define SDHCI_QUIRK_NO_SIMULT_VDD_AND_POWER (1 << 7)
 #define SDHCI_QUIRK_USE_WIDE8		(1 << 8)
 
+/*
+ * host->flags, the DMA modes chosen from the capabilities
+ */
+#define SDHCI_USE_SDMA			(1 << 0)
+#define SDHCI_USE_ADMA			(1 << 1)
+#define SDHCI_USE_ADMA64		(1 << 2)
+
+/*
+ * ADMA2 descriptors: 32-bit ones are 8 bytes, 64-bit ones 12 bytes. Each
+ * moves up to 64 KiB, with a length of 0 meaning 65536.
+ */
+#define SDHCI_ADMA_DESC_SIZE		8
+#define SDHCI_ADMA64_DESC_SIZE		12
+#define SDHCI_ADMA_MAX_LEN		65536
+#define  SDHCI_ADMA_DESC_VALID		0x01
+#define  SDHCI_ADMA_DESC_END		0x02
+#define  SDHCI_ADMA_DESC_TRAN		0x20
+
 /* to make gcc happy */
 struct sdhci_host;
 
@@ -256,6 +275,15 @@ struct sdhci_host {
 	void (*set_control_reg)(struct sdhci_host *host);
 	void (*set_clock)(int dev_index, unsigned int div);
 	uint	voltages;
+	uint	flags;
+	/* data transfer of the command in progress */
+	unsigned long start_addr;
+	int trans_bytes;
+	int is_aligned;
+	int is_dma;
+#ifdef CONFIG_MMC_SDHCI_ADMA
+	void	*adma_table;	/* ADMA2 descriptors, enough for cfg->b_max */
+#endif
 
 	struct mmc_config cfg;
 };
@@ -53,6 +53,7 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int resizes;		/* times the table has been grown */
 /*
  * Callback function which will check whether the given change for variable
  * "__item" to "newval" may be applied or not, and possibly apply such change.
@@ -106,6 +107,19 @@ extern int himport_r(struct hsearch_data *__htab,
 /* Walk the whole table calling the callback on each element */
 extern int hwalk_r(struct hsearch_data *__htab, int (*callback)(ENTRY *));
 
+/* Layout of the table, as reported by hstats_r() */
+struct hsearch_stats {
+	unsigned int size;		/* number of slots */
+	unsigned int filled;		/* slots holding an entry */
+	unsigned int deleted;		/* slots freed by hdelete_r() */
+	unsigned int resizes;		/* times the table has been grown */
+	unsigned int probes;		/* slots looked at to find every entry */
+	unsigned int max_probes;	/* longest probe sequence for one entry */
+};
+
+extern void hstats_r(struct hsearch_data *__htab,
+		     struct hsearch_stats *__stats);
+
 /* Flags for himport_r(), hexport_r(), hdelete_r(), and hsearch_r() */
 #define H_NOCLEAR	(1 << 0) /* do not clear hash table before importing */
 #define H_FORCE		(1 << 1) /* overwrite read-only/write-once variables */
@@ -92,6 +92,8 @@ struct dm_spi_slave_platdata {
  * @wordlen:		Size of SPI word in number of bits
  * @max_write_size:	If non-zero, the maximum number of bytes which can
  *			be written at once, excluding command bytes.
+ * @max_read_size:	If non-zero, the maximum number of bytes which can
+ *			be read at once, excluding command bytes.
  * @memory_map:		Address of read-only SPI flash access.
  * @option:		Varies SPI bus options - separate, shared bus.
  * @flags:		Indication of SPI flags.
@@ -108,6 +110,7 @@ struct spi_slave {
 	uint mode;
 	unsigned int wordlen;
 	unsigned int max_write_size;
+	unsigned int max_read_size;
 	void *memory_map;
 	u8 option;
 
@@ -470,6 +473,23 @@ struct dm_spi_ops {
 	 *	   is invalid, other -ve value on error
 	 */
 	int (*cs_info)(struct udevice *bus, uint cs, struct spi_cs_info *info);
+
+	/**
+	 * Get information on memory-mapped reads
+	 *
+	 * Some controllers can map the flash on a chip select directly into
+	 * the CPU address space, so that reads are just memory accesses (or
+	 * DMA). This is optional.
+	 *
+	 * @dev:	The SPI slave device
+	 * @map_basep:	Returns the physical address of the mapping
+	 * @map_sizep:	Returns the size of the mapping in bytes
+	 * @offsetp:	Returns the offset into the flash at which the mapping
+	 *		starts
+	 * @return 0 if OK, -EFAULT if memory mapping is not available
+	 */
+	int (*get_mmap)(struct udevice *dev, ulong *map_basep, uint *map_sizep,
+			uint *offsetp);
 };
 
 struct dm_spi_emul_ops {
@@ -657,6 +677,19 @@ void dm_spi_release_bus(struct udevice *dev);
 int dm_spi_xfer(struct udevice *dev, unsigned int bitlen,
 		const void *dout, void *din, unsigned long flags);
 
+/**
+ * dm_spi_get_mmap() - Get information on memory-mapped reads
+ *
+ * @dev:	The SPI slave device
+ * @map_basep:	Returns the physical address of the mapping
+ * @map_sizep:	Returns the size of the mapping in bytes
+ * @offsetp:	Returns the offset into the flash at which the mapping starts
+ * @return 0 if OK, -EFAULT if the controller does not support memory
+ *	   mapping, other -ve value on error
+ */
+int dm_spi_get_mmap(struct udevice *dev, ulong *map_basep, uint *map_sizep,
+		    uint *offsetp);
+
 /* Access the operations for a SPI device */
 #define spi_get_ops(dev)	((struct dm_spi_ops *)(dev)->driver->ops)
 #define spi_emul_get_ops(dev)	((struct dm_spi_emul_ops *)(dev)->driver->ops)
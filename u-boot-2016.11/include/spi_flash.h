@@ -41,10 +41,12 @@ struct spi_slave;
  * @page_size:		Write (page) size
  * @sector_size:	Sector size
  * @erase_size:		Erase size
+ * @block_erase_size:	Larger erase size also supported, or 0 if none
  * @bank_read_cmd:	Bank read cmd
  * @bank_write_cmd:	Bank write cmd
  * @bank_curr:		Current flash bank
  * @erase_cmd:		Erase cmd 4K, 32K, 64K
+ * @block_erase_cmd:	Erase cmd for block_erase_size
  * @read_cmd:		Read cmd - Array Fast, Extn read and quad read.
  * @write_cmd:		Write cmd - page and quad program.
  * @dummy_byte:		Dummy cycles for read operation.
@@ -74,12 +76,14 @@ struct spi_flash {
 	u32 page_size;
 	u32 sector_size;
 	u32 erase_size;
+	u32 block_erase_size;
 #ifdef CONFIG_SPI_FLASH_BAR
 	u8 bank_read_cmd;
 	u8 bank_write_cmd;
 	u8 bank_curr;
 #endif
 	u8 erase_cmd;
+	u8 block_erase_cmd;
 	u8 read_cmd;
 	u8 write_cmd;
 	u8 dummy_byte;
@@ -190,6 +194,15 @@ int sandbox_sf_bind_emul(struct sandbox_state *state, int busnum, int cs,
 
 void sandbox_sf_unbind_emul(struct sandbox_state *state, int busnum, int cs);
 
+/**
+ * sandbox_sf_get_cmd_count() - Find out how often the emulator saw a command
+ *
+ * @emul:	SPI flash emulator device
+ * @cmd:	Command byte (CMD_...)
+ * @return number of times @cmd has been received since @emul was probed
+ */
+uint sandbox_sf_get_cmd_count(struct udevice *emul, uint cmd);
+
 #else
 struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
 		unsigned int max_hz, unsigned int spi_mode);
@@ -13,6 +13,15 @@
 uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
+uint32_t crc32_le(uint32_t crc, unsigned char const *p, size_t len);
+
+/*
+ * crc32_no_comp() calls one of these. The _armv8 version uses the CRC32
+ * instructions when the CPU has them and falls back to the generic code
+ * otherwise.
+ */
+uint32_t crc32_no_comp_generic(uint32_t crc, const unsigned char *p, uint len);
+uint32_t crc32_no_comp_armv8(uint32_t crc, const unsigned char *p, uint len);
 
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
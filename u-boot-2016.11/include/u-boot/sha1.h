@@ -27,8 +27,8 @@ extern "C" {
  */
 typedef struct
 {
-    unsigned long total[2];	/*!< number of bytes processed	*/
-    unsigned long state[5];	/*!< intermediate digest state	*/
+    uint32_t total[2];		/*!< number of bytes processed	*/
+    uint32_t state[5];		/*!< intermediate digest state	*/
     unsigned char buffer[64];	/*!< data block being processed */
 }
 sha1_context;
@@ -92,6 +92,21 @@ void sha1_hmac(const unsigned char *key, int keylen,
 		const unsigned char *input, unsigned int ilen,
 		unsigned char *output);
 
+/**
+ * \brief	   Run the compression function over whole 64-byte blocks
+ *
+ * The _ce version uses the ARMv8 Cryptography Extensions when the CPU has
+ * them and falls back to the generic code otherwise.
+ *
+ * \param state    intermediate digest state
+ * \param data     input data
+ * \param blocks   number of blocks
+ */
+void sha1_blocks_generic(uint32_t state[5], const unsigned char *data,
+			 unsigned int blocks);
+void sha1_blocks_ce(uint32_t state[5], const unsigned char *data,
+		    unsigned int blocks);
+
 /**
  * \brief	   Checkup routine
  *
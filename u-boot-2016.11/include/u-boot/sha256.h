@@ -19,4 +19,14 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/*
+ * Run the compression function over @blocks 64-byte blocks. The _ce
+ * version uses the ARMv8 Cryptography Extensions when the CPU has them and
+ * falls back to the generic code otherwise.
+ */
+void sha256_blocks_generic(uint32_t state[8], const uint8_t *data,
+			   unsigned int blocks);
+void sha256_blocks_ce(uint32_t state[8], const uint8_t *data,
+		      unsigned int blocks);
+
 #endif /* _SHA256_H */
@@ -49,6 +49,25 @@ enum video_log2_bpp {
 
 #define VNBITS(bpix)	(1 << (bpix))
 
+/**
+ * struct video_damage - Rectangle of the display which has changed
+ *
+ * Drawing code records what it changes with video_damage(), so that
+ * video_sync() only has to deal with that part of the frame buffer. When
+ * nothing has changed all members are 0.
+ *
+ * @xstart:	X position in pixels of the left edge
+ * @ystart:	Y position in pixels of the top edge
+ * @xend:	X position in pixels just past the right edge
+ * @yend:	Y position in pixels just past the bottom edge
+ */
+struct video_damage {
+	int xstart;
+	int ystart;
+	int xend;
+	int yend;
+};
+
 /**
  * struct video_priv - Device information used by the video uclass
  *
@@ -59,9 +78,17 @@ enum video_log2_bpp {
  * @vidconsole_drv_name:	Driver to use for the text console, NULL to
  *		select automatically
  * @font_size:	Font size in pixels (0 to use a default value)
- * @fb:		Frame buffer
+ * @fb:		Frame buffer, as currently shown on the display
  * @fb_size:	Frame buffer size
  * @line_length:	Length of each frame buffer line, in bytes
+ * @fb_base:	Start of the frame-buffer memory. @fb is @yoffset lines on
+ *		from here after the display has been scrolled by panning
+ * @fb_lines:	Number of lines of frame-buffer memory at @fb_base
+ * @yoffset:	Line of @fb_base shown at the top of the display
+ * @pan_pending:	true if @yoffset has changed since the driver was told
+ * @pan_stopped:	true once video_stop_pan() has been called, so that
+ *		@fb stays at @fb_base
+ * @damage:	Part of @fb changed since the last video_sync()
  * @colour_fg:	Foreground colour (pixel value)
  * @colour_bg:	Background colour (pixel value)
  * @flush_dcache:	true to enable flushing of the data cache after
@@ -84,14 +111,29 @@ struct video_priv {
 	void *fb;
 	int fb_size;
 	int line_length;
+	void *fb_base;
+	int fb_lines;
+	int yoffset;
+	bool pan_pending;
+	bool pan_stopped;
+	struct video_damage damage;
 	int colour_fg;
 	int colour_bg;
 	bool flush_dcache;
 	ushort *cmap;
 };
 
-/* Placeholder - there are no video operations at present */
+/**
+ * struct video_ops - Video device operations
+ *
+ * @pan:	Show the frame buffer from line @yoffset onwards. With this the
+ *		console scrolls by moving the start of the display rather than
+ *		by copying the frame buffer. It is only used if the driver
+ *		sets @size in struct video_uc_platdata to more than one
+ *		screen. Returns 0 if OK, -ve on error.
+ */
 struct video_ops {
+	int (*pan)(struct udevice *dev, uint yoffset);
 };
 
 #define video_get_ops(dev)        ((struct video_ops *)(dev)->driver->ops)
@@ -119,12 +161,63 @@ int video_reserve(ulong *addrp);
  *
  * Some frame buffers are cached or have a secondary frame buffer. This
  * function syncs these up so that the current contents of the U-Boot frame
- * buffer are displayed to the user.
+ * buffer are displayed to the user. Only the lines recorded with
+ * video_damage() since the last sync are flushed from the cache.
  *
  * @dev:	Device to sync
  */
 void video_sync(struct udevice *vid);
 
+/**
+ * video_damage() - Record that part of the frame buffer has changed
+ *
+ * The rectangle is added to the area which the next video_sync() will
+ * deal with. Anything outside the display is ignored.
+ *
+ * @dev:	Device whose frame buffer was changed
+ * @x:		X position in pixels from the left
+ * @y:		Y position in pixels from the top
+ * @width:	Width in pixels
+ * @height:	Height in pixels
+ */
+void video_damage(struct udevice *dev, int x, int y, int width, int height);
+
+/**
+ * video_scroll() - Scroll the display up by panning
+ *
+ * This moves the start of the displayed frame buffer down by @lines lines
+ * and clears the lines which appear at the bottom. When the end of the
+ * frame-buffer memory is reached, what is still on the display is copied
+ * back to the start. So scrolling by a text row only rarely needs to copy
+ * the whole screen.
+ *
+ * @dev:	Device to scroll
+ * @lines:	Number of lines to scroll by
+ * @return 0 if OK, -ENOSYS if the device cannot pan or has no room to
+ * do so
+ */
+int video_scroll(struct udevice *dev, int lines);
+
+/**
+ * video_stop_pan() - Show the display from the frame-buffer base for good
+ *
+ * Whatever else uses the frame buffer (EFI applications, the OS) expects
+ * the display to start at the base address. This copies what is shown
+ * back there if the display has been panned, and makes the console
+ * scroll by copying from now on.
+ *
+ * @dev:	Device to stop panning
+ */
+void video_stop_pan(struct udevice *dev);
+
+/**
+ * video_stop_pan_all() - Stop panning on all active video devices
+ *
+ * This calls video_stop_pan() on all active video devices, before the
+ * frame buffer is handed to something else.
+ */
+void video_stop_pan_all(void);
+
 /**
  * video_sync_all() - Sync all devices' frame buffers with there hardware
  *
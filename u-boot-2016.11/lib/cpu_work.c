@@ -0,0 +1,51 @@
+/*
+ * Running work on secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <errno.h>
+
+__weak int arch_cpu_work_cpus(void)
+{
+	return 1;
+}
+
+__weak int arch_cpu_work_start(int cpu, cpu_work_func func, void *arg)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_cpu_work_wait(int cpu)
+{
+}
+
+int cpu_work_cpus(void)
+{
+	int cpus = min(arch_cpu_work_cpus(), CPU_WORK_MAX_CPUS);
+
+	return clamp_t(int, getenv_ulong("workcpus", 10, cpus), 1, cpus);
+}
+
+int cpu_work_run(cpu_work_func func, void *arg, int count)
+{
+	bool started[CPU_WORK_MAX_CPUS];
+	int cpu;
+
+	if (count < 1 || count > cpu_work_cpus())
+		return -EINVAL;
+
+	for (cpu = 1; cpu < count; cpu++)
+		started[cpu] = !arch_cpu_work_start(cpu, func, arg);
+	func(arg, 0);
+	for (cpu = 1; cpu < count; cpu++) {
+		if (started[cpu])
+			arch_cpu_work_wait(cpu);
+		else
+			func(arg, cpu);
+	}
+
+	return 0;
+}
@@ -21,6 +21,12 @@
 #endif
 #include "u-boot/zlib.h"
 
+#if defined(CONFIG_ARMV8_CRC32) && !defined(USE_HOSTCC)
+#define crc32_no_comp_fast	crc32_no_comp_armv8
+#else
+#define crc32_no_comp_fast	crc32_no_comp_generic
+#endif
+
 #define local static
 #define ZEXPORT	/* empty */
 
@@ -176,7 +182,42 @@ const uint32_t * ZEXPORT get_crc_table()
 /* No ones complement version. JFFS2 (and other things ?)
  * don't use ones compliment in their CRC calculations.
  */
-uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN && !defined(CONFIG_SPL_BUILD)
+/*
+ * Slicing-by-8: fold eight bytes into the CRC per step with eight table
+ * lookups which do not depend on each other, rather than eight dependent
+ * ones. This costs 7KiB of extra tables, so SPL keeps the word-at-a-time
+ * loop below; big-endian machines keep it too.
+ */
+#include "crc32_table.h"
+
+uint32_t ZEXPORT crc32_no_comp_generic(uint32_t crc, const Bytef *p,
+				      uInt len)
+{
+    const uint32_t *tab = crc_table;
+    uint32_t lo, hi;
+
+    for (; len && ((uintptr_t)p & 3); len--)
+	 DO_CRC(*p++);
+
+    for (; len >= 8; len -= 8, p += 8) {
+	 lo = crc ^ *(const uint32_t *)p;
+	 hi = *(const uint32_t *)(p + 4);
+	 crc = crc_slice[6][lo & 255] ^ crc_slice[5][(lo >> 8) & 255] ^
+	       crc_slice[4][(lo >> 16) & 255] ^ crc_slice[3][lo >> 24] ^
+	       crc_slice[2][hi & 255] ^ crc_slice[1][(hi >> 8) & 255] ^
+	       crc_slice[0][(hi >> 16) & 255] ^ tab[hi >> 24];
+    }
+
+    for (; len; len--)
+	 DO_CRC(*p++);
+
+    return crc;
+}
+#else
+uint32_t ZEXPORT crc32_no_comp_generic(uint32_t crc, const Bytef *buf,
+				      uInt len)
 {
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
@@ -216,8 +257,22 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 
     return le32_to_cpu(crc);
 }
+#endif
 #undef DO_CRC
 
+uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+     return crc32_no_comp_fast(crc, buf, len);
+}
+
+#ifndef USE_HOSTCC
+/* The Linux-style entry point used by UBI and UBIFS (see linux/crc32.h) */
+uint32_t crc32_le(uint32_t crc, unsigned char const *p, size_t len)
+{
+     return crc32_no_comp_fast(crc, p, len);
+}
+#endif
+
 uint32_t ZEXPORT crc32 (uint32_t crc, const Bytef *p, uInt len)
 {
      return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
@@ -28,6 +28,7 @@ struct efi_gop_obj {
 	struct efi_gop_mode mode;
 	/* Fields we only have acces to during init */
 	u32 bpix;
+	void *fb;
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -64,6 +65,9 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this, void *buffer,
 	struct efi_gop_obj *gopobj = container_of(this, struct efi_gop_obj, ops);
 	int i, j, line_len16, line_len32;
 	void *fb;
+#ifdef CONFIG_DM_VIDEO
+	struct udevice *vdev;
+#endif
 
 	EFI_ENTRY("%p, %p, %lx, %lx, %lx, %lx, %lx, %lx, %lx, %lx", this,
 		  buffer, operation, sx, sy, dx, dy, width, height, delta);
@@ -71,7 +75,7 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this, void *buffer,
 	if (operation != EFI_BLT_BUFFER_TO_VIDEO)
 		return EFI_EXIT(EFI_INVALID_PARAMETER);
 
-	fb = (void*)gd->fb_base;
+	fb = gopobj->fb;
 	line_len16 = gopobj->info.width * sizeof(u16);
 	line_len32 = gopobj->info.width * sizeof(u32);
 
@@ -116,6 +120,8 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this, void *buffer,
 	}
 
 #ifdef CONFIG_DM_VIDEO
+	if (!uclass_first_device(UCLASS_VIDEO, &vdev) && vdev)
+		video_damage(vdev, dx, dy, width, height);
 	video_sync_all();
 #else
 	lcd_sync();
@@ -138,6 +144,9 @@ int efi_gop_register(void)
 	if (uclass_first_device(UCLASS_VIDEO, &vdev))
 		return -1;
 
+	/* The application expects the display to start at fb_base */
+	video_stop_pan(vdev);
+
 	struct video_priv *priv = dev_get_uclass_priv(vdev);
 	bpix = priv->bpix;
 	col = video_get_xsize(vdev);
@@ -179,6 +188,7 @@ int efi_gop_register(void)
 	gopobj->ops.blt = gop_blt;
 	gopobj->ops.mode = &gopobj->mode;
 
+	gopobj->fb = (void *)(uintptr_t)fb_base;
 	gopobj->mode.max_mode = 1;
 	gopobj->mode.info = &gopobj->info;
 	gopobj->mode.info_size = sizeof(gopobj->info);
@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <watchdog.h>
 #include <command.h>
 #include <console.h>
@@ -14,6 +15,7 @@
 #include <memalign.h>
 #include <u-boot/zlib.h>
 #include <div64.h>
+#include <linux/err.h>
 
 #define HEADER0			'\x1f'
 #define HEADER1			'\x8b'
@@ -42,7 +44,8 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/* Find the deflate data after a gzip header, returns -1 if there is none */
+static int gunzip_header(unsigned char *src, unsigned long len)
 {
 	int i, flags;
 
@@ -63,14 +66,94 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
 
+	return i;
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	int i;
+
+	i = gunzip_header(src, *lenp);
+	if (i < 0)
+		return i;
+
 	return zunzip(dst, dstlen, src, lenp, 1, i);
 }
 
+#ifdef CONFIG_BLK
+struct gunzip_pipe {
+	z_stream s;
+	int started;
+	int ended;
+};
+
+/* Inflate each piece as it arrives, while the next one is being read */
+static int gunzip_pipe_func(void *priv, void *buf, unsigned long len)
+{
+	struct gunzip_pipe *gp = priv;
+	int i, r;
+
+	if (!gp->started) {
+		i = gunzip_header(buf, len);
+		if (i < 0)
+			return -EINVAL;
+		gp->s.next_in = buf + i;
+		gp->s.avail_in = len - i;
+		gp->started = 1;
+	} else {
+		/* pieces are contiguous, so just extend the input */
+		gp->s.avail_in += len;
+	}
+
+	r = inflate(&gp->s, Z_NO_FLUSH);
+	if (r == Z_STREAM_END) {
+		gp->ended = 1;
+		return 1;
+	}
+	if (r == Z_OK || (r == Z_BUF_ERROR && gp->s.avail_out))
+		return 0;
+	printf("Error: inflate() returned %d\n", r);
+
+	return -EIO;
+}
+
+int gunzip_blk(void *dst, int dstlen, void *src, struct blk_desc *desc,
+	       lbaint_t start, lbaint_t blkcnt, unsigned long *lenp)
+{
+	struct gunzip_pipe gp;
+	unsigned long n;
+	int r, err = 0;
+
+	memset(&gp, '\0', sizeof(gp));
+	gp.s.zalloc = gzalloc;
+	gp.s.zfree = gzfree;
+	r = inflateInit2(&gp.s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	gp.s.next_out = dst;
+	gp.s.avail_out = dstlen;
+
+	n = blk_read_pipe(desc, start, blkcnt, src, gunzip_pipe_func, &gp);
+	if (IS_ERR_VALUE(n)) {
+		err = -1;
+	} else if (!gp.ended) {
+		puts("Error: gunzip out of data\n");
+		err = -1;
+	}
+	*lenp = gp.s.next_out - (unsigned char *)dst;
+	inflateEnd(&gp.s);
+
+	return err;
+}
+#endif
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
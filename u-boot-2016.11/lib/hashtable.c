@@ -59,9 +59,17 @@
 
 typedef struct _ENTRY {
 	int used;
+	unsigned int hval;
 	ENTRY entry;
 } _ENTRY;
 
+/*
+ * The table is grown once it is more than HTAB_LOAD_NUM / HTAB_LOAD_DEN
+ * full; beyond that the double hashing probe sequences get long quickly.
+ */
+#define HTAB_LOAD_NUM	3
+#define HTAB_LOAD_DEN	4
+
 
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
@@ -97,6 +105,15 @@ static int isprime(unsigned int number)
  * becomes zero.
  */
 
+static unsigned int next_prime(unsigned int nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 int hcreate_r(size_t nel, struct hsearch_data *htab)
 {
 	/* Test for correct arguments.  */
@@ -110,12 +127,9 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 		return 0;
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = next_prime(nel);
 	htab->filled = 0;
+	htab->resizes = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (_ENTRY *) calloc(htab->size + 1, sizeof(_ENTRY));
@@ -165,20 +179,103 @@ void hdestroy_r(struct hsearch_data *htab)
  * hsearch()
  */
 
+/*
+ * 32-bit FNV-1a. Environment variable names tend to share long prefixes
+ * and suffixes ("bootargs_*", "*addr_r") which the old shift-and-add hash
+ * folded onto a handful of buckets; FNV-1a mixes every byte into all bits.
+ */
+static unsigned int hhash(const char *key)
+{
+	unsigned int hval = 2166136261u;
+
+	while (*key) {
+		hval ^= (unsigned char)*key++;
+		hval *= 16777619u;
+	}
+
+	return hval;
+}
+
+/* First hash function: simply take the modulus but prevent zero */
+static inline unsigned int hfirst(unsigned int hval, unsigned int size)
+{
+	unsigned int idx = hval % size;
+
+	return idx ? idx : 1;
+}
+
+/* Second hash function, as suggested in [Knuth] */
+static inline unsigned int hstep(unsigned int hval, unsigned int size)
+{
+	return 1 + hval % (size - 2);
+}
+
+/*
+ * Because size is prime, stepping by hstep() visits every index once
+ * before coming back to the first one.
+ */
+static inline unsigned int hnext(unsigned int idx, unsigned int step,
+				 unsigned int size)
+{
+	if (idx <= step)
+		return size + idx - step;
+
+	return idx - step;
+}
+
+/*
+ * Move all entries to a table of at least twice the size. The ENTRY
+ * contents are copied as they are, so keys and data are not duplicated
+ * again; pointers to entries returned earlier become stale, as they do
+ * after hdelete_r(). Tombstones left by hdelete_r() are dropped.
+ */
+static int hgrow_r(struct hsearch_data *htab)
+{
+	unsigned int size = next_prime(htab->size * 2);
+	unsigned int i, idx, step;
+	_ENTRY *table;
+
+	table = calloc(size + 1, sizeof(_ENTRY));
+	if (!table)
+		return -ENOMEM;
+
+	for (i = 1; i <= htab->size; ++i) {
+		_ENTRY *old = &htab->table[i];
+
+		if (old->used <= 0)
+			continue;
+
+		idx = hfirst(old->hval, size);
+		step = hstep(old->hval, size);
+		while (table[idx].used)
+			idx = hnext(idx, step, size);
+
+		table[idx] = *old;
+		table[idx].used = hfirst(old->hval, size);
+	}
+
+	debug("hgrow_r: %u -> %u slots for %u entries\n", htab->size, size,
+	      htab->filled);
+	free(htab->table);
+	htab->table = table;
+	htab->size = size;
+	htab->resizes++;
+
+	return 0;
+}
+
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars, which are hashed with FNV-1a. The full hash
+ * is kept with each entry so that it can be compared before calling strcmp
+ * and so that the table can be grown without hashing the keys again.
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
  * special. This index will never be used because we store the first hash
  * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
- * unnecessary expensive calls of strcmp.
+ * means used.
  *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
@@ -196,6 +293,8 @@ void hdestroy_r(struct hsearch_data *htab)
  *   internal hash table, which is also guaranteed to be positive.
  *   This allows us direct access to the found hash table slot for
  *   example for functions like hdelete().
+ * - The table is not fixed in size: ENTER grows it once it gets more
+ *   than three quarters full.
  */
 
 int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
@@ -226,7 +325,7 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 	ENTRY **retval, struct hsearch_data *htab, int flag,
 	unsigned int hval, unsigned int idx)
 {
-	if (htab->table[idx].used == hval
+	if (htab->table[idx].used > 0 && htab->table[idx].hval == hval
 	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
 		/* Overwrite existing value? */
 		if ((action == ENTER) && (item.data != NULL)) {
@@ -272,37 +371,23 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	      struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
+	unsigned int first;
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hhash(item.key);
+	first = hfirst(hval, htab->size);
 
 	/* The first index tried. */
-	idx = hval;
+	idx = first;
 
 	if (htab->table[idx].used) {
 		/*
 		 * Further action might be required according to the
 		 * action value.
 		 */
-		unsigned hval2;
+		unsigned int step = hstep(hval, htab->size);
 
 		if (htab->table[idx].used == -1
 		    && !first_deleted)
@@ -313,29 +398,20 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
 		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+			idx = hnext(idx, step, htab->size);
 
 			/*
 			 * If we visited all entries leave the loop
 			 * unsuccessfully.
 			 */
-			if (idx == hval)
+			if (idx == first)
 				break;
 
+			if (htab->table[idx].used == -1
+			    && !first_deleted)
+				first_deleted = idx;
+
 			/* If entry is found use it. */
 			ret = _compare_and_overwrite_entry(item, action, retval,
 				htab, flag, hval, idx);
@@ -347,6 +423,22 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 
 	/* An empty bucket has been found. */
 	if (action == ENTER) {
+		/*
+		 * Keep the load factor down. The key is known not to be
+		 * present, so after growing just look for a free slot in
+		 * the new table. If growing fails we carry on with the old
+		 * one for as long as it has room.
+		 */
+		if ((htab->filled + 1) * HTAB_LOAD_DEN >
+		    htab->size * HTAB_LOAD_NUM && !hgrow_r(htab)) {
+			unsigned int step = hstep(hval, htab->size);
+
+			first = hfirst(hval, htab->size);
+			first_deleted = 0;
+			for (idx = first; htab->table[idx].used; )
+				idx = hnext(idx, step, htab->size);
+		}
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
@@ -364,7 +456,8 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		if (first_deleted)
 			idx = first_deleted;
 
-		htab->table[idx].used = hval;
+		htab->table[idx].used = first;
+		htab->table[idx].hval = hval;
 		htab->table[idx].entry.key = strdup(item.key);
 		htab->table[idx].entry.data = strdup(item.data);
 		if (!htab->table[idx].entry.key ||
@@ -591,7 +684,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	ENTRY *list[htab->size];
+	ENTRY **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -604,6 +697,14 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+
+	/* The table grows on demand, so keep the list off the stack */
+	list = malloc((htab->filled + 1) * sizeof(ENTRY *));
+	if (!list) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
+
 	/*
 	 * Pass 1:
 	 * search used entries,
@@ -659,6 +760,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		if (size < totlen + 1) {	/* provided buffer too small */
 			printf("Env export buffer too small: %lu, but need %lu\n",
 			       (ulong)size, (ulong)totlen + 1);
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -675,6 +777,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		/* no, allocate and clear one */
 		*resp = res = calloc(1, size);
 		if (res == NULL) {
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -701,6 +804,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		*p++ = sep;
 	}
 	*p = '\0';		/* terminate result */
+	free(list);
 
 	return size;
 }
@@ -979,3 +1083,39 @@ int hwalk_r(struct hsearch_data *htab, int (*callback)(ENTRY *))
 
 	return 0;
 }
+
+/*
+ * hstats_r()
+ */
+
+/*
+ * Work out how well the hash is doing: for every entry, count the slots
+ * which a lookup of its key has to look at before finding it.
+ */
+void hstats_r(struct hsearch_data *htab, struct hsearch_stats *stats)
+{
+	unsigned int i, idx, step, probes;
+
+	memset(stats, '\0', sizeof(*stats));
+	stats->size = htab->size;
+	stats->filled = htab->filled;
+	stats->resizes = htab->resizes;
+
+	for (i = 1; i <= htab->size; ++i) {
+		_ENTRY *ent = &htab->table[i];
+
+		if (ent->used == -1)
+			stats->deleted++;
+		if (ent->used <= 0)
+			continue;
+
+		idx = hfirst(ent->hval, htab->size);
+		step = hstep(ent->hval, htab->size);
+		for (probes = 1; idx != i; probes++)
+			idx = hnext(idx, step, htab->size);
+
+		stats->probes += probes;
+		if (probes > stats->max_probes)
+			stats->max_probes = probes;
+	}
+}
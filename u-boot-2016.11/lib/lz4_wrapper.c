@@ -5,7 +5,11 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <compiler.h>
+#include <cpu_work.h>
+#include <errno.h>
+#include <linux/err.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 
@@ -63,77 +67,332 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+/*
+ * Check the frame header and find the first block. With in-place
+ * decompression the header may become invalid later, so this is done
+ * before anything is written.
+ */
+static const void *lz4_frame_start(const void *src, size_t srcn,
+				   int *has_block_checksum, size_t *block_size)
 {
-	const void *end = dst + *dstn;
+	const struct lz4_frame_header *h = src;
 	const void *in = src;
-	void *out = dst;
+
+	if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
+		return ERR_PTR(-EINVAL);	/* input overrun */
+
+	/* We assume there's always only a single, standard frame. */
+	if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+		return ERR_PTR(-EPROTONOSUPPORT);	/* unknown format */
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return ERR_PTR(-EINVAL);	/* reserved must be zero */
+	if (!h->independent_blocks)
+		return ERR_PTR(-EPROTONOSUPPORT); /* we can't support this yet */
+	*has_block_checksum = h->has_block_checksum;
+	/* 4 = 64KiB, 5 = 256KiB, 6 = 1MiB, 7 = 4MiB */
+	*block_size = 1 << (8 + 2 * h->max_block_size);
+
+	in += sizeof(*h);
+	if (h->has_content_size)
+		in += sizeof(u64);
+	in += sizeof(u8);
+
+	return in;
+}
+
+struct lz4_stream {
+	const void *in;		/* next block header */
+	void *out;		/* where its data goes */
+	const void *end;	/* end of the output space */
 	int has_block_checksum;
+};
+
+/*
+ * Decompress the blocks which lie wholly before @avail. Returns 1 once the
+ * end mark is reached, 0 if more input is needed, -ve on error.
+ */
+static int lz4_stream_blocks(struct lz4_stream *ls, const void *avail)
+{
+	const void *in;
 	int ret;
-	*dstn = 0;
-
-	{ /* With in-place decompression the header may become invalid later. */
-		const struct lz4_frame_header *h = in;
-
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		/* We assume there's always only a single, standard frame. */
-		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if (h->reserved0 || h->reserved1 || h->reserved2)
-			return -EINVAL;	/* reserved must be zero */
-		if (!h->independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-		has_block_checksum = h->has_block_checksum;
-
-		in += sizeof(*h);
-		if (h->has_content_size)
-			in += sizeof(u64);
-		in += sizeof(u8);
-	}
 
 	while (1) {
 		struct lz4_block_header b;
 
+		in = ls->in;
+		if (in + sizeof(struct lz4_block_header) > avail)
+			return 0;
 		b.raw = le32_to_cpu(*(u32 *)in);
 		in += sizeof(struct lz4_block_header);
 
-		if (in - src + b.size > srcn) {
-			ret = -EINVAL;		/* input overrun */
-			break;
+		if (!b.size)
+			return 1;	/* decompression successful */
+		if (in + b.size > avail)
+			return 0;
+
+		if (b.not_compressed) {
+			size_t size = min((ptrdiff_t)b.size, ls->end - ls->out);
+			memcpy(ls->out, in, size);
+			ls->out += size;
+			if (size < b.size)
+				return -ENOBUFS;	/* output overrun */
+		} else {
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(in, ls->out, b.size,
+					ls->end - ls->out, endOnInputSize,
+					full, 0, noDict, ls->out, NULL, 0);
+			if (ret < 0)
+				return -EPROTO;	/* decompression error */
+			ls->out += ret;
 		}
 
-		if (!b.size) {
-			ret = 0;	/* decompression successful */
-			break;
+		in += b.size;
+		if (ls->has_block_checksum)
+			in += sizeof(u32);
+		ls->in = in;
+	}
+}
+
+static int ulz4fn_serial(const void *src, size_t srcn, const void *in,
+			 int has_block_checksum, void *dst, size_t *dstn)
+{
+	struct lz4_stream ls = {
+		.in = in,
+		.out = dst,
+		.end = dst + *dstn,
+		.has_block_checksum = has_block_checksum,
+	};
+	int ret;
+
+	ret = lz4_stream_blocks(&ls, src + srcn);
+	if (!ret)
+		ret = -EINVAL;		/* input overrun */
+	else if (ret > 0)
+		ret = 0;
+
+	*dstn = ls.out - dst;
+	return ret;
+}
+
+#ifdef CONFIG_CPU_WORK
+/*
+ * Blocks are independent, so they can be decompressed on several CPUs
+ * at once. Where each block's output goes is only known once the blocks
+ * before it are done, but the 'lz4' tool fills every block except the
+ * last one, so each CPU assumes that. If that turns out to be wrong, or
+ * anything else goes wrong, the frame is decompressed again serially,
+ * which also gives the same errors and output length as before.
+ */
+struct lz4_share {
+	int ret;
+	int blocks;		/* number of blocks in the frame */
+	int short_block;	/* first block which was not full, or -1 */
+	size_t short_size;	/* its size */
+};
+
+struct lz4_work {
+	const void *src;
+	size_t srcn;
+	const void *blocks;
+	int has_block_checksum;
+	size_t block_size;
+	void *dst;
+	size_t dstn;
+	int cpus;
+	struct lz4_share share[CPU_WORK_MAX_CPUS];
+};
+
+/* Decompress every cpus'th block, starting with block @cpu */
+static void lz4_decompress_share(void *arg, int cpu)
+{
+	struct lz4_work *work = arg;
+	struct lz4_share *share = &work->share[cpu];
+	const void *in = work->blocks;
+	const void *end = work->dst + work->dstn;
+	void *out;
+	int i, ret;
+
+	share->short_block = -1;
+	for (i = 0; ; i++) {
+		struct lz4_block_header b;
+
+		b.raw = le32_to_cpu(*(u32 *)in);
+		in += sizeof(struct lz4_block_header);
+
+		if (in - work->src + b.size > work->srcn) {
+			share->ret = -EINVAL;
+			return;
 		}
+		if (!b.size)
+			break;
 
-		if (b.not_compressed) {
-			size_t size = min((ptrdiff_t)b.size, end - out);
-			memcpy(out, in, size);
-			out += size;
-			if (size < b.size) {
-				ret = -ENOBUFS;	/* output overrun */
-				break;
+		if (i % work->cpus == cpu) {
+			out = work->dst + i * work->block_size;
+			if (b.size > min((ptrdiff_t)work->block_size,
+					 end - out)) {
+				share->ret = -ENOBUFS;
+				return;
 			}
-		} else {
-			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, b.size,
-					end - out, endOnInputSize,
+			if (b.not_compressed) {
+				ret = b.size;
+				memcpy(out, in, ret);
+			} else {
+				ret = LZ4_decompress_generic(in, out, b.size,
+					min((ptrdiff_t)work->block_size,
+					    end - out), endOnInputSize,
 					full, 0, noDict, out, NULL, 0);
-			if (ret < 0) {
-				ret = -EPROTO;	/* decompression error */
-				break;
+				if (ret < 0) {
+					share->ret = -EPROTO;
+					return;
+				}
+			}
+			if (ret != work->block_size && share->short_block < 0) {
+				share->short_block = i;
+				share->short_size = ret;
 			}
-			out += ret;
 		}
 
 		in += b.size;
-		if (has_block_checksum)
+		if (work->has_block_checksum)
 			in += sizeof(u32);
 	}
+	share->blocks = i;
+	share->ret = 0;
+}
+
+/* Check that the regions do not overlap, without risking a wrap */
+static bool lz4_apart(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	uintptr_t s = (uintptr_t)src, d = (uintptr_t)dst;
+
+	if (d >= s)
+		return d - s >= srcn;
+
+	return s - d >= dstn;
+}
+
+static int ulz4fn_parallel(struct lz4_work *work, size_t *dstn)
+{
+	int last, cpu;
+	size_t size;
+
+	if (cpu_work_run(lz4_decompress_share, work, work->cpus))
+		return -EAGAIN;
+
+	last = work->share[0].blocks - 1;
+	size = (size_t)(last + 1) * work->block_size;
+	for (cpu = 0; cpu < work->cpus; cpu++) {
+		struct lz4_share *share = &work->share[cpu];
+
+		if (share->ret)
+			return -EAGAIN;
+		if (share->short_block < 0)
+			continue;
+		if (share->short_block != last)
+			return -EAGAIN;
+		size = (size_t)last * work->block_size + share->short_size;
+	}
+	*dstn = size;
+
+	return 0;
+}
+#endif
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const void *in;
+	int has_block_checksum;
+	size_t block_size;
+
+	in = lz4_frame_start(src, srcn, &has_block_checksum, &block_size);
+	if (IS_ERR(in)) {
+		*dstn = 0;
+		return PTR_ERR(in);
+	}
+
+	/*
+	 * Callers without a size pass ~0. Trim that to the end of the
+	 * address space, so that the end pointers below do not wrap, and
+	 * keep the space left representable as a ptrdiff_t.
+	 */
+	*dstn = min3(*dstn, (size_t)~(uintptr_t)dst, (size_t)LONG_MAX);
+	srcn = min3(srcn, (size_t)~(uintptr_t)src, (size_t)LONG_MAX);
+
+#ifdef CONFIG_CPU_WORK
+	/*
+	 * Blocks are written out of order, so this needs the input to stay
+	 * intact. The serial retry below relies on that too: it must never
+	 * follow a parallel pass which may have written over the input.
+	 */
+	if (lz4_apart(src, srcn, dst, *dstn)) {
+		struct lz4_work work = {
+			.src = src,
+			.srcn = srcn,
+			.blocks = in,
+			.has_block_checksum = has_block_checksum,
+			.block_size = block_size,
+			.dst = dst,
+			.dstn = *dstn,
+			.cpus = cpu_work_cpus(),
+		};
+
+		if (work.cpus > 1) {
+			if (!ulz4fn_parallel(&work, dstn))
+				return 0;
+			debug("%s: retrying on one CPU\n", __func__);
+		}
+	}
+#endif
+
+	return ulz4fn_serial(src, srcn, in, has_block_checksum, dst, dstn);
+}
+
+#ifdef CONFIG_BLK
+struct lz4_pipe {
+	struct lz4_stream ls;
+	int started;
+	int ended;
+};
+
+/* Decompress each block of the frame once it has all been read */
+static int lz4_pipe_func(void *priv, void *buf, unsigned long len)
+{
+	struct lz4_pipe *lp = priv;
+	size_t block_size;
+	int ret;
+
+	if (!lp->started) {
+		lp->ls.in = lz4_frame_start(buf, len,
+					    &lp->ls.has_block_checksum,
+					    &block_size);
+		if (IS_ERR(lp->ls.in))
+			return PTR_ERR(lp->ls.in);
+		lp->started = 1;
+	}
+
+	ret = lz4_stream_blocks(&lp->ls, buf + len);
+	if (ret > 0)
+		lp->ended = 1;
 
-	*dstn = out - dst;
 	return ret;
 }
+
+int ulz4fn_blk(void *src, struct blk_desc *desc, lbaint_t start,
+	       lbaint_t blkcnt, void *dst, size_t *dstn)
+{
+	struct lz4_pipe lp = {
+		.ls.out = dst,
+		.ls.end = dst + *dstn,
+	};
+	unsigned long n;
+
+	n = blk_read_pipe(desc, start, blkcnt, src, lz4_pipe_func, &lp);
+	*dstn = lp.ls.out - dst;
+	if (IS_ERR_VALUE(n))
+		return n;
+	if (!lp.ended)
+		return -EINVAL;		/* input overrun */
+
+	return 0;
+}
+#endif
@@ -26,6 +26,12 @@
 #include <watchdog.h>
 #include <u-boot/sha1.h>
 
+#if defined(CONFIG_ARMV8_CE_SHA1) && !defined(USE_HOSTCC)
+#define sha1_blocks	sha1_blocks_ce
+#else
+#define sha1_blocks	sha1_blocks_generic
+#endif
+
 /*
  * 32-bit integer manipulation macros (big endian)
  */
@@ -61,28 +67,15 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+/*
+ * Process a 64-byte block, loading aligned input a word at a time.
+ */
+static void sha1_block(uint32_t state[5], const unsigned char *data)
 {
-	unsigned long temp, W[16], A, B, C, D, E;
-
-	GET_UINT32_BE (W[0], data, 0);
-	GET_UINT32_BE (W[1], data, 4);
-	GET_UINT32_BE (W[2], data, 8);
-	GET_UINT32_BE (W[3], data, 12);
-	GET_UINT32_BE (W[4], data, 16);
-	GET_UINT32_BE (W[5], data, 20);
-	GET_UINT32_BE (W[6], data, 24);
-	GET_UINT32_BE (W[7], data, 28);
-	GET_UINT32_BE (W[8], data, 32);
-	GET_UINT32_BE (W[9], data, 36);
-	GET_UINT32_BE (W[10], data, 40);
-	GET_UINT32_BE (W[11], data, 44);
-	GET_UINT32_BE (W[12], data, 48);
-	GET_UINT32_BE (W[13], data, 52);
-	GET_UINT32_BE (W[14], data, 56);
-	GET_UINT32_BE (W[15], data, 60);
-
-#define S(x,n)	((x << n) | ((x & 0xFFFFFFFF) >> (32 - n)))
+	uint32_t temp, W[16], A, B, C, D, E;
+	int i;
+
+#define S(x,n)	((x << n) | (x >> (32 - n)))
 
 #define R(t) (						\
 	temp = W[(t -  3) & 0x0F] ^ W[(t - 8) & 0x0F] ^	\
@@ -94,11 +87,22 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	e += S(a,5) + F(b,c,d) + K + x; b = S(b,30);	\
 }
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
+#ifndef USE_HOSTCC
+	if (IS_ALIGNED((uintptr_t)data, 4)) {
+		for (i = 0; i < 16; i++)
+			W[i] = be32_to_cpu(((const uint32_t *)data)[i]);
+	} else
+#endif
+	{
+		for (i = 0; i < 16; i++)
+			GET_UINT32_BE(W[i], data, i * 4);
+	}
+
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
 
 #define F(x,y,z) (z ^ (x & (y ^ z)))
 #define K 0x5A827999
@@ -208,11 +212,18 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 #undef K
 #undef F
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
+	state[0] += A;
+	state[1] += B;
+	state[2] += C;
+	state[3] += D;
+	state[4] += E;
+}
+
+void sha1_blocks_generic(uint32_t state[5], const unsigned char *data,
+			 unsigned int blocks)
+{
+	for (; blocks; blocks--, data += 64)
+		sha1_block(state, data);
 }
 
 /*
@@ -238,16 +249,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_blocks(ctx->state, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_blocks(ctx->state, input, ilen / 64);
+		input += ilen & ~0x3F;
+		ilen &= 0x3F;
 	}
 
 	if (ilen > 0) {
@@ -19,6 +19,7 @@
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
+#include <asm/byteorder.h>
 
 
 /**
@@ -473,22 +474,55 @@ void * memset(void * s,int c,size_t count)
  */
 void * memcpy(void *dest, const void *src, size_t count)
 {
-	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
-	char *d8, *s8;
+	unsigned long *dl, *sl, last, next;
+	char *d8 = dest;
+	const char *s8 = src;
+	int shift;
 
 	if (src == dest)
 		return dest;
 
-	/* while all data is aligned (common case), copy a word at a time */
-	if ( (((ulong)dest | (ulong)src) & (sizeof(*dl) - 1)) == 0) {
-		while (count >= sizeof(*dl)) {
-			*dl++ = *sl++;
-			count -= sizeof(*dl);
+	if (count >= 2 * sizeof(*dl)) {
+		/* align the destination */
+		while ((ulong)d8 & (sizeof(*dl) - 1)) {
+			*d8++ = *s8++;
+			count--;
 		}
+		dl = (unsigned long *)d8;
+		shift = ((ulong)s8 & (sizeof(*dl) - 1)) * 8;
+		sl = (unsigned long *)(s8 - shift / 8);
+
+		if (!shift) {
+			/* both aligned (common case): copy a word at a time */
+			while (count >= sizeof(*dl)) {
+				*dl++ = *sl++;
+				count -= sizeof(*dl);
+			}
+		} else {
+			/*
+			 * Read aligned words and shift each pair together,
+			 * rather than falling back to bytes. The words read
+			 * never go past the ones holding the source bytes.
+			 */
+			last = *sl++;
+			while (count >= sizeof(*dl)) {
+				next = *sl++;
+#ifdef __BIG_ENDIAN
+				*dl++ = (last << shift) |
+					(next >> (8 * sizeof(*dl) - shift));
+#else
+				*dl++ = (last >> shift) |
+					(next << (8 * sizeof(*dl) - shift));
+#endif
+				last = next;
+				count -= sizeof(*dl);
+			}
+			sl--;
+		}
+		d8 = (char *)dl;
+		s8 = (char *)sl + shift / 8;
 	}
-	/* copy the reset one byte at a time */
-	d8 = (char *)dl;
-	s8 = (char *)sl;
+	/* copy the rest one byte at a time */
 	while (count--)
 		*d8++ = *s8++;
 
@@ -512,6 +546,10 @@ void * memmove(void * dest,const void *src,size_t count)
 	if (src == dest)
 		return dest;
 
+	/* memcpy() is quicker, and safe if the areas do not overlap */
+	if (dest + count <= src || src + count <= dest)
+		return memcpy(dest, src, count);
+
 	if (dest <= src) {
 		tmp = (char *) dest;
 		s = (char *) src;
@@ -393,9 +393,14 @@ int eth_initialize(void)
 	 * Devices need to write the hwaddr even if not started so that Linux
 	 * will have access to the hwaddr that u-boot stored for the device.
 	 * This is accomplished by attempting to probe each device and calling
-	 * their write_hwaddr() operation.
+	 * their write_hwaddr() operation. With CONFIG_DM_LAZY_PROBE this is
+	 * left until the device is first used.
 	 */
+#ifdef CONFIG_DM_LAZY_PROBE
+	uclass_find_first_device(UCLASS_ETH, &dev);
+#else
 	uclass_first_device(UCLASS_ETH, &dev);
+#endif
 	if (!dev) {
 		printf("No ethernet found.\n");
 		bootstage_error(BOOTSTAGE_ID_NET_ETH_START);
@@ -417,14 +422,21 @@ int eth_initialize(void)
 			if (num_devices)
 				printf(", ");
 
-			printf("eth%d: %s", dev->seq, dev->name);
+			if (device_active(dev))
+				printf("eth%d: %s", dev->seq, dev->name);
+			else
+				printf("%s", dev->name);
 
 			if (ethprime && dev == prime_dev)
 				printf(" [PRIME]");
 
+#ifdef CONFIG_DM_LAZY_PROBE
+			uclass_find_next_device(&dev);
+#else
 			eth_write_hwaddr(dev);
 
 			uclass_next_device(&dev);
+#endif
 			num_devices++;
 		} while (dev);
 
@@ -525,6 +537,11 @@ static int eth_post_probe(struct udevice *dev)
 #endif
 	}
 
+#ifdef CONFIG_DM_LAZY_PROBE
+	/* eth_initialize() left this until now */
+	eth_write_hwaddr(dev);
+#endif
+
 	return 0;
 }
 
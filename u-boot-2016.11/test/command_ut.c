@@ -7,6 +7,11 @@
 #define DEBUG
 
 #include <common.h>
+#include <cli_hush.h>
+#include <console.h>
+#include <membuff.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 static const char test_cmd[] = "setenv list 1\n setenv list ${list}2; "
 		"setenv list ${list}3\0"
@@ -52,6 +57,95 @@ static int do_ut_cmd(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	assert(!strcmp("2", getenv("adder")));
 #endif
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	/* a cached script follows changes to its variable */
+	run_command("setenv foo 'setenv black 3'", 0);
+	run_command("run foo", 0);
+	assert(!strcmp("3", getenv("black")));
+	run_command("setenv foo 'setenv black 4'", 0);
+	run_command("run foo", 0);
+	assert(!strcmp("4", getenv("black")));
+
+	/* a script which changes itself and runs again */
+	run_command("setenv foo 'setenv foo setenv black 5; run foo'", 0);
+	run_command("run foo", 0);
+	assert(!strcmp("5", getenv("black")));
+	run_command("run foo", 0);
+	assert(!strcmp("5", getenv("black")));
+
+	/* leaving a loop early must not change the script for next time */
+	run_command("setenv foo 'for i in 1 2 3; do setenv black ${i}; "
+		    "if test ${i} = 2; then exit; fi; done'", 0);
+	run_command("run foo", 0);
+	assert(!strcmp("2", getenv("black")));
+	run_command("setenv black", 0);
+	run_command("run foo", 0);
+	assert(!strcmp("2", getenv("black")));
+
+#ifdef CONFIG_CONSOLE_RECORD
+	/* a syntax error is reported once and nothing is run */
+	{
+		static const char * const bad[] = {
+			"then setenv black 6",
+			"if true; then setenv black 6",
+		};
+		char *data, *p;
+		int i, len, count;
+
+		for (i = 0; i < ARRAY_SIZE(bad); i++) {
+			setenv("foo", bad[i]);
+			console_record_reset_enable();
+			assert(run_command("run foo", 0));
+			gd->flags &= ~GD_FLG_RECORD;
+			len = membuff_getraw(&gd->console_out, -1, true, &data);
+			data[len] = '\0';
+			count = 0;
+			for (p = data; (p = strstr(p, "syntax error")); p++)
+				count++;
+			assert(count == 1);
+			assert(!strcmp("2", getenv("black")));
+		}
+	}
+#endif
+
+	/* 1000 runs of a script from a loop, then from C with and without
+	 * the cache */
+	{
+		const char *step;
+		ulong start, loop_ms, cached_ms, parsed_ms;
+		int i;
+
+		run_command("setenv step 'setexpr n ${n} + 1; "
+			    "if itest ${n} -eq 1f4; then setenv half ${n}; fi'",
+			    0);
+		run_command("setenv loop 'setenv n 0; "
+			    "while itest ${n} -lt 3e8; do run step; done'", 0);
+		start = get_timer(0);
+		run_command("run loop", 0);
+		loop_ms = get_timer(start);
+		assert(!strcmp("3e8", getenv("n")));
+		assert(!strcmp("1f4", getenv("half")));
+
+		step = getenv("step");
+		start = get_timer(0);
+		for (i = 0; i < 1000; i++)
+			parse_string_cached("step", step, FLAG_PARSE_SEMICOLON |
+					    FLAG_EXIT_FROM_LOOP |
+					    FLAG_CONT_ON_NEWLINE);
+		cached_ms = get_timer(start);
+		assert(!strcmp("7d0", getenv("n")));
+
+		start = get_timer(0);
+		for (i = 0; i < 1000; i++)
+			run_command(step, CMD_FLAG_ENV);
+		parsed_ms = get_timer(start);
+		assert(!strcmp("bb8", getenv("n")));
+
+		printf("%s: 1000 x run: loop %lu ms, cached %lu ms, parsed %lu ms\n",
+		       __func__, loop_ms, cached_ms, parsed_ms);
+	}
+#endif
+
 	assert(run_command("", 0) == 0);
 	assert(run_command(" ", 0) == 0);
 
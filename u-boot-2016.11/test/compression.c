@@ -12,6 +12,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -371,6 +372,54 @@ out:
 	return ret;
 }
 
+/*
+ * Decompress an lz4 frame of stored 64KiB blocks in place, with the output
+ * starting one block below the input, so that each block written covers
+ * input which is read later. No output size is given, as with 'unlz4'.
+ */
+static int run_lz4_in_place_test(void)
+{
+	const int size = 8 * 65536 + 1000;
+	u8 *buf, *src, *in;
+	size_t dstn = ~0UL;
+	int i, pos, len, ret;
+
+	printf(" testing lz4 in place ...\n");
+	buf = malloc(65536 + size + 64);
+	if (!buf)
+		return 1;
+	src = buf + 65536;
+	in = src;
+	put_unaligned_le32(0x184d2204, in);	/* magic */
+	in[4] = 0x60;				/* version 1, independent */
+	in[5] = 0x40;				/* 64KiB blocks */
+	in[6] = 0;				/* header checksum, unchecked */
+	in += 7;
+	for (pos = 0; pos < size; pos += len) {
+		len = min(size - pos, 65536);
+		put_unaligned_le32(len | 0x80000000, in);	/* stored */
+		in += 4;
+		for (i = 0; i < len; i++)
+			in[i] = (pos + i) ^ ((pos + i) >> 16) * 13;
+		in += len;
+	}
+	put_unaligned_le32(0, in);		/* end mark */
+	in += 4;
+
+	ret = ulz4fn(src, in - src, buf, &dstn);
+	if (!ret && dstn != size)
+		ret = -EINVAL;
+	for (i = 0; !ret && i < size; i++) {
+		if (buf[i] != (u8)(i ^ (i >> 16) * 13))
+			ret = -EIO;
+	}
+	if (ret)
+		fprintf(stderr, "\tFailed: %d, size %zu\n", ret, dstn);
+	free(buf);
+
+	return ret != 0;
+}
+
 static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			     char *const argv[])
 {
@@ -381,6 +430,7 @@ static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
 	err += run_test("lz4", compress_using_lz4, uncompress_using_lz4);
+	err += run_lz4_in_place_test();
 
 	printf("ut_compression %s\n", err == 0 ? "ok" : "FAILED");
 
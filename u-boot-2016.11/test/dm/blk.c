@@ -6,8 +6,14 @@
 
 #include <common.h>
 #include <dm.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
+#include <asm/unaligned.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -94,3 +100,549 @@ static int dm_test_blk_usb(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_usb, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define TEST_FILE	"/tmp/u-boot-blk-test.img"
+#define TEST_SIZE	((3 << 20) + 1024)
+
+static void fill_buf(uint8_t *buf, ulong len)
+{
+	uint32_t seed = 0x12345678;
+
+	while (len--) {
+		seed = seed * 1103515245 + 12345;
+		*buf++ = seed >> 16;
+	}
+}
+
+/* Put @len bytes from @buf in a file, padded to a block, and use it as host0 */
+static int setup_host_file(struct unit_test_state *uts, const void *buf,
+			   ulong len, struct blk_desc **descp)
+{
+	char pad[512] = { 0 };
+	int fd;
+
+	fd = os_open(TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(len, os_write(fd, buf, len));
+	if (len % sizeof(pad))
+		os_write(fd, pad, sizeof(pad) - len % sizeof(pad));
+	os_close(fd);
+
+	ut_assertok(host_dev_bind(0, TEST_FILE));
+	ut_assertok(blk_get_device_by_str("host", "0", descp));
+	blkcache_invalidate(IF_TYPE_HOST, 0);
+
+	return 0;
+}
+
+static int remove_host_file(struct unit_test_state *uts)
+{
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(TEST_FILE);
+
+	return 0;
+}
+
+struct pipe_check {
+	struct blk_desc *desc;
+	const uint8_t *expect;
+	ulong offset;
+	int pieces;
+	int busy;		/* pieces seen while the next one was reading */
+	int stop_after;
+};
+
+static int pipe_check_func(void *priv, void *buf, unsigned long len)
+{
+	struct pipe_check *pc = priv;
+
+	if (memcmp(buf, pc->expect + pc->offset, len))
+		return -EIO;
+	pc->offset += len;
+	if (pc->desc->async.active)
+		pc->busy++;
+
+	return ++pc->pieces == pc->stop_after;
+}
+
+/* Test reading in the background and pipelined reads */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	struct pipe_check pc = { 0 };
+	struct blk_desc *desc;
+	uint8_t *data, *buf;
+	lbaint_t blkcnt = TEST_SIZE / 512;
+
+	data = malloc(TEST_SIZE);
+	buf = malloc(TEST_SIZE);
+	ut_assertnonnull(data);
+	ut_assertnonnull(buf);
+	fill_buf(data, TEST_SIZE);
+	ut_assertok(setup_host_file(uts, data, TEST_SIZE, &desc));
+
+	memset(buf, '\0', TEST_SIZE);
+	ut_assertok(blk_dread_async(desc, 1, 4, buf));
+	ut_asserteq(-EBUSY, blk_dread_async(desc, 5, 4, buf));
+	ut_asserteq(4, blk_dwait(desc));
+	ut_assertok(memcmp(buf, data + 512, 4 * 512));
+	ut_asserteq(-EINVAL, blk_dwait(desc));
+
+	/* Each piece but the last is seen while the next is being read */
+	memset(buf, '\0', TEST_SIZE);
+	pc.desc = desc;
+	pc.expect = data;
+	ut_asserteq(blkcnt, blk_read_pipe(desc, 0, blkcnt, buf,
+					  pipe_check_func, &pc));
+	ut_asserteq(TEST_SIZE, pc.offset);
+	ut_asserteq(4, pc.pieces);
+	ut_asserteq(3, pc.busy);
+	ut_assertok(memcmp(buf, data, TEST_SIZE));
+
+	/* Stopping early leaves the device idle */
+	memset(&pc, '\0', sizeof(pc));
+	pc.desc = desc;
+	pc.expect = data;
+	pc.stop_after = 2;
+	ut_asserteq(2 * BLK_PIPE_CHUNK_SIZE / 512,
+		    blk_read_pipe(desc, 0, blkcnt, buf, pipe_check_func, &pc));
+	ut_asserteq(2, pc.pieces);
+	ut_assert(!desc->async.active);
+	ut_asserteq(1, blk_dread(desc, 0, 1, buf));
+
+	/* Errors from the function are passed back */
+	memset(buf, '\0', TEST_SIZE);
+	pc.expect = buf + 1;
+	ut_asserteq(-EIO, blk_read_pipe(desc, 0, blkcnt, buf, pipe_check_func,
+					&pc));
+	ut_assert(!desc->async.active);
+
+	ut_assertok(remove_host_file(uts));
+	free(buf);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Build an LZ4 frame of 64KiB blocks, alternately stored and compressed, the
+ * latter being a run of "abcd" followed by "abcde"
+ */
+static ulong make_lz4_frame(uint8_t *frame, uint8_t *out, int count)
+{
+	static const uint8_t header[] = {
+		0x04, 0x22, 0x4d, 0x18, 0x60, 0x40, 0x00,
+	};
+	const ulong size = 64 << 10;
+	uint8_t *p = frame;
+	int i, j;
+
+	memcpy(p, header, sizeof(header));
+	p += sizeof(header);
+	for (i = 0; i < count; i++, out += size) {
+		if (i & 1) {
+			uint8_t *block = p + 4;
+
+			*block++ = 0x4f;
+			memcpy(block, "abcd", 4);
+			block += 4;
+			*block++ = 4;
+			*block++ = 0;
+			/* The match is 65527 bytes, i.e. 15 + 4 + 255 * 256 + 228 */
+			memset(block, 0xff, 256);
+			block += 256;
+			*block++ = 228;
+			*block++ = 0x50;
+			memcpy(block, "abcde", 5);
+			block += 5;
+			put_unaligned_le32(block - p - 4, p);
+			p = block;
+			for (j = 0; j < size - 5; j++)
+				out[j] = "abcd"[j & 3];
+			memcpy(out + size - 5, "abcde", 5);
+		} else {
+			put_unaligned_le32(size | 1U << 31, p);
+			fill_buf(p + 4, size);
+			memcpy(out, p + 4, size);
+			p += 4 + size;
+		}
+	}
+	put_unaligned_le32(0, p);
+	p += 4;
+
+	return p - frame;
+}
+
+/* Run a command which decompresses the whole of host 0 and check the result */
+static int check_decomp_cmd(struct unit_test_state *uts, const char *name,
+			    struct blk_desc *desc, void *src, uint8_t *out,
+			    const uint8_t *expect, ulong size)
+{
+	char cmd[80];
+
+	memset(out, '\0', size);
+	snprintf(cmd, sizeof(cmd), "%s host 0 %lx %lx 0 %lx %lx", name,
+		 (ulong)map_to_sysmem(src), (ulong)map_to_sysmem(out),
+		 (ulong)desc->lba, size);
+	ut_assertok(run_command(cmd, 0));
+	ut_asserteq(size, getenv_hex("filesize", 0));
+	ut_assertok(memcmp(out, expect, size));
+
+	return 0;
+}
+
+/* Test decompressing data while it is read */
+static int dm_test_blk_decomp(struct unit_test_state *uts)
+{
+	const ulong count = 48, size = count << 16;
+	uint8_t *data, *comp, *src, *out;
+	struct blk_desc *desc;
+	unsigned long len;
+	size_t lz4_len;
+
+	data = malloc(size);
+	comp = malloc(size + 4096);
+	src = malloc(size + 4096);
+	out = malloc(size);
+	ut_assertnonnull(data);
+	ut_assertnonnull(comp);
+	ut_assertnonnull(src);
+	ut_assertnonnull(out);
+
+	/* Half random and half text, so that gzip gives several pieces */
+	fill_buf(data, size / 2);
+	for (len = size / 2; len < size; len++)
+		data[len] = "The quick brown fox\n"[len % 20];
+	len = size + 4096;
+	ut_assertok(gzip(comp, &len, data, size));
+	ut_assert(len > BLK_PIPE_CHUNK_SIZE);
+	ut_assertok(setup_host_file(uts, comp, len, &desc));
+	memset(out, '\0', size);
+	ut_assertok(gunzip_blk(out, size, src, desc, 0,
+			       (size + 4096) / 512, &len));
+	ut_asserteq(size, len);
+	ut_assertok(memcmp(out, data, size));
+	ut_assertok(check_decomp_cmd(uts, "gzread", desc, src, out, data,
+				     size));
+	ut_assertok(remove_host_file(uts));
+
+	len = make_lz4_frame(comp, data, count);
+	ut_assert(len > BLK_PIPE_CHUNK_SIZE);
+	ut_assertok(setup_host_file(uts, comp, len, &desc));
+	memset(out, '\0', size);
+	lz4_len = size;
+	ut_assertok(ulz4fn_blk(src, desc, 0, (size + 4096) / 512, out,
+			       &lz4_len));
+	ut_asserteq(size, lz4_len);
+	ut_assertok(memcmp(out, data, size));
+	ut_assertok(check_decomp_cmd(uts, "lz4read", desc, src, out, data,
+				     size));
+
+	/* The result must be the same as decompressing from memory */
+	memset(out, '\0', size);
+	lz4_len = size;
+	ut_assertok(ulz4fn(comp, len, out, &lz4_len));
+	ut_asserteq(size, lz4_len);
+	ut_assertok(memcmp(out, data, size));
+
+	/* A truncated frame is an error */
+	lz4_len = size;
+	ut_asserteq(-EINVAL, ulz4fn_blk(src, desc, 0, len / 1024, out,
+					&lz4_len));
+	ut_assertok(remove_host_file(uts));
+
+	free(out);
+	free(src);
+	free(comp);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_decomp, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define SPARSE_BLK_SZ	4096
+
+/* Add a chunk header to a sparse image, returning a pointer to its data */
+static uint8_t *add_chunk(uint8_t *p, sparse_header_t *hdr, uint type,
+			  uint blocks, uint data_len)
+{
+	chunk_header_t *chunk = (chunk_header_t *)p;
+
+	chunk->chunk_type = type;
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = blocks;
+	chunk->total_sz = sizeof(*chunk) + data_len;
+	hdr->total_chunks++;
+	hdr->total_blks += blocks;
+
+	return p + sizeof(*chunk);
+}
+
+/*
+ * Build a sparse image with raw, fill, don't-care and CRC chunks, each raw
+ * and fill chunk being larger than the parser's buffer. This also sets up
+ * @out with the data expected on storage which starts off filled with @old.
+ */
+static ulong make_sparse_image(uint8_t *image, uint8_t *out, uint8_t old)
+{
+	sparse_header_t *hdr = (sparse_header_t *)image;
+	uint8_t *p = image + sizeof(*hdr);
+	uint32_t fill = 0xdeadbeef;
+	ulong size;
+	int i;
+
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(chunk_header_t);
+	hdr->blk_sz = SPARSE_BLK_SZ;
+
+	size = 200 * SPARSE_BLK_SZ;
+	p = add_chunk(p, hdr, CHUNK_TYPE_RAW, 200, size);
+	fill_buf(p, size);
+	memcpy(out, p, size);
+	p += size;
+	out += size;
+
+	size = 300 * SPARSE_BLK_SZ;
+	p = add_chunk(p, hdr, CHUNK_TYPE_FILL, 300, sizeof(fill));
+	memcpy(p, &fill, sizeof(fill));
+	p += sizeof(fill);
+	for (i = 0; i < size; i += sizeof(fill))
+		memcpy(out + i, &fill, sizeof(fill));
+	out += size;
+
+	size = 10 * SPARSE_BLK_SZ;
+	p = add_chunk(p, hdr, CHUNK_TYPE_DONT_CARE, 10, 0);
+	memset(out, old, size);
+	out += size;
+
+	p = add_chunk(p, hdr, CHUNK_TYPE_CRC32, 0, sizeof(uint32_t));
+	memset(p, '\0', sizeof(uint32_t));
+	p += sizeof(uint32_t);
+
+	size = 140 * SPARSE_BLK_SZ;
+	p = add_chunk(p, hdr, CHUNK_TYPE_RAW, 140, size);
+	fill_buf(p, size);
+	memcpy(out, p, size);
+	p += size;
+
+	return p - image;
+}
+
+static lbaint_t sparse_test_write(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, const void *buffer)
+{
+	return blk_dwrite(info->priv, blk, blkcnt, buffer);
+}
+
+/* Storage block at which sparse_test_fail_write() starts to fail */
+static lbaint_t sparse_fail_blk;
+
+static lbaint_t sparse_test_fail_write(struct sparse_storage *info,
+				       lbaint_t blk, lbaint_t blkcnt,
+				       const void *buffer)
+{
+	if (blk >= sparse_fail_blk)
+		return 0;
+	blkcnt = min(blkcnt, sparse_fail_blk - blk);
+
+	return blk_dwrite(info->priv, blk, blkcnt, buffer);
+}
+
+static lbaint_t sparse_test_reserve(struct sparse_storage *info,
+				    lbaint_t blk, lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+/* Write a sparse image to host0 in pieces of @piece bytes and check it */
+static int check_sparse_stream(struct unit_test_state *uts,
+			       struct blk_desc *desc, const uint8_t *image,
+			       ulong len, ulong piece, const uint8_t *expect,
+			       ulong expect_len, uint8_t *buf)
+{
+	struct sparse_storage info = {
+		.blksz = desc->blksz,
+		.start = 0,
+		.size = desc->lba,
+		.priv = desc,
+		.write = sparse_test_write,
+		.reserve = sparse_test_reserve,
+	};
+	struct sparse_stream ss;
+	ulong pos, todo;
+
+	ut_assertok(sparse_stream_start(&ss, &info));
+	for (pos = 0; pos < len; pos += todo) {
+		todo = min(piece, len - pos);
+		ut_assertok(sparse_stream_write(&ss, image + pos, todo));
+	}
+	ut_assertok(sparse_stream_finish(&ss));
+	ut_asserteq(640 * SPARSE_BLK_SZ, ss.bytes_written);
+
+	ut_asserteq(expect_len / 512, blk_dread(desc, 0, expect_len / 512, buf));
+	ut_assertok(memcmp(buf, expect, expect_len));
+
+	return 0;
+}
+
+/*
+ * Write a sparse image one chunk at a time to storage which fails at block
+ * @fail_blk. Like fastboot, carry on sending data after an error, and check
+ * that the stream still reports the failure at the end.
+ */
+static int check_sparse_fail(struct unit_test_state *uts,
+			     struct blk_desc *desc, const uint8_t *image,
+			     lbaint_t fail_blk)
+{
+	const sparse_header_t *hdr = (const sparse_header_t *)image;
+	struct sparse_storage info = {
+		.blksz = desc->blksz,
+		.start = 0,
+		.size = desc->lba,
+		.priv = desc,
+		.write = sparse_test_fail_write,
+		.reserve = sparse_test_reserve,
+	};
+	const chunk_header_t *chunk;
+	struct sparse_stream ss;
+	ulong pos, todo;
+	int i, err, ret;
+
+	sparse_fail_blk = fail_blk;
+	ut_assertok(sparse_stream_start(&ss, &info));
+	ut_assertok(sparse_stream_write(&ss, image, hdr->file_hdr_sz));
+	ret = 0;
+	for (pos = hdr->file_hdr_sz, i = 0; i < hdr->total_chunks;
+	     pos += todo, i++) {
+		chunk = (const chunk_header_t *)(image + pos);
+		todo = chunk->total_sz;
+		err = sparse_stream_write(&ss, image + pos, todo);
+		ut_assert(!ret || err == -EINVAL);
+		if (!ret)
+			ret = err;
+	}
+	ut_asserteq(-EIO, ret);
+	ut_asserteq(-EINVAL, sparse_stream_finish(&ss));
+	ut_assert(ss.total_blocks < hdr->total_blks);
+	ut_assert(ss.bytes_written <= fail_blk * desc->blksz);
+
+	return 0;
+}
+
+/* Test writing a sparse image as it arrives */
+static int dm_test_blk_sparse(struct unit_test_state *uts)
+{
+	const ulong disk_size = 3 << 20, out_size = 650 * SPARSE_BLK_SZ;
+	struct blk_desc *desc;
+	uint8_t *image, *out, *old, *buf;
+	struct sparse_storage info;
+	struct sparse_stream ss;
+	ulong len;
+
+	image = malloc(disk_size);
+	out = malloc(out_size);
+	old = malloc(disk_size);
+	buf = malloc(disk_size);
+	ut_assertnonnull(image);
+	ut_assertnonnull(out);
+	ut_assertnonnull(old);
+	ut_assertnonnull(buf);
+	len = make_sparse_image(image, out, 0x55);
+	ut_assert(len > 512 << 10);	/* the size of the parser's buffer */
+
+	/* Whole image, USB-sized pieces and odd pieces which split headers */
+	memset(old, 0x55, disk_size);
+	ut_assertok(setup_host_file(uts, old, disk_size, &desc));
+	ut_assertok(check_sparse_stream(uts, desc, image, len, len, out,
+					out_size, buf));
+	ut_assertok(remove_host_file(uts));
+	ut_assertok(setup_host_file(uts, old, disk_size, &desc));
+	ut_assertok(check_sparse_stream(uts, desc, image, len, 4096, out,
+					out_size, buf));
+	ut_assertok(remove_host_file(uts));
+	ut_assertok(setup_host_file(uts, old, disk_size, &desc));
+	ut_assertok(check_sparse_stream(uts, desc, image, len, 7, out,
+					out_size, buf));
+
+	/* A failed write, in a fill chunk or a raw one, fails the stream */
+	ut_assertok(check_sparse_fail(uts, desc, image, 2000));
+	ut_assertok(check_sparse_fail(uts, desc, image, 5100));
+
+	/* A truncated image is an error */
+	memset(&info, '\0', sizeof(info));
+	info.blksz = desc->blksz;
+	info.size = desc->lba;
+	info.priv = desc;
+	info.write = sparse_test_write;
+	info.reserve = sparse_test_reserve;
+	ut_assertok(sparse_stream_start(&ss, &info));
+	ut_assertok(sparse_stream_write(&ss, image, len - 1));
+	ut_asserteq(-EINVAL, sparse_stream_finish(&ss));
+
+	/* So is one which is too large for the storage */
+	info.size = 100;
+	ut_assertok(sparse_stream_start(&ss, &info));
+	ut_asserteq(-ENOSPC, sparse_stream_write(&ss, image, len));
+	ut_asserteq(-EINVAL, sparse_stream_finish(&ss));
+	ut_assertok(remove_host_file(uts));
+
+	free(buf);
+	free(old);
+	free(out);
+	free(image);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_sparse, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+static struct block_cache_dev_stats cache_dev;
+static int cache_dev_count;
+
+static void cache_dev_check(struct block_cache_dev_stats *stats)
+{
+	if (stats->iftype == IF_TYPE_HOST && !stats->devnum) {
+		cache_dev = *stats;
+		cache_dev_count++;
+	}
+}
+
+/* Count the block cache entries for host0, collecting its statistics */
+static int host_cache_devs(void)
+{
+	cache_dev_count = 0;
+	blkcache_dev_stats(cache_dev_check);
+
+	return cache_dev_count;
+}
+
+/* Test that the block cache only tracks devices which are in use */
+static int dm_test_blk_cache_dev(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	uint8_t data[4096], buf[512];
+
+	/* Looking for blocks of an unknown device does not track it */
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 0, 0, 1, 512, buf));
+	ut_asserteq(0, host_cache_devs());
+
+	fill_buf(data, sizeof(data));
+	ut_assertok(setup_host_file(uts, data, sizeof(data), &desc));
+	host_cache_devs();
+	ut_asserteq(1, blk_dread(desc, 3, 1, buf));
+	ut_asserteq(1, blk_dread(desc, 3, 1, buf));
+	ut_assertok(memcmp(buf, data + 3 * 512, 512));
+	ut_asserteq(1, host_cache_devs());
+	ut_asserteq(1, cache_dev.hits);
+	ut_asserteq(1, cache_dev.misses);
+	ut_asserteq(1, cache_dev.reads);
+
+	/* Removing the device drops its entry */
+	ut_assertok(remove_host_file(uts));
+	ut_asserteq(0, host_cache_devs());
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache_dev, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -12,6 +12,7 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -796,3 +797,99 @@ static int dm_test_device_get_uclass_id(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_device_get_uclass_id, DM_TESTF_SCAN_PDATA);
+
+/* Search the whole driver list for a name or a compatible string */
+static struct driver *find_driver(const char *name, const char *compat,
+				  const struct udevice_id **of_idp)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id;
+	struct driver *entry;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		if (name && !strcmp(entry->name, name))
+			return entry;
+		for (of_id = entry->of_match;
+		     compat && of_id && of_id->compatible; of_id++) {
+			if (!strcmp(of_id->compatible, compat)) {
+				*of_idp = of_id;
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Driver lookups by name and by compatible string must find the same
+ * driver as a search through the whole driver list, including where
+ * several drivers share a name or a compatible string
+ */
+static int dm_test_lists_lookup(struct unit_test_state *uts)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id, *found_id, *expect_id = NULL;
+	struct driver *entry, *expect;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		ut_asserteq_ptr(find_driver(entry->name, NULL, NULL),
+				lists_driver_lookup_name(entry->name));
+
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			expect = find_driver(NULL, of_id->compatible,
+					     &expect_id);
+			ut_asserteq_ptr(expect, lists_driver_lookup_compat(
+					of_id->compatible, &found_id));
+			ut_asserteq_ptr(expect_id, found_id);
+		}
+	}
+
+	ut_asserteq_ptr(NULL, lists_driver_lookup_name("no-such-driver"));
+	ut_asserteq_ptr(NULL, lists_driver_lookup_compat("no,such-device",
+							 &found_id));
+
+	return 0;
+}
+DM_TEST(dm_test_lists_lookup, 0);
+
+#if CONFIG_IS_ENABLED(DM_PROBE_STATS)
+/* Test that probes are timed and nested probes recorded as dependencies */
+static int dm_test_probe_stats(struct unit_test_state *uts)
+{
+	struct dm_probe_frame frame;
+	struct udevice *dev, *dep;
+
+	/* The test uclass wants devices probed in order */
+	ut_assertok(uclass_find_device(UCLASS_TEST, 1, &dev));
+	ut_assertok(uclass_find_device(UCLASS_TEST, 0, &dep));
+	ut_asserteq(0, dev->probe_stats.order);
+	ut_asserteq(0, dep->probe_stats.order);
+
+	/* Probe one device in the middle of a failed probe of the other */
+	dm_probe_stats_start(dev, &frame);
+	ut_assertok(device_probe(dep));
+	dm_probe_stats_end(&frame, -EAGAIN);
+	ut_assert(dm_probe_stats_needs(dev, dep));
+	ut_assert(!dm_probe_stats_needs(dep, dev));
+	ut_asserteq(0, dev->probe_stats.order);
+	ut_assert(dep->probe_stats.order > 0);
+	ut_assert(dep->probe_stats.self_us <= dep->probe_stats.total_us);
+
+	/* The parent is not recorded as a dependency */
+	ut_assertok(device_probe(dev));
+	ut_assert(dev->probe_stats.order > dep->probe_stats.order);
+	ut_assert(!dm_probe_stats_needs(dev, dev->parent));
+
+	/* Unbinding a device drops its dependencies */
+	ut_assertok(device_remove(dep));
+	ut_assertok(device_unbind(dep));
+	ut_assert(!dm_probe_stats_needs(dev, dep));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_stats, DM_TESTF_SCAN_PDATA);
+#endif
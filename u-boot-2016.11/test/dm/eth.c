@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
@@ -259,3 +260,75 @@ static int dm_test_net_retry(struct unit_test_state *uts)
 	return retval;
 }
 DM_TEST(dm_test_net_retry, DM_TESTF_SCAN_FDT);
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_net_tftp_window(struct unit_test_state *uts,
+				    const uchar *data, int size)
+{
+	void *buf = map_sysmem(load_addr, size);
+
+	/* With a window of 4, ACK 0 is followed by one ACK per window */
+	setenv("tftpwindowsize", "4");
+	sandbox_eth_tftp_serve(data, size, 0);
+	ut_asserteq(size, net_loop(TFTPGET));
+	ut_asserteq(4, sandbox_eth_tftp_windowsize());
+	ut_asserteq(7, sandbox_eth_tftp_acks());
+	ut_assertok(memcmp(data, buf, size));
+
+	/*
+	 * Losing block 6 gives a single extra ACK of block 5, although the
+	 * rest of that window still arrives, and the server restarts there.
+	 */
+	memset(buf, '\0', size);
+	sandbox_eth_tftp_serve(data, size, 6);
+	ut_asserteq(size, net_loop(TFTPGET));
+	ut_asserteq(7, sandbox_eth_tftp_acks());
+	ut_assertok(memcmp(data, buf, size));
+
+	/* Once tftpwindowsize is cleared, every block is ACKed again */
+	setenv("tftpwindowsize", NULL);
+	memset(buf, '\0', size);
+	sandbox_eth_tftp_serve(data, size, 0);
+	ut_asserteq(size, net_loop(TFTPGET));
+	ut_asserteq(0, sandbox_eth_tftp_windowsize());
+	ut_asserteq(21, sandbox_eth_tftp_acks());
+	ut_assertok(memcmp(data, buf, size));
+
+	return 0;
+}
+
+static int dm_test_net_tftp_window(struct unit_test_state *uts)
+{
+	/* 20 full 512-byte blocks and a short one */
+	const int size = 20 * 512 + 100;
+	char old_file_name[sizeof(net_boot_file_name)];
+	struct in_addr old_server_ip = net_server_ip;
+	ulong old_load_addr = load_addr;
+	uchar *data;
+	int retval, i;
+
+	data = malloc(size);
+	ut_assertnonnull(data);
+	/* Make each block different, so a misplaced block is noticed */
+	for (i = 0; i < size; i++)
+		data[i] = i ^ (i >> 9);
+
+	setenv("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(old_file_name, net_boot_file_name);
+	strcpy(net_boot_file_name, "window.bin");
+	load_addr = 0x100000;
+
+	retval = _dm_test_net_tftp_window(uts, data, size);
+
+	/* Restore the env */
+	sandbox_eth_tftp_serve(NULL, 0, 0);
+	setenv("tftpwindowsize", NULL);
+	strcpy(net_boot_file_name, old_file_name);
+	net_server_ip = old_server_ip;
+	load_addr = old_load_addr;
+	free(data);
+
+	return retval;
+}
+DM_TEST(dm_test_net_tftp_window, DM_TESTF_SCAN_FDT);
@@ -6,7 +6,11 @@
 
 #include <common.h>
 #include <dm.h>
+#include <memalign.h>
 #include <mmc.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -35,7 +39,12 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
 	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
 
-	/* Read a few blocks and look for the string we expect */
+	/*
+	 * Read a few blocks and look for the string we expect. Only
+	 * multi-block reads return it, so drop any single blocks which were
+	 * cached while the partition table was read.
+	 */
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
 	ut_asserteq(512, dev_desc->blksz);
 	memset(cmp, '\0', sizeof(cmp));
 	ut_asserteq(2, blk_dread(dev_desc, 0, 2, cmp));
@@ -44,3 +53,198 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+static int mmc_read_all(struct unit_test_state *uts, struct blk_desc *dev_desc,
+			int count, void *buf)
+{
+	int i;
+
+	/* Read different blocks each time so that none come from a cache */
+	for (i = 0; i < count; i++)
+		ut_asserteq(8, blk_dread(dev_desc, 0x100 + i * 8, 8, buf));
+
+	return 0;
+}
+
+/*
+ * Multi-block transfers should be sized with SET_BLOCK_COUNT when the host
+ * and card allow it, and SET_BLOCKLEN should only be sent when it changes
+ */
+static int dm_test_mmc_cmd23(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct mmc *mmc;
+	char buf[8 * 512];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assert(mmc->card_caps & MMC_MODE_CMD23);
+
+	sandbox_mmc_reset_cmd_counts(dev);
+	ut_assertok(mmc_read_all(uts, dev_desc, 4, buf));
+	ut_asserteq(4, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+	ut_asserteq(4, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_READ_MULTIPLE_BLOCK));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_STOP_TRANSMISSION));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCKLEN));
+
+	sandbox_mmc_reset_cmd_counts(dev);
+	ut_asserteq(8, blk_dwrite(dev_desc, 0x100, 8, buf));
+	ut_asserteq(1, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+	ut_asserteq(1, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_WRITE_MULTIPLE_BLOCK));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_STOP_TRANSMISSION));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCKLEN));
+
+	/* Without CMD23 each transfer must be stopped */
+	mmc->card_caps &= ~MMC_MODE_CMD23;
+	sandbox_mmc_reset_cmd_counts(dev);
+	ut_assertok(mmc_read_all(uts, dev_desc, 4, buf));
+	mmc->card_caps |= MMC_MODE_CMD23;
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+	ut_asserteq(4, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_STOP_TRANSMISSION));
+
+	/* A new block length must be set after the card is reset */
+	mmc->has_init = 0;
+	sandbox_mmc_reset_cmd_counts(dev);
+	ut_assertok(mmc_init(mmc));
+	ut_assertok(mmc_read_all(uts, dev_desc, 4, buf));
+	ut_asserteq(1, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCKLEN));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_cmd23, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* A read can be started and the data collected later */
+static int dm_test_mmc_async(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(char, cmp, 1024 + ARCH_DMA_MINALIGN);
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+
+	/* Sandbox only transfers the data when it is waited for */
+	sandbox_mmc_reset_cmd_counts(dev);
+	memset(cmp, '\0', 1024);
+	ut_assertok(blk_dread_async(dev_desc, 0, 2, cmp));
+	ut_asserteq(-EBUSY, blk_dread_async(dev_desc, 0, 2, cmp));
+	ut_asserteq(1, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_READ_MULTIPLE_BLOCK));
+	ut_asserteq(0, cmp[0]);
+
+	ut_asserteq(2, blk_dwait(dev_desc));
+	ut_asserteq(1, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_READ_MULTIPLE_BLOCK));
+	ut_assertok(strcmp(cmp, "this is a test"));
+
+	/* Now it is in the cache, so the card is not used at all */
+	sandbox_mmc_reset_cmd_counts(dev);
+	memset(cmp, '\0', 1024);
+	ut_assertok(blk_dread_async(dev_desc, 0, 2, cmp));
+	ut_assertok(strcmp(cmp, "this is a test"));
+	ut_asserteq(2, blk_dwait(dev_desc));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev,
+						 MMC_CMD_READ_MULTIPLE_BLOCK));
+	ut_asserteq(-EINVAL, blk_dwait(dev_desc));
+
+	/* A buffer which cannot be read in the background sends nothing */
+	sandbox_mmc_reset_cmd_counts(dev);
+	ut_asserteq(-ENOSYS, blk_get_ops(dev_desc->bdev)->read_async(
+			dev_desc->bdev, 0x100, 2, cmp + 1));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Cards which are powering up are waited for together */
+static int dm_test_mmc_init_devices(struct unit_test_state *uts)
+{
+	struct udevice *dev[2];
+	struct mmc *mmc[2];
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev[0]));
+	ut_assertok(device_bind_driver(gd->dm_root, "mmc_sandbox", "mmc1",
+				       &dev[1]));
+	ut_assertok(device_probe(dev[1]));
+
+	for (i = 0; i < 2; i++) {
+		mmc[i] = mmc_get_mmc_dev(dev[i]);
+		ut_assert(mmc[i]->has_init);
+		mmc[i]->has_init = 0;
+		sandbox_mmc_reset_cmd_counts(dev[i]);
+
+		/* Starting does not wait for the card to power up */
+		ut_assertok(mmc_start_init(mmc[i]));
+		ut_assert(mmc[i]->op_cond_pending);
+		ut_asserteq(1, sandbox_mmc_get_cmd_count(dev[i],
+						SD_CMD_APP_SEND_OP_COND));
+	}
+
+	ut_assertok(mmc_init_devices(mmc, 2));
+	for (i = 0; i < 2; i++) {
+		ut_assert(mmc[i]->has_init);
+		ut_assert(!mmc[i]->op_cond_pending);
+		ut_asserteq(4, sandbox_mmc_get_cmd_count(dev[i],
+						SD_CMD_APP_SEND_OP_COND));
+	}
+
+	/* Cards which are ready are left alone */
+	sandbox_mmc_reset_cmd_counts(dev[0]);
+	ut_assertok(mmc_init_devices(mmc, 1));
+	ut_asserteq(0, sandbox_mmc_get_cmd_count(dev[0],
+						 MMC_CMD_GO_IDLE_STATE));
+
+	ut_assertok(device_remove(dev[1]));
+	ut_assertok(device_unbind(dev[1]));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_init_devices, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* A card which fails is counted once, and the others are still waited for */
+static int dm_test_mmc_init_devices_fail(struct unit_test_state *uts)
+{
+	struct udevice *dev[2];
+	struct mmc *mmc[2];
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev[0]));
+	ut_assertok(device_bind_driver(gd->dm_root, "mmc_sandbox", "mmc1",
+				       &dev[1]));
+	ut_assertok(device_probe(dev[1]));
+	for (i = 0; i < 2; i++) {
+		mmc[i] = mmc_get_mmc_dev(dev[i]);
+		mmc[i]->has_init = 0;
+		sandbox_mmc_reset_cmd_counts(dev[i]);
+	}
+
+	/* The first card fails once powered up, long before the second one */
+	sandbox_mmc_set_fail_cmd(dev[0], MMC_CMD_ALL_SEND_CID, true);
+	sandbox_mmc_set_powerup(dev[1], 20);
+	ut_asserteq(1, mmc_init_devices(mmc, 2));
+	ut_assert(!mmc[0]->has_init);
+	ut_assert(mmc[1]->has_init);
+	ut_asserteq(1, sandbox_mmc_get_cmd_count(dev[0],
+						 MMC_CMD_ALL_SEND_CID));
+	ut_asserteq(21, sandbox_mmc_get_cmd_count(dev[1],
+						  SD_CMD_APP_SEND_OP_COND));
+
+	sandbox_mmc_set_fail_cmd(dev[0], MMC_CMD_ALL_SEND_CID, false);
+	ut_assertok(mmc_init(mmc[0]));
+	ut_assertok(device_remove(dev[1]));
+	ut_assertok(device_unbind(dev[1]));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_init_devices_fail, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
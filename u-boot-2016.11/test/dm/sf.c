@@ -7,12 +7,18 @@
 #include <common.h>
 #include <dm.h>
 #include <fdtdec.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
 #include <spi.h>
 #include <spi_flash.h>
 #include <asm/state.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <dm/util.h>
 #include <test/ut.h>
+#include <linux/sizes.h>
 
 /* Test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash(struct unit_test_state *uts)
@@ -41,3 +47,237 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define SF_4B_FILE	"/tmp/u-boot-sf-4b.bin"
+
+/* 3-byte and 4-byte address forms of the commands used below */
+#define SF_READ_FAST		0x0b
+#define SF_READ_FAST_4B		0x0c
+#define SF_PAGE_PROGRAM_4B	0x12
+#define SF_ERASE_64K_4B		0xdc
+#define SF_PAGE_PROGRAM		0x02
+#define SF_ERASE_4K		0x20
+#define SF_ERASE_64K		0xd8
+
+/* Test that a 32MiB flash is accessed with 4-byte address commands */
+static int dm_test_spi_flash_4b(struct unit_test_state *uts)
+{
+	struct sandbox_state *state = state_get_current();
+	const uint size = 0x20000, offset = SZ_16M - size / 2;
+	struct udevice *dev, *emul;
+	struct spi_flash *flash;
+	u8 *data, *buf;
+	int fd, i;
+
+	data = malloc(size);
+	buf = malloc(size);
+	ut_assertnonnull(data);
+	ut_assertnonnull(buf);
+	for (i = 0; i < size; i++)
+		data[i] = i ^ (i >> 8);
+	fd = os_open(SF_4B_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(offset, os_lseek(fd, offset, OS_SEEK_SET));
+	ut_asserteq(size, os_write(fd, data, size));
+	ut_asserteq(SZ_32M - 1, os_lseek(fd, SZ_32M - 1, OS_SEEK_SET));
+	ut_asserteq(1, os_write(fd, buf, 1));
+	os_close(fd);
+
+	state->spi[0][1].spec = "S25FL256S_64K:" SF_4B_FILE;
+	ut_assertok(spi_flash_probe_bus_cs(0, 1, 0, 0, &dev));
+	flash = dev_get_uclass_priv(dev);
+	ut_asserteq(SZ_32M, flash->size);
+	emul = state->spi[0][1].emul;
+	ut_assertnonnull(emul);
+
+	/* A read across the 16MiB boundary is a single command */
+	memset(buf, '\0', size);
+	ut_assertok(spi_flash_read(flash, offset, size, buf));
+	ut_assertok(memcmp(buf, data, size));
+	ut_asserteq(1, sandbox_sf_get_cmd_count(emul, SF_READ_FAST_4B));
+	ut_asserteq(0, sandbox_sf_get_cmd_count(emul, SF_READ_FAST));
+
+	/* Erase and write above 16MiB and check the result */
+	ut_assertok(spi_flash_erase(flash, SZ_16M + SZ_64K, SZ_64K));
+	ut_asserteq(1, sandbox_sf_get_cmd_count(emul, SF_ERASE_64K_4B));
+	ut_assertok(spi_flash_write(flash, SZ_16M + SZ_64K, 0x200, data));
+	ut_asserteq(2, sandbox_sf_get_cmd_count(emul, SF_PAGE_PROGRAM_4B));
+	memset(buf, '\0', size);
+	ut_assertok(spi_flash_read(flash, SZ_16M + SZ_64K, 0x400, buf));
+	ut_assertok(memcmp(buf, data, 0x200));
+	for (i = 0x200; i < 0x400; i++)
+		ut_asserteq(0xff, buf[i]);
+
+	sandbox_sf_unbind_emul(state, 0, 1);
+	state->spi[0][1].spec = NULL;
+	os_unlink(SF_4B_FILE);
+	free(buf);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_4b, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define SF_MMAP_FILE	"/tmp/u-boot-sf-mmap.bin"
+#define SF_READ_SLOW	0x03
+
+/* Probe the flash on bus 0, CS 1 afresh, so that it sees the bus settings */
+static int probe_mmap_flash(struct unit_test_state *uts, struct udevice **devp)
+{
+	struct sandbox_state *state = state_get_current();
+
+	if (*devp) {
+		ut_assertok(device_remove(*devp));
+		ut_assertok(device_unbind(*devp));
+		sandbox_sf_unbind_emul(state, 0, 1);
+	}
+	ut_assertok(spi_flash_probe_bus_cs(0, 1, 0, 0, devp));
+	ut_assertnonnull(state->spi[0][1].emul);
+
+	return 0;
+}
+
+/* Test reads with a read-size limit and through a controller memory map */
+static int dm_test_spi_flash_mmap(struct unit_test_state *uts)
+{
+	struct sandbox_state *state = state_get_current();
+	const uint size = SZ_2M, offset = 0x100, len = 0x4000;
+	struct udevice *bus, *dev = NULL;
+	struct spi_flash *flash;
+	u8 *data, *buf;
+	int fd, i;
+
+	data = malloc(size);
+	buf = malloc(len);
+	ut_assertnonnull(data);
+	ut_assertnonnull(buf);
+	for (i = 0; i < size; i++)
+		data[i] = i ^ (i >> 8) ^ (i >> 16);
+	fd = os_open(SF_MMAP_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(size, os_write(fd, data, size));
+	os_close(fd);
+	ut_assertok(uclass_get_device_by_seq(UCLASS_SPI, 0, &bus));
+	state->spi[0][1].spec = "M25P16:" SF_MMAP_FILE;
+
+	/* A read longer than the controller allows is split up */
+	sandbox_spi_set_max_read_size(bus, 0x1000);
+	ut_assertok(probe_mmap_flash(uts, &dev));
+	flash = dev_get_uclass_priv(dev);
+	ut_asserteq_ptr(NULL, flash->memory_map);
+	ut_assertok(spi_flash_read(flash, offset, len, buf));
+	ut_assertok(memcmp(buf, data + offset, len));
+	ut_asserteq(4, sandbox_sf_get_cmd_count(state->spi[0][1].emul,
+						SF_READ_FAST));
+
+	/* With a map covering the flash, reads are copied from the map */
+	sandbox_spi_set_max_read_size(bus, 0);
+	ut_assertok(sandbox_spi_set_mmap(bus, 1, size));
+	ut_assertok(probe_mmap_flash(uts, &dev));
+	flash = dev_get_uclass_priv(dev);
+	ut_assertnonnull(flash->memory_map);
+	memset(buf, '\0', len);
+	ut_assertok(spi_flash_read(flash, offset, len, buf));
+	ut_assertok(memcmp(buf, data + offset, len));
+	ut_asserteq(0, sandbox_sf_get_cmd_count(state->spi[0][1].emul,
+						SF_READ_FAST));
+	ut_asserteq(1, sandbox_sf_get_cmd_count(state->spi[0][1].emul,
+						SF_READ_SLOW));
+
+	/* The map follows changes to the flash */
+	ut_assertok(spi_flash_erase(flash, 0, SZ_64K));
+	ut_assertok(spi_flash_read(flash, offset, len, buf));
+	for (i = 0; i < len; i++)
+		ut_asserteq(0xff, buf[i]);
+
+	ut_assertok(sandbox_spi_set_mmap(bus, 1, 0));
+	ut_assertok(device_remove(dev));
+	ut_assertok(device_unbind(dev));
+	sandbox_sf_unbind_emul(state, 0, 1);
+	state->spi[0][1].spec = NULL;
+	os_unlink(SF_MMAP_FILE);
+	free(buf);
+	free(data);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_mmap, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define SF_UPDATE_FILE	"/tmp/u-boot-sf-update.bin"
+
+/* Check the number of erase and program commands since the last call */
+static int check_update_counts(struct unit_test_state *uts,
+			       struct udevice *emul, uint *counts, uint erase_4k,
+			       uint erase_64k, uint program)
+{
+	static const uint cmds[] = { SF_ERASE_4K, SF_ERASE_64K,
+		SF_PAGE_PROGRAM };
+	uint expect[] = { erase_4k, erase_64k, program };
+	uint count;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cmds); i++) {
+		count = sandbox_sf_get_cmd_count(emul, cmds[i]);
+		ut_asserteq(expect[i], count - counts[i]);
+		counts[i] = count;
+	}
+
+	return 0;
+}
+
+/* Test that 'sf update' only erases and programs what it needs to */
+static int dm_test_spi_flash_update(struct unit_test_state *uts)
+{
+	struct sandbox_state *state = state_get_current();
+	const uint size = 0x20000;
+	uint counts[3] = { 0 };
+	struct udevice *emul;
+	u8 *data, *buf;
+	int fd, i;
+
+	/* The flash starts off with every bit programmed */
+	os_unlink(SF_UPDATE_FILE);
+	fd = os_open(SF_UPDATE_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(SZ_8M - 1, os_lseek(fd, SZ_8M - 1, OS_SEEK_SET));
+	ut_asserteq(1, os_write(fd, "", 1));
+	os_close(fd);
+
+	state->spi[0][1].spec = "W25Q64CV:" SF_UPDATE_FILE;
+	ut_assertok(run_command("sf probe 0:1", 0));
+	emul = state->spi[0][1].emul;
+	ut_assertnonnull(emul);
+
+	data = map_sysmem(0x1000000, size);
+	buf = map_sysmem(0x1100000, size);
+	for (i = 0; i < size; i++)
+		data[i] = i ^ (i >> 8);
+
+	/* Whole 64KiB blocks are erased at once */
+	ut_assertok(run_command("sf update 1000000 0 20000", 0));
+	ut_assertok(check_update_counts(uts, emul, counts, 0, 2, size / 256));
+
+	/* Nothing is done if the flash already has the data */
+	ut_assertok(run_command("sf update 1000000 0 20000", 0));
+	ut_assertok(check_update_counts(uts, emul, counts, 0, 0, 0));
+
+	/* Clearing bits needs no erase */
+	data[0x1005] = 0;
+	ut_assertok(run_command("sf update 1000000 0 20000", 0));
+	ut_assertok(check_update_counts(uts, emul, counts, 0, 0, 1));
+
+	/* Setting bits erases the 4KiB unit and programs it again */
+	data[0x10] = 0xff;
+	ut_assertok(run_command("sf update 1000000 0 20000", 0));
+	ut_assertok(check_update_counts(uts, emul, counts, 1, 0, 16));
+
+	ut_assertok(run_command("sf read 1100000 0 20000", 0));
+	ut_assertok(memcmp(buf, data, size));
+
+	sandbox_sf_unbind_emul(state, 0, 1);
+	state->spi[0][1].spec = NULL;
+	os_unlink(SF_UPDATE_FILE);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_update, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
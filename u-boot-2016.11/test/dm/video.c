@@ -235,6 +235,169 @@ static int dm_test_video_rotation3(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_rotation3, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that drawing records the area of the display that it changes */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct udevice *dev, *con;
+	struct video_priv *priv;
+	struct video_damage *damage;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	damage = &priv->damage;
+
+	/* The whole display is cleared when it is probed */
+	ut_asserteq(0, damage->xstart);
+	ut_asserteq(0, damage->ystart);
+	ut_asserteq(1366, damage->xend);
+	ut_asserteq(768, damage->yend);
+
+	/*
+	 * video_sync() on sandbox only clears this if 10ms have passed since
+	 * the last one, so clear it directly here
+	 */
+	memset(damage, '\0', sizeof(*damage));
+	vidconsole_putc_xy(con, VID_TO_POS(16), 32, 'a');
+	vidconsole_putc_xy(con, VID_TO_POS(40), 48, 'b');
+	ut_asserteq(16, damage->xstart);
+	ut_asserteq(32, damage->ystart);
+	ut_asserteq(48, damage->xend);
+	ut_asserteq(64, damage->yend);
+	memset(damage, '\0', sizeof(*damage));
+
+	vidconsole_set_row(con, 2, WHITE);
+	ut_asserteq(0, damage->xstart);
+	ut_asserteq(32, damage->ystart);
+	ut_asserteq(1366, damage->xend);
+	ut_asserteq(48, damage->yend);
+	memset(damage, '\0', sizeof(*damage));
+
+	/* Anything off the display is ignored */
+	video_damage(dev, 1360, 760, 100, 100);
+	ut_asserteq(1360, damage->xstart);
+	ut_asserteq(768, damage->yend);
+	memset(damage, '\0', sizeof(*damage));
+	video_damage(dev, -100, 0, 100, 100);
+	ut_asserteq(0, damage->xend);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/**
+ * check_pan_output() - Scroll the console past the end of the frame buffer
+ *
+ * @uts:	Test state
+ * @pan:	true to scroll by panning, false to copy the rows instead
+ * @return 0 on success
+ */
+static int check_pan_output(struct unit_test_state *uts, bool pan)
+{
+	struct udevice *dev, *con;
+	struct video_priv *priv;
+	int i;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	ut_asserteq(768 * 2, priv->fb_lines);
+	if (!pan)
+		priv->fb_lines = priv->ysize;
+
+	/* Fill the display, then scroll by one row */
+	for (i = 0; i < 768 / 16; i++)
+		vidconsole_put_char(con, 'A' + i % 50);
+	vidconsole_put_char(con, '\n');
+	for (i = 0; i < 768 / 16 - 1; i++) {
+		vidconsole_put_char(con, 'A' + i % 50);
+		vidconsole_put_char(con, '\n');
+	}
+	ut_asserteq(pan ? 16 : 0, priv->yoffset);
+	ut_asserteq_ptr(priv->fb_base + priv->yoffset * priv->line_length,
+			priv->fb);
+
+	/* Once there is no room left, go back to the start */
+	for (i = 1; i < 768 / 16; i++) {
+		vidconsole_put_char(con, 'a' + i % 26);
+		vidconsole_put_char(con, '\n');
+	}
+	ut_asserteq(pan ? 768 : 0, priv->yoffset);
+	vidconsole_put_char(con, '\n');
+	ut_asserteq(0, priv->yoffset);
+	ut_asserteq_ptr(priv->fb_base, priv->fb);
+	for (i = 0; i < 30; i++) {
+		vidconsole_put_char(con, '0' + i % 10);
+		vidconsole_put_char(con, '\n');
+	}
+	ut_asserteq(pan ? 30 * 16 : 0, priv->yoffset);
+	ut_asserteq(326, compress_frame_buffer(dev));
+
+	/* Stopping panning moves the same display back to the start */
+	video_stop_pan(dev);
+	ut_asserteq(0, priv->yoffset);
+	ut_asserteq_ptr(priv->fb_base, priv->fb);
+	ut_asserteq(326, compress_frame_buffer(dev));
+	vidconsole_put_char(con, '\n');
+	ut_asserteq(0, priv->yoffset);
+
+	return 0;
+}
+
+/* Test that the console scrolls by panning through the frame buffer */
+static int dm_test_video_pan(struct unit_test_state *uts)
+{
+	ut_assertok(check_pan_output(uts, true));
+
+	return 0;
+}
+DM_TEST(dm_test_video_pan, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test the same output when there is no room to pan */
+static int dm_test_video_pan_none(struct unit_test_state *uts)
+{
+	ut_assertok(check_pan_output(uts, false));
+
+	return 0;
+}
+DM_TEST(dm_test_video_pan_none, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Time text output through the console, with and without panning */
+static int dm_test_video_bench(struct unit_test_state *uts)
+{
+	const char *line = "Criticism may not be agreeable, but it is necessary. It fulfils the same funct\n";
+	struct udevice *dev, *con;
+	struct video_priv *priv;
+	ulong start, msecs[2];
+	int count = 1000;
+	int pan, i, chars;
+	const char *s;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	chars = count * strlen(line);
+	for (pan = 0; pan < 2; pan++) {
+		priv->fb_lines = pan ? priv->ysize * 2 : priv->ysize;
+		start = get_timer(0);
+		for (i = 0; i < count; i++) {
+			for (s = line; *s; s++)
+				ut_assertok(vidconsole_put_char(con, *s));
+		}
+		video_sync(dev);
+		msecs[pan] = max(get_timer(start), 1UL);
+	}
+	printf("%d chars at %dx%d: %lu chars/s copying, %lu chars/s panning\n",
+	       chars, priv->xsize, priv->ysize, chars * 1000UL / msecs[0],
+	       chars * 1000UL / msecs[1]);
+
+	return 0;
+}
+DM_TEST(dm_test_video_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Read a file into memory and return a pointer to it */
 static int read_file(struct unit_test_state *uts, const char *fname,
 		     ulong *addrp)
@@ -0,0 +1,132 @@
+/*
+ * Tests for the environment hash table
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+#define HTAB_TEST_VARS	10000
+
+/* Names with long common prefixes, like the ones boards tend to use */
+static void htab_test_name(char *buf, int i)
+{
+	sprintf(buf, "bootcmd_part%05d_addr_r", i);
+}
+
+/* Import, look up and delete 10k variables, starting from a small table */
+static int env_test_htab_bench(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = { };
+	struct hsearch_stats stats;
+	char name[40], value[16];
+	ulong start, import_ms, find_ms;
+	ENTRY e, *ep;
+	char *buf, *p;
+	int i;
+
+	buf = malloc(HTAB_TEST_VARS * 40);
+	ut_assertnonnull(buf);
+	for (i = 0, p = buf; i < HTAB_TEST_VARS; i++) {
+		htab_test_name(name, i);
+		p += sprintf(p, "%s=%x\n", name, i);
+	}
+
+	start = get_timer(0);
+	ut_asserteq(1, himport_r(&htab, buf, p - buf, '\n', 0, 0, 0, NULL));
+	import_ms = get_timer(start);
+	free(buf);
+
+	hstats_r(&htab, &stats);
+	ut_asserteq(HTAB_TEST_VARS, stats.filled);
+	ut_assert(stats.resizes > 0);
+	ut_assert(stats.filled * 4 <= stats.size * 3);
+
+	start = get_timer(0);
+	for (i = 0; i < HTAB_TEST_VARS; i++) {
+		htab_test_name(name, i);
+		sprintf(value, "%x", i);
+		e.key = name;
+		e.data = NULL;
+		hsearch_r(e, FIND, &ep, &htab, 0);
+		ut_assertnonnull(ep);
+		ut_asserteq_str(value, ep->data);
+	}
+	find_ms = get_timer(start);
+
+	printf("%d vars: import %lu ms, lookup %lu ms, %u slots, %u resizes, probes %u.%02u avg %u max\n",
+	       HTAB_TEST_VARS, import_ms, find_ms, stats.size, stats.resizes,
+	       stats.probes / stats.filled,
+	       stats.probes * 100 / stats.filled % 100, stats.max_probes);
+
+	/* Deleted slots must not hide the entries probed past them */
+	for (i = 0; i < HTAB_TEST_VARS; i += 2) {
+		htab_test_name(name, i);
+		ut_asserteq(1, hdelete_r(name, &htab, 0));
+	}
+	for (i = 0; i < HTAB_TEST_VARS; i++) {
+		htab_test_name(name, i);
+		e.key = name;
+		e.data = NULL;
+		hsearch_r(e, FIND, &ep, &htab, 0);
+		ut_asserteq(i & 1, ep != NULL);
+	}
+
+	hstats_r(&htab, &stats);
+	ut_asserteq(HTAB_TEST_VARS / 2, stats.filled);
+	ut_asserteq(HTAB_TEST_VARS / 2, stats.deleted);
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_htab_bench, 0);
+
+/* Entries keep their data when the table grows underneath them */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = { };
+	struct hsearch_stats stats;
+	char name[40];
+	ENTRY e, *ep;
+	int i;
+
+	ut_asserteq(1, hcreate_r(5, &htab));
+	for (i = 0; i < 100; i++) {
+		htab_test_name(name, i);
+		e.key = name;
+		e.data = name;
+		ut_assert(hsearch_r(e, ENTER, &ep, &htab, 0) > 0);
+		ut_asserteq_str(name, ep->key);
+	}
+
+	hstats_r(&htab, &stats);
+	ut_asserteq(100, stats.filled);
+	ut_assert(stats.resizes >= 4);
+
+	/* Overwriting an existing entry must not add a new one */
+	htab_test_name(name, 42);
+	e.key = name;
+	e.data = "new";
+	ut_assert(hsearch_r(e, ENTER, &ep, &htab, 0) > 0);
+	ut_asserteq_str("new", ep->data);
+	ut_asserteq(100, htab.filled);
+
+	for (i = 0; i < 100; i++) {
+		htab_test_name(name, i);
+		e.key = name;
+		e.data = NULL;
+		hsearch_r(e, FIND, &ep, &htab, 0);
+		ut_assertnonnull(ep);
+		ut_asserteq_str(i == 42 ? "new" : name, ep->data);
+	}
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_htab_grow, 0);
@@ -0,0 +1,215 @@
+/*
+ * Tests for the environment journal
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <environment.h>
+#include <malloc.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+#define JOURNAL_TEST_SIZE	1024
+
+/* Base image and journal area in RAM, behaving like NOR flash or MMC */
+struct journal_test {
+	struct env_journal j;
+	env_t base;
+	u8 area[JOURNAL_TEST_SIZE];
+	int base_writes;
+	ulong bytes;		/* bytes written, base included */
+};
+
+static int journal_test_read(struct env_journal *j, ulong offset, ulong len,
+			     void *buf)
+{
+	struct journal_test *jt = j->priv;
+
+	memcpy(buf, jt->area + offset, len);
+
+	return 0;
+}
+
+static int journal_test_write(struct env_journal *j, ulong offset, ulong len,
+			      const void *buf)
+{
+	struct journal_test *jt = j->priv;
+	const u8 *p = buf;
+	ulong i;
+
+	/* Flash can only clear bits; a block device just overwrites */
+	for (i = 0; i < len; i++) {
+		if (j->erase)
+			jt->area[offset + i] &= p[i];
+		else
+			jt->area[offset + i] = p[i];
+	}
+	jt->bytes += len;
+
+	return 0;
+}
+
+static int journal_test_erase(struct env_journal *j)
+{
+	struct journal_test *jt = j->priv;
+
+	memset(jt->area, 0xff, sizeof(jt->area));
+
+	return 0;
+}
+
+static int journal_test_write_base(struct env_journal *j, env_t *env)
+{
+	struct journal_test *jt = j->priv;
+
+	memcpy(&jt->base, env, sizeof(*env));
+	jt->base_writes++;
+	jt->bytes += sizeof(*env);
+
+	return 0;
+}
+
+static struct journal_test *journal_test_init(bool flash)
+{
+	struct journal_test *jt;
+
+	jt = calloc(1, sizeof(*jt));
+	if (!jt)
+		return NULL;
+	jt->j.size = JOURNAL_TEST_SIZE;
+	jt->j.align = flash ? 16 : 64;
+	jt->j.read = journal_test_read;
+	jt->j.write = journal_test_write;
+	jt->j.erase = flash ? journal_test_erase : NULL;
+	jt->j.write_base = journal_test_write_base;
+	jt->j.priv = jt;
+	memset(jt->area, flash ? 0xff : 0x5a, sizeof(jt->area));
+
+	return jt;
+}
+
+static void journal_test_set(struct hsearch_data *htab, const char *name,
+			     const char *value)
+{
+	ENTRY e, *ep;
+
+	e.key = name;
+	e.data = (char *)value;
+	hsearch_r(e, ENTER, &ep, htab, 0);
+}
+
+/*
+ * Load the environment as a backend does at boot: import the base, then
+ * replay the journal. Check that the result matches @htab.
+ */
+static int journal_test_check(struct unit_test_state *uts,
+			      struct journal_test *jt,
+			      struct hsearch_data *htab, int records)
+{
+	struct hsearch_data loaded = { };
+	char *expect = NULL, *res = NULL;
+	ssize_t len;
+
+	ut_asserteq(jt->base.crc, crc32(0, jt->base.data, ENV_SIZE));
+	ut_asserteq(1, himport_r(&loaded, (char *)jt->base.data, ENV_SIZE,
+				 '\0', 0, 0, 0, NULL));
+	ut_asserteq(records, env_journal_load(&jt->j, &loaded, &jt->base));
+
+	len = hexport_r(htab, '\n', 0, &expect, 0, 0, NULL);
+	ut_assert(len > 0);
+	ut_assert(hexport_r(&loaded, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str(expect, res);
+
+	free(expect);
+	free(res);
+	hdestroy_r(&loaded);
+
+	return 0;
+}
+
+static int journal_test_run(struct unit_test_state *uts, bool flash)
+{
+	static const char vars[] = "bootcmd=run distro_bootcmd\0count=0\0"
+				   "serial#=1234\0state=new\0";
+	struct hsearch_data htab = { };
+	struct journal_test *jt;
+	char value[16];
+	ulong bytes;
+	int i;
+
+	jt = journal_test_init(flash);
+	ut_assertnonnull(jt);
+	ut_asserteq(1, himport_r(&htab, vars, sizeof(vars), '\0', 0, 0, 0,
+				 NULL));
+
+	/* Nothing known about the media, so the first save writes a base */
+	ut_asserteq(0, env_journal_load(&jt->j, &htab, NULL));
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	ut_asserteq(1, jt->base_writes);
+	ut_assertok(journal_test_check(uts, jt, &htab, 0));
+
+	/* Change, add and delete variables; each save appends a record */
+	journal_test_set(&htab, "count", "1");
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	journal_test_set(&htab, "ethact", "eth0");
+	ut_asserteq(1, hdelete_r("state", &htab, 0));
+	bytes = jt->bytes;
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	ut_asserteq(1, jt->base_writes);
+	ut_assert(jt->bytes - bytes < 64 + 32);
+	ut_assertok(journal_test_check(uts, jt, &htab, 2));
+
+	/* Saving without changes writes nothing */
+	bytes = jt->bytes;
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	ut_asserteq(bytes, jt->bytes);
+
+	/* Keep counting until the journal fills and a new base is written */
+	for (i = 2; jt->base_writes == 1; i++) {
+		sprintf(value, "%d", i);
+		journal_test_set(&htab, "count", value);
+		ut_assertok(env_journal_save(&jt->j, &htab));
+		ut_assert(i < 100);
+	}
+	ut_assertok(journal_test_check(uts, jt, &htab, 0));
+	journal_test_set(&htab, "count", "final");
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	ut_assertok(journal_test_check(uts, jt, &htab, 1));
+
+	/* A damaged record ends the replay and forces a new base */
+	for (i = 0; memcmp(jt->area + i, "count=final", 11); i++)
+		ut_assert(i < JOURNAL_TEST_SIZE - 11);
+	jt->area[i + 6] = 'F';
+	ut_asserteq(0, env_journal_load(&jt->j, &htab, &jt->base));
+	ut_assert(!jt->j.saved);
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	ut_asserteq(3, jt->base_writes);
+	ut_assertok(journal_test_check(uts, jt, &htab, 0));
+
+	/* A base written without its journal header ignores the journal */
+	journal_test_set(&htab, "count", "x");
+	ut_assertok(env_journal_save(&jt->j, &htab));
+	jt->base.data[0] = 'B';
+	jt->base.crc = crc32(0, jt->base.data, ENV_SIZE);
+	ut_asserteq(0, env_journal_load(&jt->j, &htab, &jt->base));
+
+	free(jt->j.saved);
+	free(jt);
+	hdestroy_r(&htab);
+
+	return 0;
+}
+
+static int env_test_journal_flash(struct unit_test_state *uts)
+{
+	return journal_test_run(uts, true);
+}
+ENV_TEST(env_test_journal_flash, 0);
+
+static int env_test_journal_blk(struct unit_test_state *uts)
+{
+	return journal_test_run(uts, false);
+}
+ENV_TEST(env_test_journal_blk, 0);
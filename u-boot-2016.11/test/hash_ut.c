@@ -0,0 +1,285 @@
+/*
+ * Tests and throughput figures for the SHA-1, SHA-256 and CRC32 code
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <asm/unaligned.h>
+
+#define BENCH_SIZE	(8 << 20)
+#define BENCH_TIME_US	500000
+
+struct hash_test_algo {
+	const char *name;
+	int digest_size;
+	void (*csum)(const unsigned char *input, unsigned int ilen,
+		     unsigned char *output, unsigned int chunk_sz);
+	int (*progressive)(const unsigned char *input, unsigned int ilen,
+			   unsigned int step, unsigned char *output);
+	/* "abc", the 448-bit message and a million 'a's from FIPS 180-2 */
+	const uint8_t kat[3][SHA256_SUM_LEN];
+	/* fill_buf() data, 1 MiB + 3 bytes at offset 1, before the rewrite */
+	const uint8_t random[SHA256_SUM_LEN];
+};
+
+static int sha1_progressive(const unsigned char *input, unsigned int ilen,
+			    unsigned int step, unsigned char *output)
+{
+	sha1_context ctx;
+	unsigned int len;
+
+	sha1_starts(&ctx);
+	for (; ilen; ilen -= len, input += len) {
+		len = min(ilen, step);
+		sha1_update(&ctx, input, len);
+	}
+	sha1_finish(&ctx, output);
+
+	return 0;
+}
+
+static int sha256_progressive(const unsigned char *input, unsigned int ilen,
+			      unsigned int step, unsigned char *output)
+{
+	sha256_context ctx;
+	unsigned int len;
+
+	sha256_starts(&ctx);
+	for (; ilen; ilen -= len, input += len) {
+		len = min(ilen, step);
+		sha256_update(&ctx, input, len);
+	}
+	sha256_finish(&ctx, output);
+
+	return 0;
+}
+
+static int crc32_progressive(const unsigned char *input, unsigned int ilen,
+			     unsigned int step, unsigned char *output)
+{
+	uint32_t crc = 0;
+	unsigned int len;
+
+	for (; ilen; ilen -= len, input += len) {
+		len = min(ilen, step);
+		crc = crc32(crc, input, len);
+	}
+	put_unaligned_be32(crc, output);
+
+	return 0;
+}
+
+static const struct hash_test_algo algos[] = {
+	{
+		"sha1", SHA1_SUM_LEN, sha1_csum_wd, sha1_progressive,
+		{
+			{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a,
+			  0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+			  0x9c, 0xd0, 0xd8, 0x9d },
+			{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e,
+			  0xba, 0xae, 0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5,
+			  0xe5, 0x46, 0x70, 0xf1 },
+			{ 0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4,
+			  0xf6, 0x1e, 0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31,
+			  0x65, 0x34, 0x01, 0x6f },
+		},
+		{ 0x1f, 0x03, 0xbd, 0xf8, 0x3a, 0x01, 0xfe, 0x57,
+		  0xa6, 0xf3, 0x01, 0x8b, 0xc8, 0xc7, 0x19, 0xda,
+		  0x3d, 0x1b, 0x3e, 0x99 },
+	}, {
+		"sha256", SHA256_SUM_LEN, sha256_csum_wd, sha256_progressive,
+		{
+			{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+			  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+			  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+			  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+			{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+			  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+			  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+			  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+			{ 0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+			  0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+			  0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+			  0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0 },
+		},
+		{ 0x57, 0x62, 0x94, 0x59, 0x4c, 0x35, 0x71, 0xbd,
+		  0x87, 0x0a, 0xf0, 0xe8, 0x6b, 0xd4, 0x7a, 0x70,
+		  0x19, 0xcb, 0x90, 0x8d, 0xd9, 0xcf, 0x40, 0x1d,
+		  0x83, 0xc1, 0x8c, 0x06, 0x41, 0x44, 0x60, 0x28 },
+	}, {
+		"crc32", 4, crc32_wd_buf, crc32_progressive,
+		{
+			{ 0x35, 0x24, 0x41, 0xc2 },
+			{ 0x17, 0x1a, 0x3f, 0x5f },
+			{ 0xdc, 0x25, 0xbf, 0xbc },
+		},
+		{ 0x22, 0xcf, 0xb6, 0xb9 },
+	},
+};
+
+static void fill_buf(uint8_t *buf, unsigned int len)
+{
+	uint32_t seed = 0x12345678;
+
+	while (len--) {
+		seed = seed * 1103515245 + 12345;
+		*buf++ = seed >> 16;
+	}
+}
+
+static void show_digest(const char *what, const uint8_t *digest, int size)
+{
+	int i;
+
+	printf("%s: ", what);
+	for (i = 0; i < size; i++)
+		printf("%02x", digest[i]);
+	printf("\n");
+}
+
+static int check_digest(const struct hash_test_algo *algo, const char *what,
+			const uint8_t *digest, const uint8_t *expect)
+{
+	if (!memcmp(digest, expect, algo->digest_size))
+		return 0;
+
+	printf("%s: %s mismatch\n", algo->name, what);
+	show_digest("expected", expect, algo->digest_size);
+	show_digest("got     ", digest, algo->digest_size);
+
+	return -EINVAL;
+}
+
+static int test_kat(const struct hash_test_algo *algo, uint8_t *buf)
+{
+	static const char *const msg[] = {
+		"abc",
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	};
+	uint8_t digest[SHA256_SUM_LEN];
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(msg); i++) {
+		algo->csum((const unsigned char *)msg[i], strlen(msg[i]),
+			   digest, CHUNKSZ_SHA256);
+		ret |= check_digest(algo, msg[i], digest, algo->kat[i]);
+	}
+
+	memset(buf, 'a', 1000000);
+	algo->progressive(buf, 1000000, 999, digest);
+	ret |= check_digest(algo, "a million 'a's", digest, algo->kat[2]);
+
+	return ret;
+}
+
+/*
+ * Hash the same data from every alignment, in pieces of awkward sizes, and
+ * check that the answer never changes.
+ */
+static int test_consistency(const struct hash_test_algo *algo, uint8_t *buf)
+{
+	static const unsigned int steps[] = { 1, 3, 63, 64, 65, 4095, 65536 };
+	const unsigned int len = (1 << 20) + 3;
+	uint8_t expect[SHA256_SUM_LEN];
+	uint8_t digest[SHA256_SUM_LEN];
+	int ret = 0;
+	int align, i;
+
+	fill_buf(buf + 1, len);
+	algo->csum(buf + 1, len, expect, CHUNKSZ_SHA256);
+	ret |= check_digest(algo, "reference", expect, algo->random);
+
+	for (align = 0; align < 8; align++) {
+		memmove(buf + align, buf + 1, len);
+		for (i = 0; i < ARRAY_SIZE(steps); i++) {
+			algo->progressive(buf + align, len, steps[i], digest);
+			ret |= check_digest(algo, "progressive", digest,
+					    expect);
+		}
+		memmove(buf + 1, buf + align, len);
+	}
+
+	return ret;
+}
+
+/*
+ * The CRC32 code has separate paths for the unaligned head, the bulk and
+ * the tail of a buffer, so compare it with a bit at a time version over
+ * every short length from every alignment.
+ */
+static int test_crc32_sizes(uint8_t *buf)
+{
+	uint32_t crc, expect;
+	int align, len, i, bit;
+
+	fill_buf(buf, 512);
+	for (align = 0; align < 8; align++) {
+		for (len = 0; len < 300; len++) {
+			expect = ~0;
+			for (i = 0; i < len; i++) {
+				expect ^= buf[align + i];
+				for (bit = 0; bit < 8; bit++)
+					expect = (expect >> 1) ^
+						 (expect & 1 ? 0xedb88320 : 0);
+			}
+			expect = ~expect;
+			crc = crc32(0, buf + align, len);
+			if (crc != expect) {
+				printf("crc32: %d bytes at offset %d: expected %08x, got %08x\n",
+				       len, align, expect, crc);
+				return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Report the best of several passes, which is the least disturbed one */
+static void bench(const struct hash_test_algo *algo, uint8_t *buf)
+{
+	uint8_t digest[SHA256_SUM_LEN];
+	ulong start, now, pass, best = ~0UL;
+
+	fill_buf(buf, BENCH_SIZE);
+	start = timer_get_us();
+	do {
+		pass = timer_get_us();
+		algo->csum(buf, BENCH_SIZE, digest, CHUNKSZ_SHA256);
+		now = timer_get_us();
+		best = min(best, max(now - pass, 1UL));
+	} while (now - start < BENCH_TIME_US);
+
+	printf("%s: %lu MB/s\n", algo->name, BENCH_SIZE / best);
+}
+
+int do_ut_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	const struct hash_test_algo *algo;
+	uint8_t *buf;
+	int ret = 0;
+
+	buf = malloc(BENCH_SIZE + 8);
+	if (!buf)
+		return CMD_RET_FAILURE;
+
+	for (algo = algos; algo < algos + ARRAY_SIZE(algos); algo++) {
+		ret |= test_kat(algo, buf);
+		ret |= test_consistency(algo, buf);
+		bench(algo, buf);
+	}
+	ret |= test_crc32_sizes(buf);
+	free(buf);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
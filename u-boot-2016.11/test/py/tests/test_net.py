@@ -167,6 +167,84 @@ def test_net_tftpboot(u_boot_console):
     output = u_boot_console.run_command('crc32 %x $filesize' % addr)
     assert expected_crc in output
 
+@pytest.mark.buildconfigspec('net_tftp_vars')
+def test_net_tftpboot_windowsize(u_boot_console):
+    """Test the tftpboot command with the RFC 7440 windowsize option.
+
+    The same file as in test_net_tftpboot is downloaded with several blocks
+    sent per ACK, and its size and optionally its CRC32 are validated. A
+    server without windowsize support ignores the option, so this also
+    passes in lock-step mode.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console)
+
+    fn = f['fn']
+    u_boot_console.run_command('setenv tftpwindowsize 16')
+    try:
+        output = u_boot_console.run_command('tftpboot %x %s' % (addr, fn))
+    finally:
+        u_boot_console.run_command('setenv tftpwindowsize')
+    expected_text = 'Bytes transferred = '
+    sz = f.get('size', None)
+    if sz:
+        expected_text += '%d' % sz
+    assert expected_text in output
+
+    expected_crc = f.get('crc32', None)
+    if not expected_crc:
+        return
+
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        return
+
+    output = u_boot_console.run_command('crc32 %x $filesize' % addr)
+    assert expected_crc in output
+
+@pytest.mark.buildconfigspec('cmd_net')
+@pytest.mark.buildconfigspec('hash_stream')
+@pytest.mark.buildconfigspec('cmd_crc32')
+def test_net_tftpboot_loadhash(u_boot_console):
+    """Test the tftpboot command with hashing while loading.
+
+    The same file as in test_net_tftpboot is downloaded with its CRC32
+    worked out as the packets arrive, and 'crc32 -l' must report the
+    expected value from that digest.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+
+    expected_crc = f.get('crc32', None)
+    if not expected_crc:
+        pytest.skip('No CRC32 for the TFTP readable file')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console)
+
+    u_boot_console.run_command('setenv loadhash crc32')
+    try:
+        output = u_boot_console.run_command('tftpboot %x %s' % (addr, f['fn']))
+        assert 'Bytes transferred = ' in output
+        output = u_boot_console.run_command('crc32 -l %x $filesize' % addr)
+    finally:
+        u_boot_console.run_command('setenv loadhash')
+    assert expected_crc in output
+
 @pytest.mark.buildconfigspec('cmd_nfs')
 def test_net_nfs(u_boot_console):
     """Test the nfs command.
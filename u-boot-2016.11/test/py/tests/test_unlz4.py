@@ -0,0 +1,50 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test LZ4 decompression on one and on several CPUs (CONFIG_CPU_WORK).
+# Sandbox emulates the secondary CPUs with host threads.
+
+import pytest
+import random
+import zlib
+import u_boot_utils as util
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_unlz4')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.buildconfigspec('cmd_crc32')
+def test_unlz4_cpus(u_boot_console):
+    """Decompress a frame of many 64KiB blocks with 1, 2 and 4 CPUs.
+
+    Every run must produce the original data. The time taken by each is
+    recorded in the log.
+    """
+
+    cons = u_boot_console
+    plain = cons.config.result_dir + '/unlz4.bin'
+    packed = plain + '.lz4'
+
+    # Text-like data which compresses about as well as a kernel
+    rand = random.Random(1)
+    words = [bytes(bytearray(rand.randrange(97, 123)
+                             for i in range(rand.randrange(2, 10))))
+             for j in range(3000)]
+    data = bytearray()
+    while len(data) < (8 << 20) + 12345:
+        data += rand.choice(words) + b' '
+    with open(plain, 'wb') as fd:
+        fd.write(data)
+    expected_crc = '%08x' % (zlib.crc32(bytes(data)) & 0xffffffff)
+    util.run_and_log(cons, ['lz4', '-f', '-q', '-B4', plain, packed])
+
+    ram_base = util.find_ram_base(cons)
+    src = ram_base + (1 << 20)
+    dst = src + (16 << 20)
+    for cpus in (1, 2, 4):
+        cons.run_command('host load hostfs - %x %s' % (src, packed))
+        cons.run_command('setenv workcpus %d' % cpus)
+        output = cons.run_command('time unlz4 %x %x %x' %
+                                  (src, dst, 32 << 20))
+        assert 'Uncompressed size: %d' % len(data) in output
+        output = cons.run_command('crc32 %x $filesize' % dst)
+        assert expected_crc in output
+    cons.run_command('setenv workcpus')
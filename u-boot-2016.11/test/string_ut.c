@@ -0,0 +1,345 @@
+/*
+ * Tests and throughput figures for memcpy, memmove, memset, memcmp and
+ * strlen
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+
+#define TEST_LEN	300
+#define TEST_BUF	(2 * TEST_LEN + 64)
+#define GUARD		0xa5
+#define BENCH_SIZE	(1 << 20)
+#define BENCH_TIME_US	200000
+
+static void fill_buf(uint8_t *buf, unsigned int len)
+{
+	uint32_t seed = 0x12345678;
+
+	while (len--) {
+		seed = seed * 1103515245 + 12345;
+		*buf++ = seed >> 16;
+	}
+}
+
+/*
+ * Check that @len bytes at @off in @buf match @expect and that the
+ * bytes around them still hold GUARD.
+ */
+static int check_area(const char *name, const uint8_t *buf, int off, int len,
+		      const uint8_t *expect, int align, int align2)
+{
+	int i;
+
+	for (i = 0; i < TEST_BUF; i++) {
+		int want = i >= off && i < off + len ? expect[i - off] : GUARD;
+
+		if (buf[i] != want) {
+			printf("%s: %d bytes, alignment %d/%d: byte %d is %02x, expected %02x\n",
+			       name, len, align, align2, i - off, buf[i], want);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int test_memcpy(uint8_t *src, uint8_t *dst)
+{
+	int sa, da, len;
+
+	fill_buf(src, TEST_BUF);
+	for (sa = 0; sa < 8; sa++) {
+		for (da = 0; da < 8; da++) {
+			for (len = 0; len <= TEST_LEN; len++) {
+				memset(dst, GUARD, TEST_BUF);
+				if (memcpy(dst + 8 + da, src + sa, len) !=
+				    dst + 8 + da) {
+					printf("memcpy: wrong return value\n");
+					return -EINVAL;
+				}
+				if (check_area("memcpy", dst, 8 + da, len,
+					       src + sa, sa, da))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Move within one buffer, both ways, and compare with a byte-wise move */
+static int test_memmove(uint8_t *buf, uint8_t *expect)
+{
+	static const int deltas[] = { -65, -17, -8, -7, -1, 1, 3, 8, 9, 64 };
+	uint8_t tmp[TEST_LEN];
+	int sa, i, j, len, src, dst;
+
+	for (sa = 0; sa < 8; sa++) {
+		for (i = 0; i < ARRAY_SIZE(deltas); i++) {
+			for (len = 0; len <= TEST_LEN; len++) {
+				src = 80 + sa;
+				dst = src + deltas[i];
+				fill_buf(buf, TEST_BUF);
+				for (j = 0; j < TEST_BUF; j++)
+					expect[j] = buf[j];
+				for (j = 0; j < len; j++)
+					tmp[j] = buf[src + j];
+				for (j = 0; j < len; j++)
+					expect[dst + j] = tmp[j];
+
+				if (memmove(buf + dst, buf + src, len) !=
+				    buf + dst) {
+					printf("memmove: wrong return value\n");
+					return -EINVAL;
+				}
+				for (j = 0; j < TEST_BUF; j++) {
+					if (buf[j] != expect[j]) {
+						printf("memmove: %d bytes, alignment %d, by %d: byte %d wrong\n",
+						       len, sa, deltas[i], j);
+						return -EINVAL;
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_memset(uint8_t *buf, uint8_t *expect)
+{
+	static const int values[] = { 0, 0x5a, 0x1ff };
+	int da, i, len;
+
+	for (i = 0; i < ARRAY_SIZE(values); i++) {
+		memset(expect, 0, TEST_BUF);
+		for (len = 0; len < TEST_BUF; len++)
+			expect[len] = values[i];
+		for (da = 0; da < 8; da++) {
+			for (len = 0; len <= TEST_LEN; len++) {
+				memset(buf, GUARD, TEST_BUF);
+				if (memset(buf + 8 + da, values[i], len) !=
+				    buf + 8 + da) {
+					printf("memset: wrong return value\n");
+					return -EINVAL;
+				}
+				if (check_area("memset", buf, 8 + da, len,
+					       expect, da, values[i]))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* A large area of zeroes, which may be cleared a cache line at a time */
+static int test_memset_large(uint8_t *buf)
+{
+	const int len = 64 << 10;
+	int da, i;
+
+	for (da = 0; da < 8; da++) {
+		memset(buf, GUARD, len + 64);
+		memset(buf + 8 + da, 0, len);
+		for (i = 0; i < len + 64; i++) {
+			if (buf[i] != (i >= 8 + da && i < 8 + da + len ?
+				       0 : GUARD)) {
+				printf("memset: %d bytes at %d: byte %d wrong\n",
+				       len, da, i);
+				return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int ref_memcmp(const uint8_t *a, const uint8_t *b, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (a[i] != b[i])
+			return a[i] - b[i];
+	}
+
+	return 0;
+}
+
+static int test_memcmp(uint8_t *a, uint8_t *b)
+{
+	int aa, ba, len, pos, expect, ret;
+
+	fill_buf(a, TEST_BUF);
+	for (aa = 0; aa < 8; aa++) {
+		for (ba = 0; ba < 8; ba++) {
+			for (len = 0; len <= TEST_LEN; len++) {
+				memcpy(b + ba, a + aa, len);
+				/* equal, then a difference at a few places */
+				for (pos = -1; pos < len; pos += 1 + len / 4) {
+					if (pos >= 0)
+						b[ba + pos] += 1 + pos;
+					expect = ref_memcmp(a + aa, b + ba,
+							    len);
+					ret = memcmp(a + aa, b + ba, len);
+					if (ret != expect) {
+						printf("memcmp: %d bytes, alignment %d/%d, difference at %d: got %d, expected %d\n",
+						       len, aa, ba, pos, ret,
+						       expect);
+						return -EINVAL;
+					}
+					if (pos >= 0)
+						b[ba + pos] = a[aa + pos];
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_strlen(uint8_t *buf)
+{
+	int sa, len, ret;
+
+	for (sa = 0; sa < 8; sa++) {
+		for (len = 0; len <= TEST_LEN; len++) {
+			/* bytes which look nearly like a terminator */
+			memset(buf, 0x80, TEST_BUF);
+			memset(buf + sa, 0x01, len);
+			if (len)
+				buf[sa + len - 1] = 0xff;
+			buf[sa + len] = '\0';
+			buf[sa + len + 1] = '\0';
+			ret = strlen((char *)buf + sa);
+			if (ret != len) {
+				printf("strlen: %d bytes at alignment %d: got %d\n",
+				       len, sa, ret);
+				return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Count CPU cycles where there is a cheap way: sandbox on an x86 host can
+ * read the time-stamp counter. Returns 0 otherwise.
+ */
+static u64 bench_cycles(void)
+{
+#if defined(CONFIG_SANDBOX) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+enum bench_op {
+	BENCH_MEMCPY,
+	BENCH_MEMCPY_UNALIGNED,
+	BENCH_MEMMOVE,
+	BENCH_MEMSET,
+	BENCH_MEMSET_ZERO,
+	BENCH_MEMCMP,
+	BENCH_STRLEN,
+};
+
+static const char *const bench_names[] = {
+	"memcpy", "memcpy (src+1)", "memmove (overlap)", "memset",
+	"memset (zero)", "memcmp", "strlen",
+};
+
+static void bench_once(enum bench_op op, uint8_t *a, uint8_t *b)
+{
+	switch (op) {
+	case BENCH_MEMCPY:
+		memcpy(a, b, BENCH_SIZE);
+		break;
+	case BENCH_MEMCPY_UNALIGNED:
+		memcpy(a, b + 1, BENCH_SIZE);
+		break;
+	case BENCH_MEMMOVE:
+		memmove(a + 8, a, BENCH_SIZE);
+		break;
+	case BENCH_MEMSET:
+		memset(a, 0x5a, BENCH_SIZE);
+		break;
+	case BENCH_MEMSET_ZERO:
+		memset(a, 0, BENCH_SIZE);
+		break;
+	case BENCH_MEMCMP:
+		if (memcmp(a, b, BENCH_SIZE))
+			printf("memcmp: buffers differ\n");
+		break;
+	case BENCH_STRLEN:
+		if (strlen((char *)a) != BENCH_SIZE)
+			printf("strlen: wrong length\n");
+		break;
+	}
+}
+
+/* Report the best of several passes, which is the least disturbed one */
+static void bench(enum bench_op op, uint8_t *a, uint8_t *b)
+{
+	ulong start, now, pass, best = ~0UL;
+	u64 cycles, best_cycles = ~0ULL;
+
+	memset(a, 0x01, BENCH_SIZE + 16);
+	memset(b, 0x01, BENCH_SIZE + 16);
+	a[BENCH_SIZE] = '\0';
+	start = timer_get_us();
+	do {
+		pass = timer_get_us();
+		cycles = bench_cycles();
+		bench_once(op, a, b);
+		cycles = bench_cycles() - cycles;
+		now = timer_get_us();
+		best = min(best, max(now - pass, 1UL));
+		best_cycles = min(best_cycles, max(cycles, 1ULL));
+	} while (now - start < BENCH_TIME_US);
+
+	printf("%-18s %6lu MB/s", bench_names[op], BENCH_SIZE / best);
+	if (bench_cycles())
+		printf(", %llu.%02llu bytes/cycle",
+		       BENCH_SIZE / best_cycles,
+		       BENCH_SIZE * 100ULL / best_cycles % 100);
+	printf("\n");
+}
+
+int do_ut_string(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	uint8_t *a, *b;
+	int op, ret = 0;
+
+	a = malloc(BENCH_SIZE + 16);
+	b = malloc(BENCH_SIZE + 16);
+	if (!a || !b) {
+		free(a);
+		free(b);
+		return CMD_RET_FAILURE;
+	}
+
+	ret |= test_memcpy(a, b);
+	ret |= test_memmove(a, b);
+	ret |= test_memset(a, b);
+	ret |= test_memset_large(a);
+	ret |= test_memcmp(a, b);
+	ret |= test_strlen(a);
+
+	for (op = BENCH_MEMCPY; op <= BENCH_STRLEN; op++)
+		bench(op, a, b);
+	free(a);
+	free(b);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}